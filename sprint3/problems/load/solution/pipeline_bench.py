@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# Нагрузка конвейерными (pipelined) запросами: каждое соединение отправляет пачку
+# запросов одной записью и читает ответы, проверяя их порядок: тело каждого ответа
+# сравнивается с ответом на ту же цель, полученным заранее без конвейера.
+import argparse
+import socket
+import threading
+import time
+
+
+def read_response(sock, buffer):
+    while b'\r\n\r\n' not in buffer:
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError('connection closed')
+        buffer += chunk
+    head, buffer = buffer.split(b'\r\n\r\n', 1)
+    length = 0
+    for line in head.split(b'\r\n')[1:]:
+        name, _, value = line.partition(b':')
+        if name.strip().lower() == b'content-length':
+            length = int(value)
+    while len(buffer) < length:
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError('connection closed')
+        buffer += chunk
+    return head.split(b'\r\n', 1)[0], buffer[:length], buffer[length:]
+
+
+def fetch_expected(args, targets):
+    expected = {}
+    with socket.create_connection((args.host, args.port)) as sock:
+        buffer = b''
+        for target in dict.fromkeys(targets):
+            sock.sendall(f'GET {target} HTTP/1.1\r\nHost: {args.host}\r\n\r\n'.encode())
+            _, body, buffer = read_response(sock, buffer)
+            expected[target] = body
+    return expected
+
+
+def worker(args, targets, expected, stats, lock):
+    batch = b''.join(
+        f'GET {target} HTTP/1.1\r\nHost: {args.host}\r\n\r\n'.encode()
+        for target in targets)
+    done = 0
+    errors = 0
+    reordered = 0
+    with socket.create_connection((args.host, args.port)) as sock:
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        buffer = b''
+        deadline = time.monotonic() + args.duration
+        while time.monotonic() < deadline:
+            sock.sendall(batch)
+            for target in targets:
+                status, body, buffer = read_response(sock, buffer)
+                done += 1
+                if b' 200 ' not in status:
+                    errors += 1
+                elif body != expected[target]:
+                    reordered += 1
+    with lock:
+        stats['requests'] += done
+        stats['errors'] += errors
+        stats['reordered'] += reordered
+
+
+def main():
+    parser = argparse.ArgumentParser(description='HTTP pipelining benchmark')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--connections', type=int, default=16)
+    parser.add_argument('--depth', type=int, default=16, help='запросов в одной пачке')
+    parser.add_argument('--duration', type=float, default=10.0, help='секунд')
+    parser.add_argument('--ammo', default='ammo_keepalive.txt')
+    args = parser.parse_args()
+
+    with open(args.ammo) as ammo:
+        uris = [line.strip() for line in ammo if line.startswith('/')]
+    targets = [uris[i % len(uris)] for i in range(args.depth)]
+
+    expected = fetch_expected(args, targets)
+    stats = {'requests': 0, 'errors': 0, 'reordered': 0}
+    lock = threading.Lock()
+    threads = [threading.Thread(target=worker, args=(args, targets, expected, stats, lock))
+               for _ in range(args.connections)]
+    start = time.monotonic()
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    elapsed = time.monotonic() - start
+
+    print(f'requests: {stats["requests"]}, errors: {stats["errors"]}, '
+          f'out of order: {stats["reordered"]}, '
+          f'rps: {stats["requests"] / elapsed:.0f}')
+
+
+if __name__ == '__main__':
+    main()
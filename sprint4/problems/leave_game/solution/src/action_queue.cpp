@@ -0,0 +1,84 @@
+#include "action_queue.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace model {
+
+namespace {
+
+size_t RoundCapacity(size_t capacity) {
+    return std::bit_ceil(std::max<size_t>(capacity, 2));
+}
+
+}  // namespace
+
+ActionQueue::ActionQueue(size_t capacity)
+    : cells_(std::make_unique<Cell[]>(RoundCapacity(capacity)))
+    , mask_(RoundCapacity(capacity) - 1) {
+    for (size_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool ActionQueue::TryPush(PlayerAction action) {
+    if (!TryReserve()) {
+        return false;
+    }
+    PushReserved(action);
+    return true;
+}
+
+bool ActionQueue::TryReserve() {
+    size_t reserved = reserved_.load(std::memory_order_relaxed);
+    do {
+        if (reserved > mask_) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!reserved_.compare_exchange_weak(reserved, reserved + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed));
+    return true;
+}
+
+void ActionQueue::CancelReservation() noexcept {
+    reserved_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ActionQueue::PushReserved(PlayerAction action) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;) {
+        cell = &cells_[pos & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else {
+            // ячейку занял другой писатель или освобождение ещё не видно этому потоку:
+            // мест не больше, чем ячеек, поэтому ячейка для занятого места найдётся
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->action = action;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    // счётчик растёт после публикации команды: его изменение означает, что в очереди появилось новое
+    pushed_.fetch_add(1, std::memory_order_release);
+
+    const size_t depth = GetDepth();
+    size_t max_depth = max_depth_.load(std::memory_order_relaxed);
+    while ((depth > max_depth) && !max_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {
+    }
+}
+
+size_t ActionQueue::GetDepth() const noexcept {
+    const size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+    const size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+}  // namespace model
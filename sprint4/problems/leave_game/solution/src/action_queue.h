@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace model {
+
+// Команда игрока, ожидающая начала следующего тика. Направление хранится у самого игрока,
+// поэтому повторные команды одного игрока до тика не занимают новых записей
+struct PlayerAction {
+    unsigned player_id{};
+};
+
+/*
+ *  Ограниченная очередь команд сессии: пишут потоки обработки запросов, читает strand сессии.
+ *  Кольцевой буфер с номером поколения в каждой ячейке (схема Д. Вьюкова), без блокировок.
+ */
+class ActionQueue {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 8192;
+
+    // Ёмкость округляется вверх до степени двойки
+    explicit ActionQueue(size_t capacity = DEFAULT_CAPACITY);
+    ActionQueue(const ActionQueue&) = delete;
+    ActionQueue& operator=(const ActionQueue&) = delete;
+
+    // Возвращает false, если очередь заполнена
+    bool TryPush(PlayerAction action);
+
+    // Место, занятое TryReserve, освобождается одним из двух вызовов: PushReserved его заполняет
+    // и уже не может не найти свободной ячейки, CancelReservation возвращает его очереди
+    bool TryReserve();
+    void PushReserved(PlayerAction action);
+    void CancelReservation() noexcept;
+
+    // Извлекает все опубликованные команды. Вызывается только одним потребителем
+    template <typename Fn>
+    size_t Drain(Fn&& fn) {
+        size_t count = 0;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            const PlayerAction action = cell.action;
+            cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+            ++pos;
+            ++count;
+            fn(action);
+        }
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+        if (count > 0) {
+            // места освобождаются после ячеек, так что занявший место писатель найдёт свободную ячейку
+            reserved_.fetch_sub(count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    size_t GetCapacity() const noexcept { return mask_ + 1; }
+    // Метрики читаются из любого потока и могут немного отставать
+    size_t GetDepth() const noexcept;
+    size_t GetMaxDepth() const noexcept { return max_depth_.load(std::memory_order_relaxed); }
+    std::uint64_t GetPushedCount() const noexcept { return pushed_.load(std::memory_order_acquire); }
+    std::uint64_t GetRejectedCount() const noexcept { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        PlayerAction action;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+
+    // позиции писателей и читателя разнесены по разным строкам кэша
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    // занятые места: записи в очереди и ещё не записанные после TryReserve
+    alignas(64) std::atomic<size_t> reserved_{0};
+
+    alignas(64) std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::atomic<size_t> max_depth_{0};
+};
+
+}  // namespace model
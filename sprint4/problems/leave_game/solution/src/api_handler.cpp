@@ -1,20 +1,11 @@
 #include "api_handler.h"
 #include "game_session.h"
-#include <set>
-#include <boost/url.hpp>
+#include "binary_serializer.h"
+#include <charconv>
 #include "utility_functions.h"
 
-using namespace boost::urls;
-
 namespace http_handler {
 
-const std::string game_endpoint = "/api/v1/game/join";
-const std::string players_endpoint = "/api/v1/game/players";
-const std::string state_endpoint = "/api/v1/game/state";
-const std::string action_endpoint = "/api/v1/game/player/action";
-const std::string tick_endpoint = "/api/v1/game/tick";
-const std::string records_endpoint = "/api/v1/game/records";
-
 const std::map<std::string, std::string> onlyPostMethodAllowedResp
 { {"code", "invalidMethod"},{"message", "Only POST method is expected"}};
 
@@ -39,6 +30,15 @@ const std::map<std::string, std::string> authHeaderRequiredResp
 const std::map<std::string, std::string> invalidEndpointResp
 { {"code", "badRequest"}, {"message", "Invalid endpoint"}};
 
+const std::map<std::string, std::string> tooManyActionsResp
+{ {"code", "tooManyRequests"}, {"message", "Too many pending actions"}};
+
+const std::map<std::string, std::string> upgradeRequiredResp
+{ {"code", "upgradeRequired"}, {"message", "WebSocket upgrade is required"}};
+
+const std::map<std::string, std::string> invalidSinceTickResp
+{ {"code", "invalidArgument"}, {"message", "Invalid sinceTick parameter"}};
+
 const std::map<std::string, std::string> failedToParseTickResp
 { {"code", "invalidArgument"}, {"message", "Failed to parse tick request JSON"}};
 
@@ -81,194 +81,193 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
     return response;
  }
 
+SharedStringResponse MakeSharedStringResponse(http::status status, std::shared_ptr<const std::string> body, unsigned http_version,
+											  bool keep_alive, std::string_view content_type,
+											  const std::initializer_list< std::pair<http::field, std::string_view> > & addition_headers){
 
-bool ApiHandler::IsApiRequest(const std::string& request){
-	std::string np_request = GetRequestStringWithoutParameters(request);
-	std::set<std::string> api_endpoints {game_endpoint, players_endpoint,  state_endpoint,
-										 action_endpoint, tick_endpoint, records_endpoint};
+    SharedStringResponse response(status, http_version);
+    response.set(http::field::content_type, content_type);
 
-	return api_endpoints.find(np_request) != api_endpoints.end();
-}
+    for(auto it = addition_headers.begin(); it != addition_headers.end(); ++it){
+    	response.set(it->first, it->second);
+	}
 
-std::map<std::string, std::string> GetRequestParameters(const std::string& request){
-	url_view u(request);
-	std::map<std::string, std::string> result;
+    response.body() = std::move(body);
+    response.prepare_payload();
+    response.keep_alive(keep_alive);
+
+    return response;
+ }
 
-	for (auto param: u.params()){
-	    result[param.key] = param.value;
-	}
 
-	return result;
+model::SnapshotFormat GetSnapshotFormat(std::string_view accept){
+	return accept.find(binary_serializer::CONTENT_TYPE) == std::string_view::npos ? model::SnapshotFormat::JSON
+																			   : model::SnapshotFormat::BINARY;
 }
 
-StringResponse ApiHandler::HandleApiRequest(const std::string& request, http::verb method, std::string_view auth_type, const std::string& body, unsigned http_version, bool keep_alive){
-	StringResponse resp;
-	std::string np_request = GetRequestStringWithoutParameters(request);
-	auto it_handler = resp_map_.find(np_request);
+std::string_view GetContentType(model::SnapshotFormat format){
+	return format == model::SnapshotFormat::BINARY ? ContentType::GAME_STATE : ContentType::APPLICATION_JSON;
+}
 
-	if(it_handler != resp_map_.end()){
-		auto parameters = GetRequestParameters(request);
-		return it_handler->second(method, auth_type, body, http_version, keep_alive, parameters);
+void ApiHandler::HandleApiRequest(ApiRoute route, std::string_view target, http::verb method, std::string_view auth_type,
+								  std::string_view accept, std::string&& body, unsigned http_version, bool keep_alive,
+								  ResponseSender send){
+	switch(route){
+		case ApiRoute::JOIN:
+			return HandleJoinGameRequest(method, auth_type, body, http_version, keep_alive, std::move(send));
+		// Чтение отдаёт готовый снимок сессии и не ждёт её strand
+		case ApiRoute::PLAYERS:
+			return HandleGetPlayersRequest(method, auth_type, GetSnapshotFormat(accept), http_version, keep_alive, std::move(send));
+		case ApiRoute::STATE:
+			return HandleGetGameState(method, target, auth_type, GetSnapshotFormat(accept), http_version, keep_alive, std::move(send));
+		// Изменения состояния выполняются на strand сессии игрока
+		case ApiRoute::ACTION:
+			return HandlePlayerAction(method, auth_type, body, http_version, keep_alive, std::move(send));
+		case ApiRoute::TICK:
+			return HandleTickAction(method, auth_type, body, http_version, keep_alive, std::move(send));
+		// параметры ссылаются на цель запроса, поэтому обрабатываются сразу
+		case ApiRoute::RECORDS:
+			return send(HandleGetRecordsAction(method, auth_type, body, http_version, keep_alive, QueryParams(target)));
+		// Запрос на подписку без заголовков WebSocket
+		case ApiRoute::STREAM:
+			return send(HandleStreamRequest(method, target, auth_type, http_version, keep_alive));
 	}
-	return resp;
+	send(StringResponse{});
 }
 
-void ApiHandler::InitApiRequestHandlers(){
-	auto join_game_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-									unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				 {
-			 	 	 return HandleJoinGameRequest(method, auth_type, body, http_version, keep_alive, params);
-				 };
-
-	auto get_players_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-									  unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				 {
-			 	 	 return HandleGetPlayersRequest(method, auth_type, body, http_version, keep_alive, params);
-				 };
-
-	auto get_state_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-									unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				 {
-			 	 	 return HandleGetGameState(method, auth_type, body, http_version, keep_alive, params);
-				 };
-
-	auto action_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-								 unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				 {
-			 	 	  return HandlePlayerAction(method, auth_type, body, http_version, keep_alive, params);
-				 };
-
-	auto tick_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-							   unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				{
-			 	  	return  HandleTickAction(method, auth_type, body, http_version, keep_alive, params);
-				};
-
-	auto records_handler = [this](http::verb method, std::string_view auth_type, const std::string& body,
-								  unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params) -> StringResponse
-				{
-			 	  	return HandleGetRecordsAction(method, auth_type, body, http_version, keep_alive, params);
-				};
-
-	resp_map_[game_endpoint] = join_game_handler;
-	resp_map_[players_endpoint] = get_players_handler;
-	resp_map_[state_endpoint] = get_state_handler;
-	resp_map_[action_endpoint] = action_handler;
-	resp_map_[tick_endpoint] = tick_handler;
-	resp_map_[records_endpoint] = records_handler;
+void ApiHandler::RunInSession(const std::shared_ptr<model::GameSession>& session, std::function<void()> fn){
+	if(session->HasStrand()){
+		net::dispatch(session->GetStrand(), std::move(fn));
+	}else{
+		fn();
+	}
 }
 
-StringResponse ApiHandler::HandleJoinGameRequest(http::verb method, std::string_view auth_type, const std::string& body,
-												 unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params){
-	StringResponse resp;
-
+void ApiHandler::HandleJoinGameRequest(http::verb method, std::string_view auth_type, const std::string& body,
+									   unsigned http_version, bool keep_alive, ResponseSender send){
 	if(method == http::verb::post){
-		resp = HandleAuthRequest(body, http_version, keep_alive);
-	}else{
-    	if(method == http::verb::head){
-    		resp = MakeStringResponse(http::status::method_not_allowed,""sv,
-    								  http_version, keep_alive,
-									  ContentType::APPLICATION_JSON,
-									  {{http::field::cache_control, "no-cache"sv},
-									   {http::field::allow, HeaderType::ALLOW_POST}});
-    	}else{
-    		resp = MakeStringResponse(http::status::method_not_allowed,
-		    					       json_serializer::MakeMappedResponce(onlyPostMethodAllowedResp),
-									   http_version, keep_alive, ContentType::APPLICATION_JSON,
-									   {{http::field::cache_control, "no-cache"sv},
-									    {http::field::allow, HeaderType::ALLOW_POST}});
-    	}
+		return HandleAuthRequest(body, http_version, keep_alive, std::move(send));
 	}
-	return resp;
+
+	StringResponse resp;
+   	if(method == http::verb::head){
+   		resp = MakeStringResponse(http::status::method_not_allowed,""sv,
+   								  http_version, keep_alive,
+								  ContentType::APPLICATION_JSON,
+								  {{http::field::cache_control, "no-cache"sv},
+								   {http::field::allow, HeaderType::ALLOW_POST}});
+   	}else{
+   		resp = MakeStringResponse(http::status::method_not_allowed,
+	    					       json_serializer::MakeMappedResponce(onlyPostMethodAllowedResp),
+								   http_version, keep_alive, ContentType::APPLICATION_JSON,
+								   {{http::field::cache_control, "no-cache"sv},
+								    {http::field::allow, HeaderType::ALLOW_POST}});
+   	}
+	send(std::move(resp));
 }
 
-StringResponse ApiHandler::HandleAuthRequest(const std::string& body, unsigned http_version, bool keep_alive){
+void ApiHandler::HandleAuthRequest(const std::string& body, unsigned http_version, bool keep_alive, ResponseSender send){
 	std::map<std::string, std::string> respMap;
 
 	try{
 		respMap = json_loader::ParseJoinGameRequest(body);
 	}catch(std::exception& e){
-		auto resp = MakeStringResponse(http::status::bad_request,
-									json_serializer::MakeMappedResponce(joinGameReqParseError),
-									http_version, keep_alive, ContentType::APPLICATION_JSON,
-									{{http::field::cache_control, "no-cache"sv}});
-		return resp;
+		return send(MakeStringResponse(http::status::bad_request,
+									   json_serializer::MakeMappedResponce(joinGameReqParseError),
+									   http_version, keep_alive, ContentType::APPLICATION_JSON,
+									   {{http::field::cache_control, "no-cache"sv}}));
 	}
 
+	std::shared_ptr<model::GameSession> session;
 	try{
-		auto [token, playerId] = game_.AddPlayer(respMap["mapId"], respMap["userName"]);
+		session = game_.AcquireSession(respMap["mapId"], respMap["userName"]);
+	}catch(MapNotFoundException& e){
+		cout << e.what() << std::endl;
+		return send(MakeStringResponse(http::status::not_found,
+									   json_serializer::MakeMapNotFoundResponce(),
+									   http_version, keep_alive,
+									   ContentType::APPLICATION_JSON,
+									   {{http::field::cache_control, "no-cache"sv}}));
+	}
+	catch(EmptyNameException& e){
+		return send(MakeStringResponse(http::status::bad_request,
+									   json_serializer::MakeMappedResponce(invalidNameResp),
+									   http_version, keep_alive, ContentType::APPLICATION_JSON,
+									   {{http::field::cache_control, "no-cache"sv}}));
+	}
+
+	RunInSession(session, [this, session, name = respMap["userName"], http_version, keep_alive, send]{
+		auto [token, playerId] = game_.AddPlayer(session, name);
 
 		auto player =  game_.GetPlayerWithAuthToken(token);
 		player->GetDog()->SpawnDogInMap(game_.GetSpawnInRandomPoint());
 
-		auto resp = MakeStringResponse(http::status::ok,
-									json_serializer::MakeAuthResponce(token, playerId), http_version,
-									keep_alive, ContentType::APPLICATION_JSON,
-									{{http::field::cache_control, "no-cache"sv}});
+		send(MakeStringResponse(http::status::ok,
+								json_serializer::MakeAuthResponce(token, playerId), http_version,
+								keep_alive, ContentType::APPLICATION_JSON,
+								{{http::field::cache_control, "no-cache"sv}}));
 
-		if(ticker_ && !ticker_->HasStarted()){
+		if(ticker_){
 			ticker_->Start();
 		}
-		return resp;
-
-	}catch(MapNotFoundException& e){
-		cout << e.what() << std::endl;
-		auto resp = MakeStringResponse(http::status::not_found,
-										json_serializer::MakeMapNotFoundResponce(),
-										http_version, keep_alive,
-										ContentType::APPLICATION_JSON,
-										{{http::field::cache_control, "no-cache"sv}});
-		return resp;
-	}
-	catch(EmptyNameException& e){
-		auto resp = MakeStringResponse(http::status::bad_request,
-										json_serializer::MakeMappedResponce(invalidNameResp),
-										http_version, keep_alive, ContentType::APPLICATION_JSON,
-										{{http::field::cache_control, "no-cache"sv}});
-		return resp;
-	}
+	});
 }
 
-StringResponse ApiHandler::HandleGetPlayersRequest(http::verb method, std::string_view auth_type,
-												  const std::string& body, unsigned http_version, bool keep_alive,
-												  const std::map<std::string, std::string>& params){
+void ApiHandler::HandleGetPlayersRequest(http::verb method, std::string_view auth_type, model::SnapshotFormat format,
+										 unsigned http_version, bool keep_alive, ResponseSender send){
    if((method != http::verb::get) && (method != http::verb::head)){
-		return  MakeStringResponse(http::status::method_not_allowed,
+		return send(MakeStringResponse(http::status::method_not_allowed,
 									json_serializer::MakeMappedResponce(invaliMethodResp),
 									http_version, keep_alive, ContentType::APPLICATION_JSON,
 									{{http::field::cache_control, "no-cache"sv},
-									{http::field::allow, HeaderType::ALLOW_HEADERS}});
+									{http::field::allow, HeaderType::ALLOW_HEADERS}}));
 
     }
 
 	std::string auth_token = GetAuthToken(auth_type);
 
 	if(auth_token.empty()){
-		return MakeStringResponse(http::status::unauthorized,
+		return send(MakeStringResponse(http::status::unauthorized,
 	  	   					      json_serializer::MakeMappedResponce(authHeaderMissingResp),
 								  http_version, keep_alive, ContentType::APPLICATION_JSON,
-								  {{http::field::cache_control, "no-cache"sv}});
+								  {{http::field::cache_control, "no-cache"sv}}));
 
 	}
 
-	if(!game_.HasSessionWithAuthInfo(auth_token)){
-		return MakeStringResponse(http::status::unauthorized,
+	auto handle = game_.FindPlayerByToken(auth_token);
+	if(!handle){
+		return send(MakeStringResponse(http::status::unauthorized,
 							      json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
 								  http_version, keep_alive, ContentType::APPLICATION_JSON,
-								  {{http::field::cache_control, "no-cache"sv}});
+								  {{http::field::cache_control, "no-cache"sv}}));
 	}
 
-	auto players =  game_.FindAllPlayersForAuthInfo(auth_token);
-	StringResponse resp;
+	if(method == http::verb::head){
+		return send(MakeStringResponse(http::status::ok, "", http_version, keep_alive,
+									   GetContentType(format), {{http::field::cache_control, "no-cache"sv}}));
+	}
 
-	if(method == http::verb::get){
-		resp = MakeStringResponse(http::status::ok, json_serializer::GetPlayerInfoResponce(players), http_version, keep_alive,
-								  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-	}else{
-		resp = MakeStringResponse(http::status::ok, "", http_version, keep_alive,
-								  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+	auto send_players = [format, http_version, keep_alive, send](std::shared_ptr<const std::string> players){
+		send(MakeSharedStringResponse(http::status::ok, std::move(players), http_version, keep_alive,
+									  GetContentType(format), {{http::field::cache_control, "no-cache"sv}, {http::field::vary, "Accept"sv}}));
+	};
+
+	if(auto players = handle->session->GetCachedPlayers(format)){
+		return send_players(std::move(players));
 	}
-	return resp;
+
+	// Снимка ещё нет: он строится один раз на strand сессии, где список игроков не меняется
+	RunInSession(handle->session, [session = handle->session, format, send_players = std::move(send_players)]{
+		auto players = session->GetCachedPlayers(format);
+		if(!players){
+			const auto& session_players = session->GetPlayers();
+			players = std::make_shared<const std::string>(format == model::SnapshotFormat::BINARY
+														  ? binary_serializer::GetPlayerInfoResponce(session_players)
+														  : json_serializer::GetPlayerInfoResponce(session_players));
+			session->SetCachedPlayers(players, format);
+		}
+		send_players(std::move(players));
+	});
 }
 
 bool IsValidAuthToken(const std::string& token, size_t valid_size){
@@ -284,156 +283,217 @@ bool IsValidAuthToken(const std::string& token, size_t valid_size){
 	 return true;
 }
 
-StringResponse ApiHandler::HandleGetGameState(http::verb method, std::string_view auth_type, const std::string& body,
-											  unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params){
+void ApiHandler::HandleGetGameState(http::verb method, std::string_view target, std::string_view auth_type,
+									model::SnapshotFormat format, unsigned http_version, bool keep_alive, ResponseSender send){
 
 	if((method != http::verb::get) && (method != http::verb::head)){
-		auto resp = MakeStringResponse(http::status::method_not_allowed,
+		return send(MakeStringResponse(http::status::method_not_allowed,
 	    					json_serializer::MakeMappedResponce(invaliMethodResp),
 							http_version, keep_alive, ContentType::APPLICATION_JSON,
 							{{http::field::cache_control, "no-cache"sv},
-							 {http::field::allow, HeaderType::ALLOW_HEADERS}});
-		return resp;
+							 {http::field::allow, HeaderType::ALLOW_HEADERS}}));
+	}
+
+	// С параметром sinceTick клиент получает только изменения после этого тика
+	std::optional<std::uint64_t> since_tick;
+	if(auto param = QueryParams(target).Find("sinceTick"sv)){
+		std::uint64_t value = 0;
+		const auto [ptr, ec] = std::from_chars(param->data(), param->data() + param->size(), value);
+		if((ec != std::errc{}) || (ptr != param->data() + param->size())){
+			return send(MakeStringResponse(http::status::bad_request,
+										   json_serializer::MakeMappedResponce(invalidSinceTickResp),
+										   http_version, keep_alive, ContentType::APPLICATION_JSON,
+										   {{http::field::cache_control, "no-cache"sv}}));
+		}
+		since_tick = value;
 	}
 
 	std::string auth_token = GetAuthToken(auth_type);
+	auto handle = auth_token.empty() ? std::nullopt : game_.FindPlayerByToken(auth_token);
 
-	if(auth_token.empty() || !game_.HasSessionWithAuthInfo(auth_token)){
-		StringResponse resp;
+	if(!handle){
 		if(auth_token.empty() || !IsValidAuthToken(auth_token, 32)){
-			return MakeStringResponse(http::status::unauthorized,
+			return send(MakeStringResponse(http::status::unauthorized,
 	 		    					  json_serializer::MakeMappedResponce(authHeaderMissingResp),
   									  http_version, keep_alive, ContentType::APPLICATION_JSON,
-									  {{http::field::cache_control, "no-cache"sv}});
+									  {{http::field::cache_control, "no-cache"sv}}));
 		}
 
-		return MakeStringResponse(http::status::unauthorized,
+		return send(MakeStringResponse(http::status::unauthorized,
 		    				      json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
 		      					  http_version, keep_alive, ContentType::APPLICATION_JSON,
-								  {{http::field::cache_control, "no-cache"sv}});
+								  {{http::field::cache_control, "no-cache"sv}}));
    }
 
-  if(method == http::verb::get){
-	  auto players =  game_.FindAllPlayersForAuthInfo(auth_token);
-	  auto loots = game_.GetLootsForAuthInfo(auth_token);
-	  auto resp = MakeStringResponse(http::status::ok, json_serializer::GetPlayersDogInfoResponce(players, loots),
-			  	  	  	  	  	  	 http_version, keep_alive, ContentType::APPLICATION_JSON,
-									 {{http::field::cache_control, "no-cache"sv}});
-	  return resp;
-  }else{
-	  auto resp = MakeStringResponse(http::status::ok, "", http_version, keep_alive,
-			  	  	  	  	  	  	 ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-	  return resp;
+  if(method == http::verb::head){
+	  return send(MakeStringResponse(http::status::ok, "", http_version, keep_alive,
+			  	  	  	  	  	  	 GetContentType(format), {{http::field::cache_control, "no-cache"sv}}));
+  }
+
+  auto send_state = [format, http_version, keep_alive, send](std::shared_ptr<const std::string> state){
+	  send(MakeSharedStringResponse(http::status::ok, std::move(state),
+			  	  	  	  	  	  	http_version, keep_alive, GetContentType(format),
+									{{http::field::cache_control, "no-cache"sv}, {http::field::vary, "Accept"sv}}));
+  };
+
+  // Разница своя для каждой базы и строится на strand сессии, где состояние не меняется
+  if(since_tick){
+	  return RunInSession(handle->session, [this, session = handle->session, since = *since_tick, format, send_state = std::move(send_state)]{
+		  // с таймером тиков команды применяются только в начале следующего тика
+		  if(!ticker_){
+			  game_.ApplyPendingActions(session);
+		  }
+		  const auto delta = session->GetChangesSince(since);
+		  send_state(std::make_shared<const std::string>(format == model::SnapshotFormat::BINARY
+				  	  	  	  	  	  	  	  	  	  	 ? binary_serializer::GetStateDeltaResponce(delta)
+														 : json_serializer::GetStateDeltaResponce(delta)));
+	  });
+  }
+
+  // Состояние сериализуется один раз после изменения сессии, и снимок отдаётся всем запросам без захода в strand
+  if(auto state = handle->session->GetCachedState(format)){
+	  return send_state(std::move(state));
   }
+
+  RunInSession(handle->session, [this, session = handle->session, format, send_state = std::move(send_state)]{
+	  send_state(GetStateSnapshot(game_, session, format, !ticker_));
+  });
 }
 
-StringResponse ApiHandler::HandlePlayerAction(http::verb method, std::string_view auth_type,
-											  const std::string& body, unsigned http_version,
-											  bool keep_alive, const std::map<std::string, std::string>& params){
+void ApiHandler::HandlePlayerAction(http::verb method, std::string_view auth_type,
+									const std::string& body, unsigned http_version,
+									bool keep_alive, ResponseSender send){
 	if(method != http::verb::post){
-		auto resp = MakeStringResponse(http::status::method_not_allowed,
+		return send(MakeStringResponse(http::status::method_not_allowed,
 	    							   json_serializer::MakeMappedResponce(invaliMethodResp),
 								       http_version, keep_alive, ContentType::APPLICATION_JSON,
-									   {{http::field::cache_control, "no-cache"sv}});
-
-		return resp;
+									   {{http::field::cache_control, "no-cache"sv}}));
 	}
 
 	std::string auth_token = GetAuthToken(auth_type);
 
 	if(auth_token.empty()){
-		auto resp = MakeStringResponse(http::status::unauthorized,
+		return send(MakeStringResponse(http::status::unauthorized,
 				    				   json_serializer::MakeMappedResponce(authHeaderRequiredResp),
   									   http_version, keep_alive, ContentType::APPLICATION_JSON,
-									   {{http::field::cache_control, "no-cache"sv}});
+									   {{http::field::cache_control, "no-cache"sv}}));
+   }
 
-		return resp;
-   }else
-		if(!game_.HasSessionWithAuthInfo(auth_token))
+	auto handle = game_.FindPlayerByToken(auth_token);
+		if(!handle)
 		{
-			auto resp = MakeStringResponse(http::status::unauthorized,
+			return send(MakeStringResponse(http::status::unauthorized,
     				    					json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
       									    http_version, keep_alive, ContentType::APPLICATION_JSON,
-											{{http::field::cache_control, "no-cache"sv}});
-
-    		return resp;
+											{{http::field::cache_control, "no-cache"sv}}));
 		}
 
-	auto session =  game_.GetSessionWithAuthInfo(auth_token);
-	auto map = game_.FindMap(model::Map::Id(session->GetMap()));
-	auto map_speed = map->GetDogSpeed();
-	auto player =  game_.GetPlayerWithAuthToken(auth_token);
-
+	// Команда применяется в начале следующего тика, запрос не ждёт strand сессии
 	DogDirection dir =  json_loader::GetMoveDirection(body);
-	player->GetDog()->SetSpeed(dir, map_speed > 0.0 ? map_speed : game_.GetDefaultDogSpeed());
+	if(!handle->session->EnqueueAction(*handle->player, dir)){
+		return send(MakeStringResponse(http::status::too_many_requests,
+									   json_serializer::MakeMappedResponce(tooManyActionsResp),
+									   http_version, keep_alive, ContentType::APPLICATION_JSON,
+									   {{http::field::cache_control, "no-cache"sv}, {http::field::retry_after, "1"sv}}));
+	}
 
-	auto resp = MakeStringResponse(http::status::ok, "{}", http_version, keep_alive, ContentType::APPLICATION_JSON,
-								   {{http::field::cache_control, "no-cache"sv}});
-	return resp;
+	send(MakeStringResponse(http::status::ok, "{}", http_version, keep_alive, ContentType::APPLICATION_JSON,
+							{{http::field::cache_control, "no-cache"sv}}));
 }
 
-StringResponse ApiHandler::HandleTickAction(http::verb method, std::string_view auth_type,
-											const std::string& body, unsigned http_version,
-											bool keep_alive, const std::map<std::string, std::string>& params){
-	 StringResponse resp;
-
+void ApiHandler::HandleTickAction(http::verb method, std::string_view auth_type,
+								  const std::string& body, unsigned http_version,
+								  bool keep_alive, ResponseSender send){
 	 if(method != http::verb::post){
-		 resp = MakeStringResponse(http::status::method_not_allowed,
-	  	    			           json_serializer::MakeMappedResponce(invaliMethodResp),
-                                   http_version, keep_alive, ContentType::APPLICATION_JSON,
-								   {{http::field::cache_control, "no-cache"sv}});
-
-		 return resp;
+		 return send(MakeStringResponse(http::status::method_not_allowed,
+	  	    			                json_serializer::MakeMappedResponce(invaliMethodResp),
+                                        http_version, keep_alive, ContentType::APPLICATION_JSON,
+								        {{http::field::cache_control, "no-cache"sv}}));
 	 }
 
 	 if(ticker_){
-		 resp = MakeStringResponse(http::status::bad_request,
-	  		  					  json_serializer::MakeMappedResponce(invalidEndpointResp),
-	  		   					  http_version, keep_alive, ContentType::APPLICATION_JSON,
-								  {{http::field::cache_control, "no-cache"sv}});
-	 }else{
-		 try{
-	  			int deltaTime = json_loader::ParseDeltaTimeRequest(body);
-
-	  			game_.GenerateLoot(deltaTime);
-	  			game_.MoveDogs(deltaTime);
-	  			game_.SaveSessions(deltaTime);
-	  			game_.HandleRetiredPlayers();
-	  			resp = MakeStringResponse(http::status::ok, "{}", http_version, keep_alive,
-	  									  ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-
-	  		}catch(BadDeltaTimeException& ex){
-	  			resp = MakeStringResponse(http::status::bad_request,
-	  									  json_serializer::MakeMappedResponce(failedToParseTickResp),
-	   									  http_version, keep_alive, ContentType::APPLICATION_JSON,
-										  {{http::field::cache_control, "no-cache"sv}});
-	  		}
+		 return send(MakeStringResponse(http::status::bad_request,
+	  		  					        json_serializer::MakeMappedResponce(invalidEndpointResp),
+	  		   					        http_version, keep_alive, ContentType::APPLICATION_JSON,
+								        {{http::field::cache_control, "no-cache"sv}}));
 	 }
 
-	 return resp;
+	 int deltaTime = 0;
+	 try{
+		 deltaTime = json_loader::ParseDeltaTimeRequest(body);
+	 }catch(BadDeltaTimeException& ex){
+		 return send(MakeStringResponse(http::status::bad_request,
+	  								    json_serializer::MakeMappedResponce(failedToParseTickResp),
+	   								    http_version, keep_alive, ContentType::APPLICATION_JSON,
+									    {{http::field::cache_control, "no-cache"sv}}));
+	 }
+
+	 // Тики из параллельных запросов запускаются по очереди на strand-е, как у Ticker.
+	 // Ответ отправляется после того, как тик завершится во всех сессиях
+	 net::dispatch(strand_, [this, deltaTime, http_version, keep_alive, send]{
+		 game_.TickSessions(deltaTime, [this, http_version, keep_alive, send](std::shared_ptr<model::TickResult> result){
+			 net::dispatch(strand_, [this, result, http_version, keep_alive, send]{
+				 game_.FinishTick(*result);
+				 send(MakeStringResponse(http::status::ok, "{}", http_version, keep_alive,
+						 	 	 	 	 ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}}));
+			 });
+		 });
+	 });
 }
 
-std::pair<int, int> ParseParameters(const std::map<std::string, std::string>& params){
-	 int start = 0;
-	 int max_items = MAX_DB_RECORDS;
+std::optional<model::PlayerHandle> ApiHandler::FindStreamPlayer(std::string_view target, std::string_view auth_type) const {
+	std::string auth_token = GetAuthToken(auth_type);
+	// браузер не может передать заголовок при открытии WebSocket
+	if(auth_token.empty()){
+		if(auto token = QueryParams(target).Find("token"sv)){
+			auth_token = *token;
+		}
+	}
+	return auth_token.empty() ? std::nullopt : game_.FindPlayerByToken(auth_token);
+}
 
-	 try{
-		 auto it  = params.find("start");
-		 if(it != params.end())
-			 start = std::stoi(it->second);
+StringResponse ApiHandler::HandleStreamRequest(http::verb method, std::string_view target, std::string_view auth_type,
+											   unsigned http_version, bool keep_alive) const {
+	if(method != http::verb::get){
+		return MakeStringResponse(http::status::method_not_allowed,
+								  json_serializer::MakeMappedResponce(invaliMethodResp),
+								  http_version, keep_alive, ContentType::APPLICATION_JSON,
+								  {{http::field::cache_control, "no-cache"sv}, {http::field::allow, "GET"sv}});
+	}
 
-		 it  = params.find("maxItems");
-		 if(it != params.end())
-	 	 	 max_items = std::stoi(it->second);
+	if(!FindStreamPlayer(target, auth_type)){
+		return MakeStringResponse(http::status::unauthorized,
+								  json_serializer::MakeMappedResponce(playerTokenNotFoundResp),
+								  http_version, keep_alive, ContentType::APPLICATION_JSON,
+								  {{http::field::cache_control, "no-cache"sv}});
+	}
+
+	return MakeStringResponse(http::status::upgrade_required,
+							  json_serializer::MakeMappedResponce(upgradeRequiredResp),
+							  http_version, keep_alive, ContentType::APPLICATION_JSON,
+							  {{http::field::cache_control, "no-cache"sv}, {http::field::upgrade, "websocket"sv}});
+}
+
+// Некорректное значение параметра оставляет значение по умолчанию
+void ParseIntParameter(const QueryParams& params, std::string_view key, int& value){
+	 if(auto param = params.Find(key)){
+		 std::from_chars(param->data(), param->data() + param->size(), value);
+	 }
+}
+
+std::pair<int, int> ParseParameters(const QueryParams& params){
+	 int start = 0;
+	 int max_items = MAX_DB_RECORDS;
 
-	 }catch(std::exception& ex){}
+	 ParseIntParameter(params, "start"sv, start);
+	 ParseIntParameter(params, "maxItems"sv, max_items);
 
 	 return {start, max_items};
 }
 
 StringResponse ApiHandler::HandleGetRecordsAction(http::verb method, std::string_view auth_type,
 												  const std::string& body, unsigned http_version,
-												  bool keep_alive, const std::map<std::string, std::string>& params){
+												  bool keep_alive, const QueryParams& params){
 	 StringResponse resp;
 
 	 if((method != http::verb::get) && (method != http::verb::head)){
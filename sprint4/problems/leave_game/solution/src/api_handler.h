@@ -1,5 +1,6 @@
 #pragma once
 #include "http_server.h"
+#include "shared_string_body.h"
 #include "model.h"
 #include "json_serializer.h"
 #include "json_loader.h"
@@ -7,6 +8,8 @@
 #include "server_exceptions.h"
 #include <boost/asio/io_context.hpp>
 #include "ticker.h"
+#include "api_routes.h"
+#include "game_stream.h"
 
 namespace net = boost::asio;
 
@@ -19,12 +22,23 @@ namespace sys = boost::system;
 using namespace std::literals;
 
 using StringResponse = http::response<http::string_body>;
+using SharedStringResponse = http::response<http_server::SharedStringBody>;
 using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
 
+// Ответ может быть отправлен из strand игровой сессии, а не из потока запроса
+struct ResponseSender {
+    std::function<void(StringResponse&&)> send_string;
+    std::function<void(SharedStringResponse&&)> send_shared;
+
+    void operator()(StringResponse&& response) const { send_string(std::move(response)); }
+    void operator()(SharedStringResponse&& response) const { send_shared(std::move(response)); }
+};
+
 struct ContentType {
     ContentType() = delete;
     constexpr static std::string_view APPLICATION_JSON = "application/json"sv;
     constexpr static std::string_view TEXT_PLAIN = "text/plain"sv;
+    constexpr static std::string_view GAME_STATE = "application/x-game-state"sv;
 };
 
 struct HeaderType {
@@ -37,19 +51,28 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
                                   bool keep_alive, std::string_view content_type = ContentType::APPLICATION_JSON,
                                   const std::initializer_list< std::pair<http::field, std::string_view> >& addition_headers = {});
 
+SharedStringResponse MakeSharedStringResponse(http::status status, std::shared_ptr<const std::string> body, unsigned http_version,
+                                              bool keep_alive, std::string_view content_type = ContentType::APPLICATION_JSON,
+                                              const std::initializer_list< std::pair<http::field, std::string_view> >& addition_headers = {});
+
 ////////////////////////
 class ApiHandler{
 public:
-     explicit ApiHandler(model::Game& game, Strand& strand):game_{game}, strand_{strand}{
-        InitApiRequestHandlers();
+     explicit ApiHandler(model::Game& game, Strand& strand):game_{game}, strand_{strand}, streams_{game}{
+        // Состояние сессии сериализуется после тика один раз для всех WebSocket-подписчиков
+        game_.SetSessionTickListener([this](const std::shared_ptr<model::GameSession>& session){
+        	streams_.OnSessionTick(session);
+        });
         if(game_.GetTickPeriod() > 0){
         	ticker_ = std::make_shared<Ticker>(strand_, std::chrono::milliseconds(game_.GetTickPeriod()),
-        								   [this](std::chrono::milliseconds ticks)
+        								   [this](std::chrono::milliseconds ticks, std::function<void()> done)
 										   {
-        										game_.GenerateLoot(ticks.count());
-        										game_.MoveDogs(ticks.count());
-        										game_.SaveSessions(ticks.count());
-        										game_.HandleRetiredPlayers();
+        										game_.TickSessions(ticks.count(), [this, done](std::shared_ptr<model::TickResult> result){
+        											net::dispatch(strand_, [this, result, done]{
+        												game_.FinishTick(*result);
+        												done();
+        											});
+        										});
 										   });
         }
     }
@@ -57,31 +80,39 @@ public:
     ApiHandler(const ApiHandler&) = delete;
     ApiHandler& operator=(const ApiHandler&) = delete;
     
-    bool IsApiRequest(const std::string& request);
-    StringResponse HandleApiRequest(const std::string& request, http::verb method, std::string_view auth_type,
-    								const std::string& body, unsigned http_version, bool keep_alive);
+    // target - цель запроса вместе с параметрами, маршрут уже найден через FindApiRoute.
+    // accept выбирает формат состояния и списка игроков: JSON или двоичный application/x-game-state
+    void HandleApiRequest(ApiRoute route, std::string_view target, http::verb method, std::string_view auth_type,
+    					  std::string_view accept, std::string&& body, unsigned http_version, bool keep_alive,
+    					  ResponseSender send);
+
+    // Игрок, подписывающийся на состояние: токен берётся из заголовка Authorization или параметра token
+    std::optional<model::PlayerHandle> FindStreamPlayer(std::string_view target, std::string_view auth_type) const;
+    GameStreamHub& GetStreams() { return streams_;}
 
 private:
-    void InitApiRequestHandlers();
-    StringResponse HandleJoinGameRequest(http::verb method, std::string_view auth_type,
-    									 const std::string& body, unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
-    StringResponse HandleAuthRequest(const std::string& body, unsigned http_version, bool keep_alive);
-    StringResponse HandleGetPlayersRequest(http::verb method, std::string_view auth_type, const std::string& body,
-    									   unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
-    StringResponse HandleGetGameState(http::verb method, std::string_view auth_type, const std::string& body,
-    								  unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
-    StringResponse HandlePlayerAction(http::verb method, std::string_view auth_type, const std::string& body,
-    								  unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
-    StringResponse HandleTickAction(http::verb method, std::string_view auth_type, const std::string& body,
-    								unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
+    void RunInSession(const std::shared_ptr<model::GameSession>& session, std::function<void()> fn);
+
+    void HandleJoinGameRequest(http::verb method, std::string_view auth_type,
+    						   const std::string& body, unsigned http_version, bool keep_alive, ResponseSender send);
+    void HandleAuthRequest(const std::string& body, unsigned http_version, bool keep_alive, ResponseSender send);
+    void HandleGetPlayersRequest(http::verb method, std::string_view auth_type, model::SnapshotFormat format,
+    							 unsigned http_version, bool keep_alive, ResponseSender send);
+    void HandleGetGameState(http::verb method, std::string_view target, std::string_view auth_type,
+    						model::SnapshotFormat format, unsigned http_version, bool keep_alive, ResponseSender send);
+    void HandlePlayerAction(http::verb method, std::string_view auth_type, const std::string& body,
+    						unsigned http_version, bool keep_alive, ResponseSender send);
+    void HandleTickAction(http::verb method, std::string_view auth_type, const std::string& body,
+    					  unsigned http_version, bool keep_alive, ResponseSender send);
 
+    StringResponse HandleStreamRequest(http::verb method, std::string_view target, std::string_view auth_type,
+    								   unsigned http_version, bool keep_alive) const;
     StringResponse HandleGetRecordsAction(http::verb method, std::string_view auth_type, const std::string& body,
-    								unsigned http_version, bool keep_alive, const std::map<std::string, std::string>& params);
+    								unsigned http_version, bool keep_alive, const QueryParams& params);
                                     
     model::Game& game_;
-    std::map<std::string,
-			std::function<StringResponse(http::verb, std::string_view, const std::string&, unsigned, bool, const std::map<std::string, std::string>&)>> resp_map_;
     std::shared_ptr<Ticker> ticker_;
     Strand& strand_;
+    GameStreamHub streams_;
 };    
 }  // namespace http_handler
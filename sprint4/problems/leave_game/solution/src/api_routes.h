@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace http_handler {
+
+using namespace std::literals;
+
+enum class ApiRoute {
+    JOIN,
+    PLAYERS,
+    STATE,
+    ACTION,
+    TICK,
+    RECORDS,
+    STREAM
+};
+
+struct RouteEntry {
+    std::string_view path;
+    ApiRoute route;
+};
+
+// Таблица маршрутов игрового API: сопоставление идёт по string_view без копирования цели запроса
+inline constexpr std::array<RouteEntry, 7> API_ROUTES{{
+    {"/api/v1/game/join"sv, ApiRoute::JOIN},
+    {"/api/v1/game/players"sv, ApiRoute::PLAYERS},
+    {"/api/v1/game/state"sv, ApiRoute::STATE},
+    {"/api/v1/game/player/action"sv, ApiRoute::ACTION},
+    {"/api/v1/game/tick"sv, ApiRoute::TICK},
+    {"/api/v1/game/records"sv, ApiRoute::RECORDS},
+    {"/api/v1/game/stream"sv, ApiRoute::STREAM},
+}};
+
+// Путь запроса без строки параметров
+constexpr std::string_view GetTargetPath(std::string_view target) {
+    return target.substr(0, target.find('?'));
+}
+
+constexpr std::optional<ApiRoute> FindApiRoute(std::string_view target) {
+    const std::string_view path = GetTargetPath(target);
+    for (const auto& entry : API_ROUTES) {
+        if (entry.path == path) {
+            return entry.route;
+        }
+    }
+    return std::nullopt;
+}
+
+static_assert(FindApiRoute("/api/v1/game/records?start=0&maxItems=10"sv) == ApiRoute::RECORDS);
+static_assert(FindApiRoute("/api/v1/game/stream?token=0123"sv) == ApiRoute::STREAM);
+static_assert(!FindApiRoute("/api/v1/game/stat"sv));
+
+/*
+ *  Параметры строки запроса: пары ключ-значение ссылаются на цель запроса и действительны, пока жив запрос.
+ *  Значения не декодируются, параметров сверх MAX_PARAMS не бывает у игрового API, и они отбрасываются.
+ */
+class QueryParams {
+public:
+    static constexpr size_t MAX_PARAMS = 8;
+
+    constexpr QueryParams() = default;
+
+    constexpr explicit QueryParams(std::string_view target) {
+        const auto query_pos = target.find('?');
+        if (query_pos == std::string_view::npos) {
+            return;
+        }
+
+        std::string_view query = target.substr(query_pos + 1);
+        while (!query.empty() && (size_ < MAX_PARAMS)) {
+            const auto amp_pos = query.find('&');
+            const std::string_view param = query.substr(0, amp_pos);
+            query = (amp_pos == std::string_view::npos) ? std::string_view{} : query.substr(amp_pos + 1);
+            if (param.empty()) {
+                continue;
+            }
+
+            const auto eq_pos = param.find('=');
+            if (eq_pos == std::string_view::npos) {
+                params_[size_++] = {param, {}};
+            } else {
+                params_[size_++] = {param.substr(0, eq_pos), param.substr(eq_pos + 1)};
+            }
+        }
+    }
+
+    constexpr std::optional<std::string_view> Find(std::string_view key) const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (params_[i].first == key) {
+                return params_[i].second;
+            }
+        }
+        return std::nullopt;
+    }
+
+    constexpr size_t GetSize() const noexcept { return size_; }
+
+private:
+    std::array<std::pair<std::string_view, std::string_view>, MAX_PARAMS> params_{};
+    size_t size_{0};
+};
+
+static_assert(QueryParams("/records?start=5&maxItems=10"sv).Find("maxItems"sv) == "10"sv);
+
+}  // namespace http_handler
@@ -0,0 +1,106 @@
+#include "binary_serializer.h"
+#include "binary_writer.h"
+#include "game_session.h"
+
+namespace binary_serializer {
+
+namespace {
+
+// фиксированная часть записи собаки: координаты, скорость, направление и очки
+constexpr size_t DOG_FIXED_SIZE = 4 * sizeof(float) + 1 + sizeof(std::int32_t);
+constexpr size_t LOOT_RECORD_SIZE = 2 * sizeof(float) + 4;
+
+void WriteHeader(BinaryWriter& writer, MessageType type){
+	writer.U8('G').U8('S').U8(FORMAT_VERSION).U8(static_cast<std::uint8_t>(type));
+}
+
+void WriteDog(BinaryWriter& writer, model::Player& player){
+	auto dog = player.GetDog();
+	const auto pos = dog->GetPosition();
+	const auto speed = dog->GetSpeed();
+
+	writer.Varint(player.GetId())
+		  .F32(static_cast<float>(pos.x)).F32(static_cast<float>(pos.y))
+		  .F32(static_cast<float>(speed.vx)).F32(static_cast<float>(speed.vy))
+		  .U8(static_cast<std::uint8_t>(dog->GetDirection()))
+		  .I32(dog->GetScore());
+
+	const auto& bag = dog->GetGatheredLoot();
+	writer.Varint(bag.size());
+	for(const auto& item : bag){
+		writer.Varint(item.id).Varint(item.type);
+	}
+}
+
+void WriteLoot(BinaryWriter& writer, const model::LootInfo& loot){
+	writer.Varint(loot.id).Varint(loot.type).F32(static_cast<float>(loot.x)).F32(static_cast<float>(loot.y));
+}
+
+void WriteIds(BinaryWriter& writer, const std::vector<unsigned>& ids){
+	writer.Varint(ids.size());
+	for(unsigned id : ids){
+		writer.Varint(id);
+	}
+}
+
+}  // namespace
+
+std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players_info){
+	std::string out;
+	BinaryWriter writer(out);
+
+	WriteHeader(writer, MessageType::PLAYERS);
+	writer.Varint(players_info.size());
+	for(const auto& player : players_info){
+		writer.Varint(player->GetId()).Bytes(player->GetName());
+	}
+	return out;
+}
+
+void WritePlayersDogInfo(std::string& out, const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots){
+	BinaryWriter writer(out);
+
+	WriteHeader(writer, MessageType::STATE);
+	writer.Varint(players.size());
+	for(const auto& player : players){
+		WriteDog(writer, *player);
+	}
+
+	writer.Varint(loots.size());
+	for(const auto& loot : loots){
+		WriteLoot(writer, loot);
+	}
+}
+
+std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots){
+	std::string out;
+	// одно выделение памяти под весь ответ, если рюкзаки не слишком полные
+	out.reserve(HEADER_SIZE + 20 + players.size() * (DOG_FIXED_SIZE + 16) + loots.size() * LOOT_RECORD_SIZE);
+	WritePlayersDogInfo(out, players, loots);
+	return out;
+}
+
+std::string GetStateDeltaResponce(const model::StateDelta& delta){
+	std::string out;
+	out.reserve(HEADER_SIZE + 32 + delta.players.size() * (DOG_FIXED_SIZE + 16) + delta.loots.size() * LOOT_RECORD_SIZE);
+	BinaryWriter writer(out);
+
+	WriteHeader(writer, MessageType::STATE_DELTA);
+	writer.Varint(delta.tick).U8(delta.full ? 1 : 0);
+
+	writer.Varint(delta.players.size());
+	for(model::Player* player : delta.players){
+		WriteDog(writer, *player);
+	}
+
+	writer.Varint(delta.loots.size());
+	for(const model::LootInfo* loot : delta.loots){
+		WriteLoot(writer, *loot);
+	}
+
+	WriteIds(writer, delta.removed_players);
+	WriteIds(writer, delta.removed_loots);
+	return out;
+}
+
+}  // namespace binary_serializer
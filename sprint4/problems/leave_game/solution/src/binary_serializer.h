@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "model.h"
+
+namespace model
+{
+	class Player;
+	struct StateDelta;
+}
+
+/*
+ *  Двоичное представление ответов игрового API (Accept: application/x-game-state).
+ *
+ *  Заголовок: 'G' 'S', версия формата (u8), тип сообщения (u8).
+ *  Целые фиксированной ширины и float32 - little-endian, id и длины - varint.
+ *
+ *  STATE:       varint число собак, собаки; varint число трофеев, трофеи
+ *  собака:      varint id игрока, f32 x, f32 y, f32 vx, f32 vy, u8 направление, i32 очки,
+ *               varint число предметов в рюкзаке, для каждого varint id, varint тип
+ *  трофей:      varint id, varint тип, f32 x, f32 y
+ *  PLAYERS:     varint число игроков, для каждого varint id, varint длина имени, имя в UTF-8
+ *  STATE_DELTA: varint тик, u8 признак полного состояния, собаки и трофеи как в STATE,
+ *               varint число ушедших игроков и их id, varint число собранных трофеев и их id
+ */
+namespace binary_serializer {
+
+using namespace std::literals;
+
+constexpr std::string_view CONTENT_TYPE = "application/x-game-state"sv;
+constexpr std::uint8_t FORMAT_VERSION = 1;
+constexpr size_t HEADER_SIZE = 4;
+
+enum class MessageType : std::uint8_t {
+	STATE = 1,
+	PLAYERS = 2,
+	STATE_DELTA = 3
+};
+
+std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players_info);
+std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots);
+// Дописывает состояние игроков и трофеев в out, позволяя переиспользовать буфер
+void WritePlayersDogInfo(std::string& out, const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots);
+std::string GetStateDeltaResponce(const model::StateDelta& delta);
+
+}  // namespace binary_serializer
@@ -0,0 +1,119 @@
+#include "binary_writer.h"
+
+#include <bit>
+#include <stdexcept>
+
+namespace binary_serializer {
+
+namespace {
+
+// varint 64-битного числа занимает не больше 10 байт
+constexpr int MAX_VARINT_BYTES = 10;
+
+template <typename T>
+void AppendLittleEndian(std::string& out, T value){
+    for(size_t i = 0; i < sizeof(T); ++i){
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+}  // namespace
+
+BinaryWriter& BinaryWriter::U8(std::uint8_t value){
+    out_.push_back(static_cast<char>(value));
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::U32(std::uint32_t value){
+    AppendLittleEndian(out_, value);
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::U64(std::uint64_t value){
+    AppendLittleEndian(out_, value);
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::F32(float value){
+    return U32(std::bit_cast<std::uint32_t>(value));
+}
+
+BinaryWriter& BinaryWriter::F64(double value){
+    return U64(std::bit_cast<std::uint64_t>(value));
+}
+
+BinaryWriter& BinaryWriter::Varint(std::uint64_t value){
+    while(value >= 0x80){
+        out_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+    return *this;
+}
+
+BinaryWriter& BinaryWriter::Bytes(std::string_view bytes){
+    Varint(bytes.size());
+    out_.append(bytes);
+    return *this;
+}
+
+std::string_view BinaryReader::Raw(size_t size){
+    if(size > GetRemaining()){
+        throw std::out_of_range("Binary data is truncated");
+    }
+    const std::string_view result = in_.substr(pos_, size);
+    pos_ += size;
+    return result;
+}
+
+std::uint8_t BinaryReader::U8(){
+    return static_cast<std::uint8_t>(Raw(1)[0]);
+}
+
+std::uint32_t BinaryReader::U32(){
+    const std::string_view bytes = Raw(sizeof(std::uint32_t));
+    std::uint32_t value = 0;
+    for(size_t i = 0; i < bytes.size(); ++i){
+        value |= std::uint32_t{static_cast<std::uint8_t>(bytes[i])} << (i * 8);
+    }
+    return value;
+}
+
+std::uint64_t BinaryReader::U64(){
+    const std::string_view bytes = Raw(sizeof(std::uint64_t));
+    std::uint64_t value = 0;
+    for(size_t i = 0; i < bytes.size(); ++i){
+        value |= std::uint64_t{static_cast<std::uint8_t>(bytes[i])} << (i * 8);
+    }
+    return value;
+}
+
+float BinaryReader::F32(){
+    return std::bit_cast<float>(U32());
+}
+
+double BinaryReader::F64(){
+    return std::bit_cast<double>(U64());
+}
+
+std::uint64_t BinaryReader::Varint(){
+    std::uint64_t value = 0;
+    for(int i = 0; i < MAX_VARINT_BYTES; ++i){
+        const std::uint8_t byte = U8();
+        value |= std::uint64_t{byte & 0x7Fu} << (i * 7);
+        if((byte & 0x80) == 0){
+            return value;
+        }
+    }
+    throw std::out_of_range("Varint is too long");
+}
+
+std::string_view BinaryReader::Bytes(){
+    const std::uint64_t size = Varint();
+    if(size > GetRemaining()){
+        throw std::out_of_range("Binary data is truncated");
+    }
+    return Raw(static_cast<size_t>(size));
+}
+
+}  // namespace binary_serializer
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace binary_serializer {
+
+/*
+ *  Запись двоичных данных в строку: целые фиксированной ширины и float32 в little-endian
+ *  независимо от порядка байтов платформы, беззнаковые целые переменной длины (varint, как в protobuf).
+ *  Строка out может переиспользоваться между ответами, писатель только дописывает в неё.
+ */
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string& out) : out_(out) {}
+
+    BinaryWriter& U8(std::uint8_t value);
+    BinaryWriter& U32(std::uint32_t value);
+    BinaryWriter& U64(std::uint64_t value);
+    BinaryWriter& I32(std::int32_t value) { return U32(static_cast<std::uint32_t>(value)); }
+    BinaryWriter& F32(float value);
+    BinaryWriter& F64(double value);
+    BinaryWriter& Varint(std::uint64_t value);
+    // Длина varint-ом, затем сами байты
+    BinaryWriter& Bytes(std::string_view bytes);
+
+    size_t GetSize() const noexcept { return out_.size(); }
+
+private:
+    std::string& out_;
+};
+
+/*
+ *  Чтение данных, записанных BinaryWriter. Выход за границы буфера и слишком длинный varint
+ *  бросают std::out_of_range: данные пришли извне и могут быть обрезаны или испорчены.
+ */
+class BinaryReader {
+public:
+    explicit BinaryReader(std::string_view in) : in_(in) {}
+
+    std::uint8_t U8();
+    std::uint32_t U32();
+    std::uint64_t U64();
+    std::int32_t I32() { return static_cast<std::int32_t>(U32()); }
+    float F32();
+    double F64();
+    std::uint64_t Varint();
+    std::string_view Bytes();
+    // Следующие size байт без разбора
+    std::string_view Raw(size_t size);
+
+    size_t GetRemaining() const noexcept { return in_.size() - pos_; }
+    size_t GetPosition() const noexcept { return pos_; }
+
+private:
+    std::string_view in_;
+    size_t pos_{0};
+};
+
+}  // namespace binary_serializer
@@ -1,7 +1,112 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <cmath>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define COLLISION_DETECTOR_AVX2
+#include <immintrin.h>
+#endif
+
 namespace collision_detector {
 
+namespace {
+
+const double epsilon = 1e-10;
+
+struct Segment {
+    double a_x;
+    double a_y;
+    double v_x;
+    double v_y;
+    double v_len2;
+    double width;
+};
+
+bool IsStatic(double start_x, double start_y, double end_x, double end_y) {
+    return (std::abs(start_x - end_x) <= epsilon) && (std::abs(start_y - end_y) <= epsilon);
+}
+
+// Те же вычисления, что и в TryCollectPoint, но над массивами предметов
+void CollectPointsScalar(const Segment& seg, size_t gatherer_id, const ItemsBatch& items,
+                         size_t begin, size_t end, std::vector<GatheringEvent>& events) {
+    for (size_t j = begin; j < end; ++j) {
+        const double u_x = items.x[j] - seg.a_x;
+        const double u_y = items.y[j] - seg.a_y;
+        const double u_dot_v = u_x * seg.v_x + u_y * seg.v_y;
+        const double u_len2 = u_x * u_x + u_y * u_y;
+        const double proj_ratio = u_dot_v / seg.v_len2;
+        const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / seg.v_len2;
+        const double radius = seg.width + items.width[j];
+
+        if (proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= radius * radius) {
+            events.push_back(GatheringEvent{j, gatherer_id, sq_distance, proj_ratio});
+        }
+    }
+}
+
+#ifdef COLLISION_DETECTOR_AVX2
+// Обрабатывает по 4 предмета за итерацию, хвост досчитывается скалярным кодом
+__attribute__((target("avx2")))
+void CollectPointsAvx2(const Segment& seg, size_t gatherer_id, const ItemsBatch& items,
+                       size_t begin, size_t end, std::vector<GatheringEvent>& events) {
+    const __m256d a_x = _mm256_set1_pd(seg.a_x);
+    const __m256d a_y = _mm256_set1_pd(seg.a_y);
+    const __m256d v_x = _mm256_set1_pd(seg.v_x);
+    const __m256d v_y = _mm256_set1_pd(seg.v_y);
+    const __m256d v_len2 = _mm256_set1_pd(seg.v_len2);
+    const __m256d width = _mm256_set1_pd(seg.width);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    alignas(32) double proj_ratio[4];
+    alignas(32) double sq_distance[4];
+
+    size_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(&items.x[j]), a_x);
+        const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(&items.y[j]), a_y);
+        const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, v_x), _mm256_mul_pd(u_y, v_y));
+        const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+        const __m256d proj = _mm256_div_pd(u_dot_v, v_len2);
+        const __m256d sq_dist = _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2));
+        const __m256d radius = _mm256_add_pd(width, _mm256_loadu_pd(&items.width[j]));
+
+        const __m256d collected = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(proj, zero, _CMP_GE_OQ), _mm256_cmp_pd(proj, one, _CMP_LE_OQ)),
+            _mm256_cmp_pd(sq_dist, _mm256_mul_pd(radius, radius), _CMP_LE_OQ));
+
+        const int mask = _mm256_movemask_pd(collected);
+        if (!mask) {
+            continue;
+        }
+
+        _mm256_store_pd(proj_ratio, proj);
+        _mm256_store_pd(sq_distance, sq_dist);
+        for (size_t k = 0; k < 4; ++k) {
+            if (mask & (1 << k)) {
+                events.push_back(GatheringEvent{j + k, gatherer_id, sq_distance[k], proj_ratio[k]});
+            }
+        }
+    }
+
+    CollectPointsScalar(seg, gatherer_id, items, j, end, events);
+}
+
+bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+void SortEventsByTime(std::vector<GatheringEvent>& events) {
+    std::sort(events.begin(), events.end(), [](const GatheringEvent& evt1, const GatheringEvent& evt2)
+    										{
+                  	  	  	  	  	  	  		return evt1.time < evt2.time;
+    										});
+}
+
+}  // namespace
+
 CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
     assert(b.x != a.x || b.y != a.y);
     const double u_x = c.x - a.x;
@@ -20,7 +125,6 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
     std::vector<GatheringEvent> events;
 
-    const double epsilon = 1e-10;
     for(size_t i = 0; i < provider.GatherersCount(); ++i){
         Gatherer gath = provider.GetGatherer(i);
 
@@ -41,11 +145,37 @@ std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provide
         }
     }
 
-    std::sort(events.begin(), events.end(), [](const GatheringEvent& evt1, const GatheringEvent& evt2)
-    										{
-                  	  	  	  	  	  	  		return evt1.time < evt2.time;
-    										});
+    SortEventsByTime(events);
+    return events;
+}
+
+std::vector<GatheringEvent> FindGatherEvents(const GatherersBatch& gatherers, const ItemsBatch& items) {
+    std::vector<GatheringEvent> events;
+
+#ifdef COLLISION_DETECTOR_AVX2
+    auto collect_points = HasAvx2() ? CollectPointsAvx2 : CollectPointsScalar;
+#else
+    auto collect_points = CollectPointsScalar;
+#endif
+
+    for (size_t i = 0; i < gatherers.Size(); ++i) {
+        if (IsStatic(gatherers.start_x[i], gatherers.start_y[i], gatherers.end_x[i], gatherers.end_y[i])) {
+            continue;
+        }
+
+        Segment seg;
+        seg.a_x = gatherers.start_x[i];
+        seg.a_y = gatherers.start_y[i];
+        seg.v_x = gatherers.end_x[i] - seg.a_x;
+        seg.v_y = gatherers.end_y[i] - seg.a_y;
+        seg.v_len2 = seg.v_x * seg.v_x + seg.v_y * seg.v_y;
+        seg.width = gatherers.width[i];
+
+        const auto& range = gatherers.items[i];
+        collect_points(seg, i, items, range.begin, std::min(range.end, items.Size()), events);
+    }
 
+    SortEventsByTime(events);
     return events;
 }
 }  // namespace collision_detector
@@ -87,5 +87,71 @@ private:
     std::vector<Gatherer> gatherers_;
 };
 
+/*
+ *  Предметы и собиратели тика в виде структуры массивов для пакетного поиска
+ *  событий сбора векторизованным ядром.
+ */
+struct ItemsBatch {
+    void Add(const Item& item) {
+        x.push_back(item.position.x);
+        y.push_back(item.position.y);
+        width.push_back(item.width);
+    }
+
+    void Clear() {
+        x.clear();
+        y.clear();
+        width.clear();
+    }
+
+    size_t Size() const noexcept {
+        return x.size();
+    }
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> width;
+};
+
+struct GatherersBatch {
+    // Предметы-кандидаты собирателя: полуинтервал индексов в ItemsBatch
+    struct ItemsRange {
+        size_t begin;
+        size_t end;
+    };
+
+    void Add(const Gatherer& gatherer, ItemsRange items_range) {
+        start_x.push_back(gatherer.start_pos.x);
+        start_y.push_back(gatherer.start_pos.y);
+        end_x.push_back(gatherer.end_pos.x);
+        end_y.push_back(gatherer.end_pos.y);
+        width.push_back(gatherer.width);
+        items.push_back(items_range);
+    }
+
+    void Clear() {
+        start_x.clear();
+        start_y.clear();
+        end_x.clear();
+        end_y.clear();
+        width.clear();
+        items.clear();
+    }
+
+    size_t Size() const noexcept {
+        return start_x.size();
+    }
+
+    std::vector<double> start_x;
+    std::vector<double> start_y;
+    std::vector<double> end_x;
+    std::vector<double> end_y;
+    std::vector<double> width;
+    std::vector<ItemsRange> items;
+};
+
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
+
+// Каждый собиратель проверяется только с предметами из своего диапазона gatherers.items
+std::vector<GatheringEvent> FindGatherEvents(const GatherersBatch& gatherers, const ItemsBatch& items);
 }  // namespace collision_detector
@@ -0,0 +1,80 @@
+#include "connection_arena.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace http_server {
+
+void* ConnectionArena::Allocate(size_t size, size_t alignment){
+    while(current_block_ < blocks_.size()){
+        auto& block = blocks_[current_block_];
+        void* ptr = block.data.get() + offset_;
+        size_t space = block.size - offset_;
+        if(std::align(alignment, size, ptr, space)){
+            offset_ = block.size - space + size;
+            return ptr;
+        }
+
+        ++current_block_;
+        offset_ = 0;
+    }
+
+    const size_t block_size = std::max(BLOCK_SIZE, size + alignment);
+    blocks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[block_size]), block_size});
+    reserved_size_ += block_size;
+    current_block_ = blocks_.size() - 1;
+    offset_ = 0;
+
+    return Allocate(size, alignment);
+}
+
+void ConnectionArena::Reset() noexcept {
+    while((reserved_size_ > MAX_RETAINED_SIZE) && (blocks_.size() > 1)){
+        reserved_size_ -= blocks_.back().size;
+        blocks_.pop_back();
+    }
+
+    current_block_ = 0;
+    offset_ = 0;
+}
+
+HandlerMemoryPool::~HandlerMemoryPool(){
+    for(auto* block : free_lists_){
+        while(block){
+            ::operator delete(std::exchange(block, block->next));
+        }
+    }
+}
+
+void* HandlerMemoryPool::Allocate(size_t size){
+    if(size > MAX_POOLED_SIZE){
+        return ::operator new(size);
+    }
+
+    const size_t index = (size - 1) / GRANULARITY;
+    {
+        std::lock_guard lock(mutex_);
+        if(auto* block = free_lists_[index]){
+            free_lists_[index] = block->next;
+            return block;
+        }
+    }
+    return ::operator new((index + 1) * GRANULARITY);
+}
+
+void HandlerMemoryPool::Deallocate(void* ptr, size_t size) noexcept {
+    if(size > MAX_POOLED_SIZE){
+        ::operator delete(ptr);
+        return;
+    }
+
+    const size_t index = (size - 1) / GRANULARITY;
+    auto* block = static_cast<FreeBlock*>(ptr);
+
+    std::lock_guard lock(mutex_);
+    block->next = free_lists_[index];
+    free_lists_[index] = block;
+}
+
+}  // namespace http_server
@@ -0,0 +1,155 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace http_server {
+
+/*
+ *  Арена соединения: память под заголовки запроса выделяется последовательно из блоков
+ *  и освобождается целиком перед чтением следующего запроса.
+ *  Блоки остаются за соединением, поэтому запросы keep-alive не обращаются к куче.
+ */
+class ConnectionArena {
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+    // после большого запроса соединение возвращает лишнюю память
+    static constexpr size_t MAX_RETAINED_SIZE = 64 * 1024;
+
+    ConnectionArena() = default;
+    ConnectionArena(const ConnectionArena&) = delete;
+    ConnectionArena& operator=(const ConnectionArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment);
+    void Reset() noexcept;
+
+    size_t GetReservedSize() const noexcept { return reserved_size_; }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size{0};
+    };
+
+    std::vector<Block> blocks_;
+    size_t current_block_{0};
+    size_t offset_{0};
+    size_t reserved_size_{0};
+};
+
+// Аллокатор для http::basic_fields: освобождение памяти откладывается до ConnectionArena::Reset
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(ConnectionArena* arena) noexcept : arena_(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.GetArena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    ConnectionArena* GetArena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.GetArena(); }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.GetArena(); }
+
+private:
+    ConnectionArena* arena_;
+};
+
+/*
+ *  Пул памяти асинхронных операций соединения.
+ *  Освобождённые блоки остаются в списках свободных блоков своего размера и выдаются следующим операциям.
+ *  Ответ может отправляться из strand игровой сессии, поэтому пул защищён мьютексом.
+ */
+class HandlerMemoryPool {
+public:
+    static constexpr size_t GRANULARITY = 64;
+    static constexpr size_t MAX_POOLED_SIZE = 2048;
+
+    HandlerMemoryPool() = default;
+    HandlerMemoryPool(const HandlerMemoryPool&) = delete;
+    HandlerMemoryPool& operator=(const HandlerMemoryPool&) = delete;
+    ~HandlerMemoryPool();
+
+    void* Allocate(size_t size);
+    void Deallocate(void* ptr, size_t size) noexcept;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    std::mutex mutex_;
+    std::array<FreeBlock*, MAX_POOLED_SIZE / GRANULARITY> free_lists_{};
+};
+
+template <typename T>
+class HandlerAllocator {
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemoryPool* pool) noexcept : pool_(pool) {}
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept : pool_(other.GetPool()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(pool_->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        pool_->Deallocate(ptr, n * sizeof(T));
+    }
+
+    HandlerMemoryPool* GetPool() const noexcept { return pool_; }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U>& other) const noexcept { return pool_ == other.GetPool(); }
+
+    template <typename U>
+    bool operator!=(const HandlerAllocator<U>& other) const noexcept { return pool_ != other.GetPool(); }
+
+private:
+    HandlerMemoryPool* pool_;
+};
+
+// Обработчик завершения, операции которого размещаются в пуле соединения
+template <typename Handler>
+class PooledHandler {
+public:
+    using allocator_type = HandlerAllocator<void>;
+
+    PooledHandler(HandlerMemoryPool* pool, Handler handler)
+        : pool_(pool), handler_(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type{pool_}; }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemoryPool* pool_;
+    Handler handler_;
+};
+
+template <typename Handler>
+PooledHandler<std::decay_t<Handler>> MakePooledHandler(HandlerMemoryPool& pool, Handler&& handler) {
+    return {&pool, std::forward<Handler>(handler)};
+}
+
+}  // namespace http_server
@@ -0,0 +1,76 @@
+#include "connection_tracker.h"
+
+#include <utility>
+
+namespace http_server {
+
+using namespace std::literals;
+
+std::string_view ConvertCloseReasonToString(CloseReason reason) {
+    switch (reason) {
+        case CloseReason::CLIENT_CLOSED: return "client_closed"sv;
+        case CloseReason::NOT_KEEP_ALIVE: return "not_keep_alive"sv;
+        case CloseReason::KEEP_ALIVE_TIMEOUT: return "keep_alive_timeout"sv;
+        case CloseReason::HEADER_TIMEOUT: return "header_timeout"sv;
+        case CloseReason::BODY_TIMEOUT: return "body_timeout"sv;
+        case CloseReason::WRITE_TIMEOUT: return "write_timeout"sv;
+        case CloseReason::READ_ERROR: return "read_error"sv;
+        case CloseReason::WRITE_ERROR: return "write_error"sv;
+        case CloseReason::UPGRADED: return "upgraded"sv;
+        case CloseReason::SHUTDOWN: return "shutdown"sv;
+        case CloseReason::COUNT: break;
+    }
+    return "unknown"sv;
+}
+
+bool ConnectionTracker::TryOpen() {
+    std::lock_guard lock(mutex_);
+    if (active_ >= limits_.max_connections) {
+        return false;
+    }
+    ++active_;
+    return true;
+}
+
+void ConnectionTracker::Release() {
+    FreeSlot();
+}
+
+void ConnectionTracker::OnClosed(CloseReason reason) {
+    closed_[static_cast<size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+    FreeSlot();
+}
+
+void ConnectionTracker::FreeSlot() {
+    std::function<void()> resume;
+    {
+        std::lock_guard lock(mutex_);
+        --active_;
+        if (!waiters_.empty()) {
+            resume = std::move(waiters_.front());
+            waiters_.pop_front();
+        }
+    }
+    // продолжение вызывается без блокировки: оно само займёт место через TryOpen
+    if (resume) {
+        resume();
+    }
+}
+
+void ConnectionTracker::WaitForSlot(std::function<void()> resume) {
+    {
+        std::lock_guard lock(mutex_);
+        if (active_ >= limits_.max_connections) {
+            waiters_.push_back(std::move(resume));
+            return;
+        }
+    }
+    resume();
+}
+
+size_t ConnectionTracker::GetActiveConnections() const {
+    std::lock_guard lock(mutex_);
+    return active_;
+}
+
+}  // namespace http_server
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+
+namespace http_server {
+
+using namespace std::chrono_literals;
+
+// Ограничения, защищающие сервер от медленных и брошенных соединений
+struct ServerLimits {
+    // время на получение заголовков запроса
+    std::chrono::milliseconds header_timeout{10s};
+    // время на получение тела запроса после заголовков
+    std::chrono::milliseconds body_timeout{30s};
+    // простой keep-alive соединения между запросами
+    std::chrono::milliseconds keep_alive_timeout{60s};
+    std::chrono::milliseconds write_timeout{30s};
+    size_t max_connections{10000};
+};
+
+enum class CloseReason {
+    CLIENT_CLOSED,
+    NOT_KEEP_ALIVE,
+    KEEP_ALIVE_TIMEOUT,
+    HEADER_TIMEOUT,
+    BODY_TIMEOUT,
+    WRITE_TIMEOUT,
+    READ_ERROR,
+    WRITE_ERROR,
+    // соединение передано обработчику WebSocket
+    UPGRADED,
+    SHUTDOWN,
+    COUNT
+};
+
+std::string_view ConvertCloseReasonToString(CloseReason reason);
+
+/*
+ *  Учёт соединений сервера: ограничивает их число и считает закрытые соединения по причинам.
+ *  Один объект разделяется всеми Listener-ами и сессиями, поэтому методы потокобезопасны.
+ */
+class ConnectionTracker {
+public:
+    explicit ConnectionTracker(ServerLimits limits = {}) : limits_(limits) {
+    }
+
+    const ServerLimits& GetLimits() const noexcept { return limits_; }
+
+    // Занимает место под новое соединение, если лимит не исчерпан
+    bool TryOpen();
+    // Освобождает место, занятое TryOpen, когда соединение так и не было принято
+    void Release();
+    // Освобождает место закрытого соединения и учитывает причину закрытия
+    void OnClosed(CloseReason reason);
+    // resume вызывается один раз, когда появится свободное место (сразу, если оно уже есть)
+    void WaitForSlot(std::function<void()> resume);
+
+    // открытые соединения и места, занятые Listener-ами под ожидаемое соединение
+    size_t GetActiveConnections() const;
+    std::uint64_t GetClosedConnections(CloseReason reason) const noexcept {
+        return closed_[static_cast<size_t>(reason)].load(std::memory_order_relaxed);
+    }
+
+private:
+    void FreeSlot();
+
+    const ServerLimits limits_;
+
+    mutable std::mutex mutex_;
+    size_t active_{0};
+    std::deque<std::function<void()>> waiters_;
+
+    std::array<std::atomic<std::uint64_t>, static_cast<size_t>(CloseReason::COUNT)> closed_{};
+};
+
+}  // namespace http_server
@@ -1,5 +1,6 @@
 #include "dog.h"
-#include <map>
+#include <array>
+#include <string_view>
 #include "server_exceptions.h"
 #include "utils.h"
 #include "collision_detector.h"
@@ -10,31 +11,30 @@ constexpr double gathererWidth = 0.6;
 constexpr double epsilon = 0.0001;
 namespace model
 {
-    std::string ConvertDogDirectionToString(DogDirection direction){
-    	std::map<DogDirection, std::string> dir{ {DogDirection::EAST, "R"},
-    			   	   	   	   	   	   	   	     {DogDirection::WEST, "L"},
-    											 {DogDirection::SOUTH, "D"},
-    											 {DogDirection::NORTH,"U"} };
+    // Таблицы по направлениям в порядке перечисления DogDirection: NORTH, SOUTH, WEST, EAST, STOP
+    constexpr std::array<std::string_view, 5> DIRECTION_NAMES{"U", "D", "L", "R", "U"};
+    constexpr std::array<DogSpeed, 5> DIRECTION_VELOCITIES{{{0.0, -1.0}, {0.0, 1.0}, {-1.0, 0.0}, {1.0, 0.0}, {0.0, 0.0}}};
 
-    	if(auto itFind = dir.find(direction); itFind != dir.end())
-    		return itFind->second;
+    static_assert(static_cast<size_t>(DogDirection::STOP) + 1 == DIRECTION_VELOCITIES.size());
 
-    	return "U";
+    std::string ConvertDogDirectionToString(DogDirection direction){
+    	const auto index = static_cast<size_t>(direction);
+    	return std::string(index < DIRECTION_NAMES.size() ? DIRECTION_NAMES[index] : DIRECTION_NAMES.front());
     }
 
-	Dog::Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity) : map_(map){
+	Dog::Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity)
+	: map_(map), navigator_(map->GetRoadTopology(), spawn_dog_in_random_point){
 		bag_capacity_ = map->GetBagCapacity() ? map->GetBagCapacity() :  defaultBagCapacity;
 		direction_ = DogDirection::NORTH;
-		navigator_ = std::make_shared<DogNavigator>(map_->GetRoads(), spawn_dog_in_random_point);
 	}
 
-	void Dog::SetSpeed(DogDirection dir, double speed){
-		std::map<DogDirection, DogSpeed> velMap{{DogDirection::EAST, {speed, 0.0}}, {DogDirection::WEST, {-speed, 0.0}},
-												{DogDirection::SOUTH, {0.0, speed}}, {DogDirection::NORTH, {0.0, -speed}},
-												{DogDirection::STOP, {0.0, 0.0}}};
+	Dog::Dog(const model::Map *map, const DogPos& position, unsigned bag_capacity)
+	: direction_(DogDirection::NORTH), map_(map), navigator_(map->GetRoadTopology(), position), bag_capacity_(bag_capacity){
+	}
 
-		auto find_vel = velMap.find(dir);
-		if(find_vel == velMap.end()){
+	void Dog::SetSpeed(DogDirection dir, double speed){
+		const auto index = static_cast<size_t>(dir);
+		if(index >= DIRECTION_VELOCITIES.size()){
 			throw DogSpeedException();
 		}
 
@@ -43,14 +43,20 @@ namespace model
 		}
 
 		idle_time_= 0;
-		navigator_->SetDogSpeed(find_vel->second);
+		const DogSpeed& unit = DIRECTION_VELOCITIES[index];
+		navigator_.SetDogSpeed({unit.vx * speed, unit.vy * speed});
+	}
+
+	bool Dog::IsMoving(){
+		auto speed = navigator_.GetDogSpeed();
+		return (std::abs(speed.vx) > epsilon) || (std::abs(speed.vy) > epsilon);
 	}
 
 	std::optional<collision_detector::Gatherer> Dog::Move(int deltaTime){
 
 		std::optional<collision_detector::Gatherer> res;
 		play_time_ += deltaTime;
-		auto speed = navigator_->GetDogSpeed();
+		auto speed = navigator_.GetDogSpeed();
 
 		if((std::abs(speed.vx) <= epsilon) && (std::abs(speed.vy) <= epsilon)){
 			idle_time_ += deltaTime;
@@ -61,7 +67,7 @@ namespace model
 		}
 
 		DogPosition start =  GetPosition();
-		navigator_->MoveDog(direction_, deltaTime);
+		navigator_.MoveDog(direction_, deltaTime);
 
 		DogPosition end =  GetPosition();
 
@@ -91,79 +97,18 @@ namespace model
 		gathered_loots_.clear();
 	}
 
-	bool DogNavigator::RoadsCrossed(const model::Road& road1, const model::Road& road2){
-	    if((road1.IsHorizontal() && road2.IsVertical()) || (road1.IsVertical() && road2.IsHorizontal())){
-	        const auto& first_start = road1.GetStart();
-	        const auto& second_start = road2.GetStart();
-	        const auto& second_end = road2.GetEnd();
-
-	        if(road1.IsHorizontal())
-	        {
-	            if(((second_start.y < first_start.y) && (second_end.y < first_start.y)) ||
-	              ((second_start.y > first_start.y) && (second_end.y > first_start.y)))
-	                    return false;
-	        }
-	        else
-	            if(road1.IsVertical())
-	            {
-	                if(((second_start.x < first_start.x) && (second_end.x < first_start.x)) ||
-	                  ((second_start.x > first_start.x) && (second_end.x > first_start.x)))
-	                    return false;
-
-	            }
-	        return true;
-	    }
-	    return false;
-	}
-
-	bool DogNavigator::RoadsAdjacent(const model::Road& road1, const model::Road& road2){
-	    if((road1.IsHorizontal() && road2.IsHorizontal()) || (road1.IsVertical() && road2.IsVertical())){
-	        auto first_start = road1.GetStart();
-	        auto first_end = road1.GetEnd();
-
-	        auto second_start = road2.GetStart();
-	        auto second_end = road2.GetEnd();
-
-	        if((first_start == second_start) || (first_start == second_end) ||
-	            (first_end == second_start) || (first_end == second_end))
-	            return true;
-	    }
-
-	    return false;
-	}
-
-	void DogNavigator::FindAdjacentRoads(){
-	    for(size_t i = 0; i < roads_.size(); ++i){
-	        for(size_t j = i+1; j < roads_.size(); ++j){
-	            RoadType road_type{RoadType::Parallel};
-
-	            if(RoadsAdjacent(roads_[i], roads_[j])){
-	                road_type = RoadType::Adjacent;
-				}else{
-	                if(RoadsCrossed(roads_[i], roads_[j]))
-	                    road_type = RoadType::Crossed;
-				}
-
-	            if(road_type != RoadType::Parallel){
-	                adjacent_roads_[i].push_back(RoadInfo(j,road_type));
-	                adjacent_roads_[j].push_back(RoadInfo(i,road_type));
-	            }
-	        }
-	    }
-	}
-
 	void DogNavigator::SetStartPositionFirstRoad(){
 	    dog_info_.current_road_index = 0;
-	    auto start = roads_[dog_info_.current_road_index].GetStart();
+	    auto start = topology_.GetRoad(dog_info_.current_road_index).GetStart();
 	    dog_info_.curr_position = DogPosition(start.x, start.y);
 	}
 
 	void DogNavigator::SetStartPositionRandomRoad(){
-		dog_info_.current_road_index = utils::GetRandomNumber<size_t>(0, roads_.size()-1);
-		auto start = roads_[dog_info_.current_road_index].GetStart();
-		auto end = roads_[dog_info_.current_road_index].GetEnd();
+		dog_info_.current_road_index = utils::GetRandomNumber<size_t>(0, topology_.GetNumRoads()-1);
+		auto start = topology_.GetRoad(dog_info_.current_road_index).GetStart();
+		auto end = topology_.GetRoad(dog_info_.current_road_index).GetEnd();
 
-		if(roads_[dog_info_.current_road_index].IsHorizontal()){
+		if(topology_.GetRoad(dog_info_.current_road_index).IsHorizontal()){
 			if(start.x > end.x)
 				std::swap(start, end);
 			dog_info_.curr_position = DogPosition(utils::GetRandomNumber<int>(start.x, end.x), start.y);
@@ -223,59 +168,15 @@ namespace model
 	}
 
 	std::optional<size_t> DogNavigator::FindNearestVerticalCrossRoad(const DogPosition& newPos){
-		std::optional<size_t> res;
-
-	    const auto& adj_roads = adjacent_roads_[dog_info_.current_road_index];
-	    for(const auto& road_info : adj_roads){
-	    	if(road_info.road_type != RoadType::Crossed){
-	    		continue;
-			}
-
-	    	const auto& adj_road = roads_[road_info.road_index];
-
-	        if((newPos.y < static_cast<double>(adj_road.GetStart().y)) && (newPos.y < static_cast<double>(adj_road.GetEnd().y))){
-	        	continue;
-			}
-
-	        if((newPos.y > static_cast<double>(adj_road.GetStart().y)) && (newPos.y > static_cast<double>(adj_road.GetEnd().y))){
-	        	continue;
-			}
-
-	        double dist = std::abs(static_cast<double>(adj_road.GetStart().x) - newPos.x);
-
-	        if(dist <= dS){
-	        	res = road_info.road_index;
-	        	return res;
-	        }
-	    }
-
-	        return res;
+		// вертикальная дорога должна пересекать текущую и доходить до новой позиции
+		const double road_y = topology_.GetRoad(dog_info_.current_road_index).GetStart().y;
+		auto [y_from, y_to] = std::minmax({road_y, newPos.y});
+		return topology_.GetVerticalIndex().Find(newPos.x, dS, y_from, y_to);
 	}
 
 	std::optional<size_t> DogNavigator::FindNearestAdjacentVerticalRoad(const DogPosition& edge_point){
-	    std::optional<size_t> res;
-
-	    const auto& adj_roads = adjacent_roads_[dog_info_.current_road_index];
-	    for(const auto& road_info : adj_roads){
-	        if(road_info.road_type != RoadType::Crossed){
-	            continue;
-			}
-
-	        const auto& adj_road = roads_[road_info.road_index];//dog_info_.current_road_index];
-	        if(!adj_road.IsVertical()){
-	            continue;
-			}
-
-	        double dist1 = std::abs(static_cast<double>(adj_road.GetStart().x) - edge_point.x);
-	        double dist2 = std::abs(static_cast<double>(adj_road.GetEnd().x) - edge_point.x);
-
-	        if((dist1 <= dS) || (dist2 <= dS)){
-	             res = road_info.road_index;
-	             return res;
-	        }
-	    }
-
-	    return res;
+		const double road_y = topology_.GetRoad(dog_info_.current_road_index).GetStart().y;
+		return topology_.GetVerticalIndex().Find(edge_point.x, dS, road_y, road_y);
 	}
 
 	void DogNavigator::FindNewPosPerpendicularHorizontal(const model::Road& road, DogDirection direction,
@@ -284,7 +185,7 @@ namespace model
 	    std::optional<size_t> adjRoad = FindNearestAdjacentVerticalRoad(newPos);
 	    bool findRoad = false;
 	    if(adjRoad){
-	        const auto& road_cand = roads_[*adjRoad];
+	        const auto& road_cand = topology_.GetRoad(*adjRoad);
 
 	        if(direction == DogDirection::NORTH){
 	            if((road_cand.GetStart().y <= road.GetStart().y) && (road_cand.GetEnd().y <= road.GetStart().y))
@@ -323,65 +224,22 @@ namespace model
 	}
 
 	std::optional<size_t> DogNavigator::FindNearestAdjacentHorizontalRoad(const DogPosition& edge_point){
-	    std::optional<size_t> res;
-
-	    const auto& adj_roads = adjacent_roads_[dog_info_.current_road_index];
-	    for(const auto& road_info : adj_roads){
-	        if(road_info.road_type != RoadType::Crossed){
-	            continue;
-			}
-
-	        const auto& adj_road = roads_[road_info.road_index];
-	        if(!adj_road.IsHorizontal()){
-	            continue;
-			}
-
-	        double dist1 = std::abs(static_cast<double>(adj_road.GetStart().y) - edge_point.y);
-	        double dist2 = std::abs(static_cast<double>(adj_road.GetEnd().y) - edge_point.y);
-
-	        if((dist1 <= dS) || (dist2 <= dS)){
-	             res = road_info.road_index;
-	             return res;
-	        }
-	    }
-
-	    return res;
+		const double road_x = topology_.GetRoad(dog_info_.current_road_index).GetStart().x;
+		return topology_.GetHorizontalIndex().Find(edge_point.y, dS, road_x, road_x);
 	}
 
 	std::optional<size_t> DogNavigator::FindNearestHorizontalCrossRoad(const DogPosition& newPos){
-	    std::optional<size_t> res;
-
-	    const auto& adj_roads = adjacent_roads_[dog_info_.current_road_index];
-	    for(const auto& road_info : adj_roads){
-	        if(road_info.road_type != RoadType::Crossed){
-	            continue;
-			}
-
-	        const auto& adj_road = roads_[road_info.road_index];
-
-	        if((newPos.x < static_cast<double>(adj_road.GetStart().x)) && (newPos.x < static_cast<double>(adj_road.GetEnd().x))){
-	            continue;
-			}
-
-	        if((newPos.x > static_cast<double>(adj_road.GetStart().x)) && (newPos.x > static_cast<double>(adj_road.GetEnd().x))){
-	            continue;
-			}
-
-           double dist = std::abs(static_cast<double>(adj_road.GetStart().y) - newPos.y);
-
-	       if(dist <= dS){
-	    	   return road_info.road_index;
-	       }
-	   }
-
-	    return res;
+		// горизонтальная дорога должна пересекать текущую и доходить до новой позиции
+		const double road_x = topology_.GetRoad(dog_info_.current_road_index).GetStart().x;
+		auto [x_from, x_to] = std::minmax({road_x, newPos.x});
+		return topology_.GetHorizontalIndex().Find(newPos.y, dS, x_from, x_to);
 	}
 
 	void DogNavigator::FindNewPosPerpendicularVertical(const model::Road& road, DogDirection direction, DogPosition& newPos){
 	        std::optional<size_t> adjRoad = FindNearestAdjacentHorizontalRoad(newPos);
 	         bool findRoad = false;
 	        if(adjRoad){
-	            const auto& road_cand = roads_[*adjRoad];
+	            const auto& road_cand = topology_.GetRoad(*adjRoad);
 
 	            if(direction == DogDirection::WEST){
 	                if((road_cand.GetStart().x <= road.GetStart().x) && (road_cand.GetEnd().x <= road.GetStart().x))
@@ -419,7 +277,7 @@ namespace model
 	    }
 
 	void DogNavigator::MoveDog(DogDirection direction, int time){
-	    const auto& road = roads_[dog_info_.current_road_index];
+	    const auto& road = topology_.GetRoad(dog_info_.current_road_index);
 	    double dt = static_cast<double>(time) / millisescondsInSecond;
 
 	    DogPosition newPos{dog_info_.curr_position.x + dt * dog_info_.curr_speed.vx,
@@ -445,7 +303,7 @@ namespace model
 	}
 
 	void DogNavigator::CorrectDogPosition(){
-		const auto& road = roads_[dog_info_.current_road_index];
+		const auto& road = topology_.GetRoad(dog_info_.current_road_index);
 
 		auto [x_min, x_max] = std::minmax({road.GetStart().x, road.GetEnd().x});
 		auto [y_min, y_max] = std::minmax({road.GetStart().y, road.GetEnd().y});
@@ -1,5 +1,6 @@
 #pragma once
 #include "model.h"
+#include "road_topology.h"
 #include <optional>
 
 using namespace model;
@@ -15,27 +16,21 @@ struct Point;
 class Map;
 class Road;
 struct LootInfo;
-enum class RoadType{Parallel, Adjacent, Crossed};
-
-struct RoadInfo{
-    size_t road_index{};
-    RoadType road_type{RoadType::Parallel};
-    RoadInfo(size_t index, RoadType rdType):road_index(index), road_type(rdType)  {}
-};
-
 std::string ConvertDogDirectionToString(DogDirection direction);
 
+// Положение собаки на дорогах карты. Топология дорог общая для всех собак карты.
 class DogNavigator {
 public:
-    DogNavigator(const std::vector<model::Road>& roads, bool spawn_dog_in_random_point) : roads_(roads){
-        adjacent_roads_ = std::vector<std::vector<RoadInfo>>(roads.size());
-        FindAdjacentRoads();
+    DogNavigator(const RoadTopology& topology, bool spawn_dog_in_random_point) : topology_(topology){
         if(spawn_dog_in_random_point){
         	SetStartPositionRandomRoad();
         }else{
         	SetStartPositionFirstRoad();
         }
     }
+    // Собака из сохранения остаётся там, где была
+    DogNavigator(const RoadTopology& topology, const DogPos& position) : topology_(topology), dog_info_(position){
+    }
 
 public:
     void MoveDog(DogDirection direction, int time);
@@ -52,12 +47,8 @@ private:
     void FindNewPosMovingHorizontal(const model::Road& road, DogPosition& newPos);
     void FindNewPosMovingVertical(const model::Road& road, DogPosition& newPos);
 
-    void FindAdjacentRoads();
     void SetStartPositionFirstRoad();
 
-    bool RoadsCrossed(const model::Road& road1, const model::Road& road2);
-    bool RoadsAdjacent(const model::Road& road1, const model::Road& road2);
-
     std::optional<size_t> FindNearestAdjacentVerticalRoad(const DogPosition& edge_point);
     std::optional<size_t> FindNearestVerticalCrossRoad(const DogPosition& newPos);
 
@@ -71,8 +62,7 @@ private:
 	void CorrectDogPosition();
 
 private:
-    const std::vector<model::Road>& roads_;
-    std::vector<std::vector<RoadInfo>> adjacent_roads_;
+    const RoadTopology& topology_;
     DogPos dog_info_;
  };
 
@@ -80,18 +70,21 @@ class Dog{
 
 public:
 	Dog(const model::Map *map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
+	Dog(const model::Map *map, const DogPos& position, unsigned bag_capacity);
 
 	void SetSpeed(DogDirection dir, double speed);
 	void SetDirection(const DogDirection& dir) { direction_ = dir;}
 
 	std::optional<collision_detector::Gatherer> Move(int deltaTime);
+	// Стоящая собака за тик не меняет ни положения, ни скорости
+	bool IsMoving();
 	DogDirection GetDirection() {return direction_;}
-	DogPosition GetPosition() {return navigator_->GetDogPosition();}
-	DogPos GetPositionOnMap() {return navigator_->GetDogPosOnMap();}
-	DogSpeed GetSpeed() {return navigator_->GetDogSpeed();}
+	DogPosition GetPosition() {return navigator_.GetDogPosition();}
+	DogPos GetPositionOnMap() {return navigator_.GetDogPosOnMap();}
+	DogSpeed GetSpeed() {return navigator_.GetDogSpeed();}
 
     
-	void SpawnDogInMap(bool spawn_in_random_point) {navigator_->SpawnDogInMap(spawn_in_random_point);}
+	void SpawnDogInMap(bool spawn_in_random_point) {navigator_.SpawnDogInMap(spawn_in_random_point);}
 	const std::vector<model::LootInfo>& GetGatheredLoot() { return gathered_loots_;}
 	
 	bool AddLoot(const model::LootInfo& loot);
@@ -102,7 +95,7 @@ public:
 	unsigned int GetIdleTime() { return idle_time_; }
 	unsigned int GetPlayTime() { return play_time_;}
 
-    void SetPositionOnMap(const DogPos& position) {navigator_->SetDogPosOnMap(position);}
+    void SetPositionOnMap(const DogPos& position) {navigator_.SetDogPosOnMap(position);}
     void SetGatheredLoot(const std::vector<model::LootInfo>& loots) { gathered_loots_ = loots;}
     void SetScore(int score){ score_ = score;}
     void SetBagCapacity(unsigned capacity) {bag_capacity_ = capacity;}
@@ -111,7 +104,7 @@ public:
 private:
 	DogDirection direction_;
 	const model::Map* map_;
-	std::shared_ptr<model::DogNavigator> navigator_;
+	model::DogNavigator navigator_;
 	std::vector<model::LootInfo> gathered_loots_;
 	unsigned bag_capacity_{};
 	int score_{0};
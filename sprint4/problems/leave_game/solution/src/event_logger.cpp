@@ -102,4 +102,46 @@ void LogServerRespondSend(int response_time, unsigned code, const std::string& c
   BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, resp_object);
 }
 
+void LogConnectionsClosed(const std::vector<std::pair<std::string_view, std::uint64_t>>& counters){
+  json::object resp_object;
+  resp_object["message"] = "connections closed";
+  resp_object["timestamp"] = GetLogTime();
+
+  json::object data_object;
+  for(const auto& [reason, count] : counters){
+	data_object[reason] = count;
+  }
+
+  resp_object["data"] = data_object;
+
+  BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, resp_object);
+}
+
+void LogStateSaveFailed(const std::string& path, const std::string& error){
+  json::object resp_object;
+  resp_object["message"] = "state save failed";
+  resp_object["timestamp"] = GetLogTime();
+
+  json::object data_object;
+  data_object["path"] = path;
+  data_object["exception"] = error;
+
+  resp_object["data"] = data_object;
+
+  BOOST_LOG_TRIVIAL(error) << logging::add_value(additional_data, resp_object);
+}
+
+void LogRetiredSaveFailed(const std::string& error){
+  json::object resp_object;
+  resp_object["message"] = "retired players save failed";
+  resp_object["timestamp"] = GetLogTime();
+
+  json::object data_object;
+  data_object["exception"] = error;
+
+  resp_object["data"] = data_object;
+
+  BOOST_LOG_TRIVIAL(error) << logging::add_value(additional_data, resp_object);
+}
+
 }
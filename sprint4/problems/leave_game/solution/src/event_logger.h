@@ -1,4 +1,10 @@
 #pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace event_logger {
 
 void InitLogger();
@@ -7,4 +13,10 @@ void LogStartServer(const std::string& address, unsigned int port, const std::st
 void LogServerEnd(const std::string& message, int code, const std::string& exception_descr="");
 void LogServerRequestReceived(const std::string& uri, const std::string& http_method);
 void LogServerRespondSend(int response_time, unsigned code, const std::string& content_type);
+// Счётчики закрытых соединений по причинам
+void LogConnectionsClosed(const std::vector<std::pair<std::string_view, std::uint64_t>>& counters);
+// Фоновое сохранение состояния игры не удалось, прошлое сохранение осталось на диске
+void LogStateSaveFailed(const std::string& path, const std::string& error);
+// Пачку вышедших на пенсию игроков не удалось записать в базу, она будет повторена
+void LogRetiredSaveFailed(const std::string& error);
 }
@@ -6,8 +6,15 @@
 #include "utils.h"
 #include "collision_detector.h"
 #include <algorithm>
+#include <atomic>
 constexpr double baseWidth = 0.5;
 constexpr double lootWidth = 0.0;
+// ширина собирателя (см. dog.cpp) плюс наибольшая ширина предмета
+constexpr double nearItemsMargin = 0.6 + baseWidth;
+
+namespace {
+std::atomic<unsigned> next_loot_id{0};
+}
 
 namespace model
 {
@@ -18,8 +25,21 @@ Player::Player(unsigned int id, const std::string& name, const std::string& toke
 	dog_ = std::make_shared<Dog>(map, spawn_dog_in_random_point, defaultBagCapacity);
 }
 
+Player::Player(const PlayerState& state, const model::Map* map)
+	: name_(state.name_), token_(state.token_), id_(state.id_){
+
+	dog_ = std::make_shared<Dog>(map, state.dog_position_, state.bag_capacity_);
+	dog_->SetDirection(state.dog_direction_);
+	dog_->SetGatheredLoot(state.gathered_loots_);
+	dog_->SetScore(state.score_);
+	dog_->SetPlayTime(state.play_time_);
+}
+
 std::shared_ptr<Player> GameSession::AddPlayer(const std::string player_name, model::Map* map,
 											   bool spawn_dog_in_random_point, unsigned defaultBagCapacity){
+	if(!map_){
+		InitOffices(map);
+	}
 	map_ = map;
 	auto itFind = std::find_if(players_.begin(), players_.end(),
 							   [&player_name](std::shared_ptr<Player>& player)
@@ -36,12 +56,31 @@ std::shared_ptr<Player> GameSession::AddPlayer(const std::string player_name, mo
    auto player = std::make_shared<Player>(player_id, player_name, token, map,
 		   	   	   	   	   	   	   	   	  spawn_dog_in_random_point, defaultBagCapacity);
 
+   player->MarkJoined(GetChangeTick());
    players_.push_back(player);
    player_id++;
+   InvalidateCachedState();
+   InvalidateCachedPlayers();
 
    return players_.back();
 }
 
+void GameSession::RestoreState(const GameSessionState& state, model::Map* map){
+	if(!map_){
+		InitOffices(map);
+	}
+	map_ = map;
+
+	players_.reserve(players_.size() + state.player_state_.size());
+	for(const auto& player_state : state.player_state_){
+		// восстановленные игроки уже есть в сохранении и журнале, поэтому не отмечаются вошедшими
+		players_.push_back(std::make_shared<Player>(player_state, map));
+	}
+	player_id = state.player_id_;
+	SetLootsInfo(state.loots_info_state);
+	InvalidateCachedPlayers();
+}
+
 bool GameSession::HasPlayerWithAuthToken(const std::string& auth_token){
 	auto itFind = std::find_if(players_.begin(), players_.end(),
 							   [&auth_token](std::shared_ptr<Player>& player){
@@ -71,66 +110,92 @@ const std::vector<std::shared_ptr<Player>> GameSession::GetAllPlayers(){
 	return players_;
 }
 
-void AddLootToDog(std::shared_ptr<Dog> dog, std::vector<LootInfo>& loots, const std::vector<collision_detector::Item>& items){
-	for(const auto& item : items){
+void GameSession::InitOffices(const model::Map* map){
+	if(!map){
+		return;
+	}
 
-		if(item.item_type == collision_detector::ItemType::Office){
-			dog->PassLootToOffice();
+	for(const auto& office : map->GetOffices()){
+		items_grid_.Add(collision_detector::Item(0, {(double)office.GetPosition().x, (double)office.GetPosition().y},
+												 baseWidth, collision_detector::ItemType::Office));
+	}
+}
 
-		}else{
-			auto itFind = std::find_if(loots.begin(), loots.end(),
-									[id = item.id](const auto& elem )
-									{
-										return elem.id == id;
-									});
+void GameSession::SetLootsInfo(const std::vector<LootInfo>& loots){
+	loots_info_ = loots;
+	loots_tick_.assign(loots_info_.size(), GetChangeTick());
+	items_grid_.ClearLoots();
+	InvalidateCachedState();
 
-			if(itFind == loots.end())
-				continue;
+	for(const auto& loot : loots_info_){
+		items_grid_.Add(collision_detector::Item(loot.id, {loot.x, loot.y}, lootWidth));
 
-			if(dog->AddLoot(*itFind))
-				loots.erase(itFind);
-		}
+		// идентификаторы новых трофеев не должны совпадать с восстановленными
+		unsigned next_id = next_loot_id.load();
+		while(next_id <= loot.id && !next_loot_id.compare_exchange_weak(next_id, loot.id + 1)){}
 	}
 }
 
-std::vector<collision_detector::Item> GetGatheredItems(const collision_detector::Gatherer& gatherer, std::vector<LootInfo>& loots, model::Map* map){
-	std::vector<collision_detector::Item> items;
-	for(const auto& cur_loot : loots){
-		collision_detector::Item item(cur_loot.id, {cur_loot.x, cur_loot.y}, lootWidth);
-		items.push_back(item);
+void GameSession::GatherItem(Dog& dog, const collision_detector::Item& item){
+	if(item.item_type == collision_detector::ItemType::Office){
+		dog.PassLootToOffice();
+		return;
 	}
 
-	if(map){
-		const auto& offices = map->GetOffices();
+	auto itFind = std::find_if(loots_info_.begin(), loots_info_.end(),
+							[id = item.id](const auto& elem )
+							{
+								return elem.id == id;
+							});
+
+	// трофей уже подобрала собака, которая добралась до него раньше в этом тике
+	if(itFind == loots_info_.end())
+		return;
+
+	if(dog.AddLoot(*itFind)){
+		items_grid_.RemoveLoot(itFind->id);
+		removed_loots_.push_back({GetChangeTick(), itFind->id});
+		loots_tick_.erase(loots_tick_.begin() + (itFind - loots_info_.begin()));
+		loots_info_.erase(itFind);
+	}
+}
 
-		for(const auto& office : offices){
-			collision_detector::Item item(0, {(double)office.GetPosition().x, (double)office.GetPosition().y},
-										  baseWidth, collision_detector::ItemType::Office);
-			items.push_back(item);
+void GameSession::MoveDogs(int deltaTime){
+	InvalidateCachedState();
+	near_items_.clear();
+	items_batch_.Clear();
+	gatherers_batch_.Clear();
+	moving_dogs_.clear();
+
+	for(auto& player : players_){
+		Dog& dog = *player->GetDog();
+		// только движущаяся собака меняет положение, скорость, рюкзак и очки
+		if(dog.IsMoving()){
+			player->MarkChanged(GetChangeTick());
 		}
-	}
+		std::optional<collision_detector::Gatherer> gatherer = dog.Move(deltaTime);
+		if(!gatherer)
+			continue;
 
-	collision_detector::ItemGatherer item_gath(items, {gatherer});
-	const auto& ev = collision_detector::FindGatherEvents(item_gath);
+		const size_t first_item = near_items_.size();
+		items_grid_.FindNear(*gatherer, nearItemsMargin, near_items_);
 
-	std::vector<collision_detector::Item> result;
+		for(size_t i = first_item; i < near_items_.size(); ++i){
+			items_batch_.Add(near_items_[i]);
+		}
 
-	for(size_t i =0; i < ev.size(); ++i){
-		result.push_back(item_gath.GetItem(ev[i].item_id));
+		gatherers_batch_.Add(*gatherer, {first_item, near_items_.size()});
+		moving_dogs_.push_back(&dog);
 	}
 
-	return result;
-}
-
-void GameSession::MoveDogs(int deltaTime){
-	std::for_each(players_.begin(), players_.end(), [this, deltaTime](std::shared_ptr<Player>& player){
-		std::optional<collision_detector::Gatherer> gatherer = player->GetDog()->Move(deltaTime);
-		if(!gatherer)
-			return;
+	if(items_batch_.Size() == 0){
+		return;
+	}
 
-		auto items = GetGatheredItems(*gatherer, loots_info_, map_);
-		AddLootToDog(player->GetDog(), loots_info_, items);
-	});
+	// События всех собак тика обрабатываются в порядке времени
+	for(const auto& event : collision_detector::FindGatherEvents(gatherers_batch_, items_batch_)){
+		GatherItem(*moving_dogs_[event.gatherer_id], near_items_[event.item_id]);
+	}
 }
 
 void GameSession::InitLootGenerator(double loot_period, double loot_probability){
@@ -155,7 +220,6 @@ model::LootInfo GenerateLootInfo(const Map* pMap){
 		throw logic_error("No loot specified for the map!");
 	}
 
-	static unsigned loot_id = 0;
 	auto loot_type = utils::GetRandomNumber<size_t>(0, num_loots-1);
 
 	size_t num_roads = pMap->GetNumRoads();
@@ -184,10 +248,7 @@ model::LootInfo GenerateLootInfo(const Map* pMap){
 		y = utils::GetRandomNumber<int>(start.y, end.y);
 	}
 
-	model::LootInfo loot_info(loot_id, loot_type, x, y);
-	loot_id++;
-
-	return loot_info;
+	return model::LootInfo(next_loot_id++, loot_type, x, y);
 }
 
 
@@ -195,8 +256,11 @@ void GameSession::GenerateLoot(int deltaTime, const Map* pMap){
 	auto num_loot_to_generate = lootGen_->Generate(loot_gen::LootGenerator::TimeInterval{deltaTime}, loots_info_.size(), players_.size());
 
 	while(num_loot_to_generate > 0){
-		loots_info_.push_back(GenerateLootInfo(pMap));
+		const auto& loot = loots_info_.emplace_back(GenerateLootInfo(pMap));
+		loots_tick_.push_back(GetChangeTick());
+		items_grid_.Add(collision_detector::Item(loot.id, {loot.x, loot.y}, lootWidth));
 		num_loot_to_generate--;
+		InvalidateCachedState();
 	}
 }
  
@@ -207,6 +271,7 @@ GameSessionState GameSession::GetState() const{
 	state.map_id_ = map_id_;
 	state.player_id_ = player_id;
 
+	state.player_state_.reserve(players_.size());
 	for(const auto& player : players_){
 		state.player_state_.push_back(player->GetState());
 	}
@@ -218,15 +283,120 @@ PlayerState Player::GetState(){
 	return PlayerState(name_, token_, id_, dog_);
 }
 
+std::vector<std::shared_ptr<Player>> GameSession::FindExpiredPlayers(double retirement_time){
+	std::vector<std::shared_ptr<Player>> res;
+
+	for(const auto& player : players_){
+		if(player->GetDog()->GetIdleTime() >= retirement_time){
+			res.push_back(player);
+		}
+	}
+
+	return res;
+}
+
+bool GameSession::EnqueueAction(Player& player, DogDirection dir){
+	// Место в очереди занимается раньше, чем направление увидят другие запросы: запрос, заставший
+	// ждущее направление, полагается на запись в очереди, и откатывать её уже нельзя
+	if(actions_.TryReserve()){
+		if(player.SetPendingDirection(dir)){
+			actions_.PushReserved(PlayerAction{player.GetId()});
+		}else{
+			// Игрок, уже ждущий тика, только меняет направление: его запись в очереди одна
+			actions_.CancelReservation();
+		}
+	}else if(!player.ReplacePendingDirection(dir)){
+		return false;
+	}
+	InvalidateCachedState();
+	return true;
+}
+
+size_t GameSession::ApplyPendingActions(double dog_speed){
+	const size_t applied = actions_.Drain([this, dog_speed](PlayerAction action){
+		// игроки хранятся по возрастанию id: новые добавляются в конец, восстановление сохраняет порядок
+		auto it = std::lower_bound(players_.begin(), players_.end(), action.player_id,
+								   [](const std::shared_ptr<Player>& player, unsigned id){ return player->GetId() < id; });
+		if((it == players_.end()) || ((*it)->GetId() != action.player_id)){
+			return;
+		}
+		if(auto dir = (*it)->TakePendingDirection()){
+			(*it)->GetDog()->SetSpeed(*dir, dog_speed);
+			(*it)->MarkChanged(GetChangeTick());
+		}
+	});
+
+	if(applied > 0){
+		InvalidateCachedState();
+	}
+	return applied;
+}
+
+bool GameSession::HasPlayer(const Player& player) const {
+	// игроки хранятся по возрастанию id
+	auto it = std::lower_bound(players_.begin(), players_.end(), player.GetId(),
+							   [](const std::shared_ptr<Player>& lhs, unsigned id){ return lhs->GetId() < id; });
+	return (it != players_.end()) && (it->get() == &player);
+}
+
 void GameSession::DeleteRetiredPlayers(const std::vector<std::shared_ptr<Player>>& retired_players){
 	for(auto it = retired_players.begin(); it != retired_players.end(); ++it){
 		auto findIt = std::find(std::begin(players_), std::end(players_), *it);
 
 		if(findIt != std::end(players_)){
+			removed_players_.push_back({GetChangeTick(), (*findIt)->GetId()});
 			const auto new_end{std::remove(std::begin(players_), std::end(players_), *findIt)};
 			players_.erase(new_end, std::end(players_));
 		}
 	}
+	InvalidateCachedState();
+	InvalidateCachedPlayers();
+}
+
+void GameSession::FinishTick(){
+	++tick_;
+	// изменения старше окна разниц больше не нужны: клиенту с такой базой отдаётся всё состояние
+	auto expired = [this](const Removal& removal){ return removal.tick + MAX_DELTA_TICKS <= tick_;};
+	while(!removed_players_.empty() && expired(removed_players_.front())){
+		removed_players_.pop_front();
+	}
+	while(!removed_loots_.empty() && expired(removed_loots_.front())){
+		removed_loots_.pop_front();
+	}
+}
+
+StateDelta GameSession::GetChangesSince(std::uint64_t since_tick) const{
+	StateDelta delta;
+	delta.base_tick = since_tick;
+	delta.tick = tick_;
+	delta.full = (since_tick > tick_) || (since_tick + MAX_DELTA_TICKS < tick_);
+	const std::uint64_t base = delta.full ? 0 : since_tick;
+
+	for(const auto& player : players_){
+		if(delta.full || (player->GetChangedTick() > base)){
+			delta.players.push_back(player.get());
+		}
+	}
+	for(size_t i = 0; i < loots_info_.size(); ++i){
+		if(delta.full || (loots_tick_[i] > base)){
+			delta.loots.push_back(&loots_info_[i]);
+		}
+	}
+	if(delta.full){
+		return delta;
+	}
+
+	for(const auto& removal : removed_players_){
+		if(removal.tick > base){
+			delta.removed_players.push_back(removal.id);
+		}
+	}
+	for(const auto& removal : removed_loots_){
+		if(removal.tick > base){
+			delta.removed_loots.push_back(removal.id);
+		}
+	}
+	return delta;
 }
 
 }
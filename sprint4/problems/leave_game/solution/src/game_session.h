@@ -1,7 +1,16 @@
 #pragma once
 #include "dog.h"
+#include "spatial_index.h"
+#include "action_queue.h"
 #include <memory>
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <atomic>
+#include <optional>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
@@ -62,6 +71,8 @@ class Player{
 public:
 	Player(unsigned int id, const std::string& name, const std::string& token,
 		 const model::Map* map, bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
+	// Игрок из сохранения: собака создаётся сразу в сохранённом состоянии
+	Player(const PlayerState& state, const model::Map* map);
   	const std::string& GetToken() const  { return token_;}
   	void SetToken(const std::string& token) { token_ = token;}
   	const std::string& GetName() const  { return name_;}
@@ -70,12 +81,44 @@ public:
   	std::shared_ptr<Dog> GetDog() { return dog_;}
   	PlayerState GetState();
 
+  	// Направление из последней команды, ещё не применённой тиком. Может вызываться из любого потока.
+  	// Возвращает true, если до этой команды игрок не ждал применения другой
+  	bool SetPendingDirection(DogDirection dir) {
+  		return pending_direction_.exchange(static_cast<int>(dir), std::memory_order_acq_rel) == NO_PENDING_DIRECTION;
+  	}
+  	// Меняет направление, только если игрок уже ждёт применения команды
+  	bool ReplacePendingDirection(DogDirection dir) {
+  		int pending = pending_direction_.load(std::memory_order_acquire);
+  		while(pending != NO_PENDING_DIRECTION){
+  			if(pending_direction_.compare_exchange_weak(pending, static_cast<int>(dir), std::memory_order_acq_rel)){
+  				return true;
+  			}
+  		}
+  		return false;
+  	}
+  	std::optional<DogDirection> TakePendingDirection() {
+  		const int dir = pending_direction_.exchange(NO_PENDING_DIRECTION, std::memory_order_acq_rel);
+  		return dir == NO_PENDING_DIRECTION ? std::nullopt : std::optional{static_cast<DogDirection>(dir)};
+  	}
+
+  	// Тик, в котором последний раз изменилось видимое клиентам состояние собаки игрока
+  	std::uint64_t GetChangedTick() const { return changed_tick_;}
+  	void MarkChanged(std::uint64_t tick) { changed_tick_ = tick;}
+  	// Тик, в котором игрок вошёл в сессию
+  	std::uint64_t GetJoinedTick() const { return joined_tick_;}
+  	void MarkJoined(std::uint64_t tick) { joined_tick_ = changed_tick_ = tick;}
+
 private:
+	static constexpr int NO_PENDING_DIRECTION = -1;
+
 	std::string name_;
 	std::string token_;
 
 	unsigned int id_{0};
 	std::shared_ptr<Dog> dog_;
+	std::atomic<int> pending_direction_{NO_PENDING_DIRECTION};
+	std::uint64_t changed_tick_{0};
+	std::uint64_t joined_tick_{0};
 };
 
 struct GameSessionState{
@@ -109,11 +152,43 @@ private:
 };
 
 
+using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+// Формат снимков состояния: клиент выбирает его заголовком Accept
+enum class SnapshotFormat {
+	JSON,
+	BINARY,
+	COUNT
+};
+
+// Изменения сессии после тика base_tick. Указатели действительны до следующего изменения сессии на её strand
+struct StateDelta {
+	std::uint64_t base_tick{0};
+	std::uint64_t tick{0};
+	// база слишком старая или неизвестная: в players и loots всё состояние сессии
+	bool full{false};
+	std::vector<Player*> players;
+	std::vector<const LootInfo*> loots;
+	std::vector<unsigned> removed_players;
+	std::vector<unsigned> removed_loots;
+};
+
 class GameSession{
 public:
-	GameSession(const std::string& map_id, double loot_period, double loot_probability)
-	: map_id_(map_id)
+	GameSession(const std::string& map_id, double loot_period, double loot_probability,
+				std::optional<Strand> strand = std::nullopt)
+	: map_id_(map_id), strand_(std::move(strand))
 	{InitLootGenerator(loot_period, loot_probability);}
+
+	// Все изменения состояния сессии выполняются на её strand
+	bool HasStrand() const { return strand_.has_value();}
+	Strand& GetStrand() { return *strand_;}
+
+	// Число игроков, которые уже выбрали эту сессию, но ещё не добавлены в неё
+	void BeginJoin() { ++pending_joins_;}
+	void EndJoin() { --pending_joins_;}
+	unsigned GetPendingJoins() const { return pending_joins_;}
+
 	std::shared_ptr<Player> AddPlayer(const std::string player_name, model::Map* map,
 									  bool spawn_dog_in_random_point, unsigned defaultBagCapacity);
 	const std::string& GetMap() {return map_id_;}
@@ -128,19 +203,95 @@ public:
 
 	GameSessionState GetState() const;
 
+	// Игроки и трофеи из сохранения. В отличие от AddPlayer не ищет игрока по имени,
+	// не выдаёт токен и не выбирает точку появления. Вызывается до начала тиков
+	void RestoreState(const GameSessionState& state, model::Map* map);
+
 	void SetPlayerId(unsigned int id) { player_id = id;}
-	void SetLootsInfo(const std::vector<LootInfo>& loots) {loots_info_ = loots;}
+	unsigned int GetNextPlayerId() const { return player_id;}
+	void SetLootsInfo(const std::vector<LootInfo>& loots);
 
 	const std::vector<std::shared_ptr<Player>>& GetPlayers() { return players_;}
+	// Игрок ещё в сессии, а не ушёл из неё. Вызывается на strand сессии
+	bool HasPlayer(const Player& player) const;
+
+	// Номер последнего завершённого тика. Изменения между тиками относятся к следующему тику
+	std::uint64_t GetTick() const { return tick_;}
+	void FinishTick();
+	// Разница со состоянием после тика since_tick: изменённые и удалённые после него игроки и трофеи.
+	// Для базы старше MAX_DELTA_TICKS тиков возвращается полное состояние
+	StateDelta GetChangesSince(std::uint64_t since_tick) const;
+	static constexpr std::uint64_t MAX_DELTA_TICKS = 256;
+	std::vector<std::shared_ptr<Player>> FindExpiredPlayers(double retirement_time);
 	void DeleteRetiredPlayers(const std::vector<std::shared_ptr<model::Player>>& retired_players);
+
+	// Ставит команду игрока в очередь сессии, не заходя в strand.
+	// false - очередь переполнена, а игрок не ждёт применения другой команды
+	bool EnqueueAction(Player& player, DogDirection dir);
+	// Применяет накопленные команды на strand сессии, обычно в начале тика
+	size_t ApplyPendingActions(double dog_speed);
+	const ActionQueue& GetActionQueue() const { return actions_;}
+
+	// Сериализованное состояние сессии, общее для всех запросов до её следующего изменения.
+	// Снимки публикуются на strand сессии, а читаются из любого потока без захода в strand.
+	// Для каждого формата ответа хранится свой снимок, изменение сессии сбрасывает все
+	std::shared_ptr<const std::string> GetCachedState(SnapshotFormat format = SnapshotFormat::JSON) const {
+		return cached_state_[static_cast<size_t>(format)].load(std::memory_order_acquire);
+	}
+	void SetCachedState(std::shared_ptr<const std::string> state, SnapshotFormat format = SnapshotFormat::JSON) {
+		cached_state_[static_cast<size_t>(format)].store(std::move(state), std::memory_order_release);
+	}
+	void InvalidateCachedState() {
+		for(auto& state : cached_state_){
+			state.store(nullptr, std::memory_order_release);
+		}
+	}
+
+	// Список игроков меняется только при входе и уходе игроков
+	std::shared_ptr<const std::string> GetCachedPlayers(SnapshotFormat format = SnapshotFormat::JSON) const {
+		return cached_players_[static_cast<size_t>(format)].load(std::memory_order_acquire);
+	}
+	void SetCachedPlayers(std::shared_ptr<const std::string> players, SnapshotFormat format = SnapshotFormat::JSON) {
+		cached_players_[static_cast<size_t>(format)].store(std::move(players), std::memory_order_release);
+	}
+	void InvalidateCachedPlayers() {
+		for(auto& players : cached_players_){
+			players.store(nullptr, std::memory_order_release);
+		}
+	}
 	
 private:
 	void InitLootGenerator(double loot_period, double loot_probability);
+	void InitOffices(const model::Map* map);
+	void GatherItem(Dog& dog, const collision_detector::Item& item);
+	std::uint64_t GetChangeTick() const { return tick_ + 1;}
+
+	// Удалённая сущность помнится MAX_DELTA_TICKS тиков, чтобы попасть в разницу для клиентов
+	struct Removal {
+		std::uint64_t tick;
+		unsigned id;
+	};
+
 	std::vector<std::shared_ptr<Player>> players_;
 	std::vector<LootInfo> loots_info_;
+	// тик появления трофея, параллельно loots_info_
+	std::vector<std::uint64_t> loots_tick_;
+	std::deque<Removal> removed_players_;
+	std::deque<Removal> removed_loots_;
+	std::uint64_t tick_{0};
 	std::string map_id_;
 	unsigned int player_id = 0;
 	model::Map* map_{};
 	std::shared_ptr<loot_gen::LootGenerator> lootGen_;
+	std::optional<Strand> strand_;
+	std::atomic<unsigned> pending_joins_{0};
+	collision_detector::ItemsGrid items_grid_;
+	std::vector<collision_detector::Item> near_items_;
+	collision_detector::ItemsBatch items_batch_;
+	collision_detector::GatherersBatch gatherers_batch_;
+	std::vector<Dog*> moving_dogs_;
+	std::array<std::atomic<std::shared_ptr<const std::string>>, static_cast<size_t>(SnapshotFormat::COUNT)> cached_state_;
+	std::array<std::atomic<std::shared_ptr<const std::string>>, static_cast<size_t>(SnapshotFormat::COUNT)> cached_players_;
+	ActionQueue actions_;
 };
 }
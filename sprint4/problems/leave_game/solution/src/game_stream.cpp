@@ -0,0 +1,220 @@
+#include "game_stream.h"
+#include "game_session.h"
+#include "json_serializer.h"
+#include "binary_serializer.h"
+#include "model.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <algorithm>
+
+namespace http_handler {
+
+std::shared_ptr<const std::string> GetStateSnapshot(model::Game& game, const std::shared_ptr<model::GameSession>& session,
+													model::SnapshotFormat format, bool apply_pending){
+	// Без таймера тиков состояние показывает уже принятые команды, даже если тика ещё не было
+	const auto actions_pushed = session->GetActionQueue().GetPushedCount();
+	if(apply_pending){
+		game.ApplyPendingActions(session);
+	}
+
+	auto state = session->GetCachedState(format);
+	if(!state){
+		const auto& players = session->GetPlayers();
+		const auto& loots = session->GetLootsInfo();
+		state = std::make_shared<const std::string>(format == model::SnapshotFormat::BINARY
+													? binary_serializer::GetPlayersDogInfoResponce(players, loots)
+													: json_serializer::GetPlayersDogInfoResponce(players, loots));
+		// команда, поставленная во время сериализации, уже сбросила снимок, и этот публиковать нельзя
+		if(session->GetActionQueue().GetPushedCount() == actions_pushed){
+			session->SetCachedState(state, format);
+		}
+	}
+	return state;
+}
+
+GameStreamSession::GameStreamSession(http_server::SessionStream&& stream, const model::PlayerHandle& handle)
+	: ws_(std::move(stream)), session_(handle.session), player_(handle.player){
+}
+
+void GameStreamSession::Push(std::shared_ptr<const std::string> frame){
+	if(IsClosed()){
+		return;
+	}
+	boost::asio::dispatch(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+		self->Send(std::move(frame));
+	});
+}
+
+void GameStreamSession::Stop(){
+	if(IsClosed()){
+		return;
+	}
+	boost::asio::dispatch(ws_.get_executor(), [self = shared_from_this()]{
+		self->CloseGracefully();
+	});
+}
+
+void GameStreamSession::OnAccept(beast::error_code ec){
+	if(ec){
+		closed_ = true;
+		return;
+	}
+
+	accepted_ = true;
+	ws_.text(true);
+	Read();
+	if(pending_){
+		writing_ = std::move(pending_);
+		Write();
+	}
+}
+
+void GameStreamSession::Read(){
+	ws_.async_read_some(read_buffer_, READ_CHUNK_SIZE, beast::bind_front_handler(&GameStreamSession::OnRead, shared_from_this()));
+}
+
+void GameStreamSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read){
+	// чтение заканчивается, когда клиент закрыл соединение или оно разорвано
+	if(ec){
+		closed_ = true;
+		return;
+	}
+	// чтение нужно для управляющих кадров и закрытия, а данные клиента отбрасываются,
+	// поэтому буфер не растёт, каким бы длинным ни было сообщение
+	read_buffer_.consume(read_buffer_.size());
+	Read();
+}
+
+void GameStreamSession::Send(std::shared_ptr<const std::string>&& frame){
+	if(IsClosed()){
+		return;
+	}
+
+	if(!accepted_ || writing_){
+		if(pending_){
+			dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+			if(++skipped_in_row_ > MAX_SKIPPED_FRAMES){
+				return Close();
+			}
+		}
+		pending_ = std::move(frame);
+		return;
+	}
+
+	writing_ = std::move(frame);
+	Write();
+}
+
+void GameStreamSession::Write(){
+	ws_.async_write(boost::asio::buffer(*writing_), beast::bind_front_handler(&GameStreamSession::OnWrite, shared_from_this()));
+}
+
+void GameStreamSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written){
+	writing_.reset();
+	if(ec){
+		closed_ = true;
+		pending_.reset();
+		return;
+	}
+
+	sent_frames_.fetch_add(1, std::memory_order_relaxed);
+	skipped_in_row_ = 0;
+	if(pending_){
+		writing_ = std::move(pending_);
+		Write();
+	}
+}
+
+void GameStreamSession::Close(){
+	closed_ = true;
+	pending_.reset();
+	// запись медленному клиенту ещё идёт, поэтому вместо закрывающего кадра сокет закрывается сразу
+	ws_.next_layer().close();
+}
+
+void GameStreamSession::CloseGracefully(){
+	if(IsClosed()){
+		return;
+	}
+	// закрывающий кадр не может обогнать начатую запись, и тогда сокет закрывается сразу
+	if(!accepted_ || writing_){
+		return Close();
+	}
+	closed_ = true;
+	pending_.reset();
+	ws_.async_close(websocket::close_code::normal, [self = shared_from_this()](beast::error_code){});
+}
+
+void GameStreamHub::Subscribe(std::shared_ptr<GameStreamSession> subscriber){
+	if(auto state = subscriber->GetGameSession()->GetCachedState()){
+		subscriber->Push(std::move(state));
+	}
+
+	std::lock_guard lock(mutex_);
+	subscribers_[subscriber->GetGameSession().get()].push_back(std::move(subscriber));
+}
+
+void GameStreamHub::OnSessionTick(const std::shared_ptr<model::GameSession>& session){
+	DropLeftPlayers(*session);
+	if(GetSubscribersCount(*session) == 0){
+		return;
+	}
+	// команды, пришедшие после тика, ждут следующего
+	Publish(*session, GetStateSnapshot(game_, session, model::SnapshotFormat::JSON, false));
+}
+
+void GameStreamHub::Publish(const model::GameSession& session, const std::shared_ptr<const std::string>& frame){
+	std::lock_guard lock(mutex_);
+	auto it = subscribers_.find(&session);
+	if(it == subscribers_.end()){
+		return;
+	}
+
+	auto& subscribers = it->second;
+	std::erase_if(subscribers, [&frame](const std::weak_ptr<GameStreamSession>& weak){
+		auto subscriber = weak.lock();
+		if(!subscriber || subscriber->IsClosed()){
+			return true;
+		}
+		subscriber->Push(frame);
+		return false;
+	});
+
+	if(subscribers.empty()){
+		subscribers_.erase(it);
+	}
+}
+
+void GameStreamHub::DropLeftPlayers(const model::GameSession& session){
+	std::lock_guard lock(mutex_);
+	auto it = subscribers_.find(&session);
+	if(it == subscribers_.end()){
+		return;
+	}
+
+	auto& subscribers = it->second;
+	std::erase_if(subscribers, [&session](const std::weak_ptr<GameStreamSession>& weak){
+		auto subscriber = weak.lock();
+		if(!subscriber || subscriber->IsClosed()){
+			return true;
+		}
+		// игрок ушёл на пенсию: его токена больше нет, и состояние ему не положено
+		if(!session.HasPlayer(subscriber->GetPlayer())){
+			subscriber->Stop();
+			return true;
+		}
+		return false;
+	});
+
+	if(subscribers.empty()){
+		subscribers_.erase(it);
+	}
+}
+
+size_t GameStreamHub::GetSubscribersCount(const model::GameSession& session) const {
+	std::lock_guard lock(mutex_);
+	auto it = subscribers_.find(&session);
+	return it == subscribers_.end() ? 0 : it->second.size();
+}
+
+}  // namespace http_handler
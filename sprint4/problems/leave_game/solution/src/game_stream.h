@@ -0,0 +1,123 @@
+#pragma once
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "pending_response.h"
+
+namespace model {
+	class Game;
+	class GameSession;
+	class Player;
+	struct PlayerHandle;
+	enum class SnapshotFormat;
+}
+
+namespace http_handler {
+
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+
+// Снимок состояния сессии для опроса и для подписчиков: готовый или построенный заново.
+// Вызывается на strand сессии. apply_pending - применить принятые команды до снимка: только без таймера тиков,
+// иначе команды ждут начала следующего тика
+std::shared_ptr<const std::string> GetStateSnapshot(model::Game& game, const std::shared_ptr<model::GameSession>& session,
+													model::SnapshotFormat format, bool apply_pending);
+
+/*
+ *  WebSocket-подписчик на состояние игровой сессии от имени её игрока.
+ *  Отправляется не больше одного кадра за раз и хранится не больше одного ожидающего:
+ *  новый кадр заменяет ожидающий, так что медленный клиент пропускает тики, а не копит очередь.
+ *  Когда игрок уходит из сессии, поток закрывается.
+ */
+class GameStreamSession : public std::enable_shared_from_this<GameStreamSession> {
+public:
+	using WebSocket = websocket::stream<http_server::SessionStream>;
+
+	// Клиент, пропустивший столько кадров подряд, не успевает за игрой и отключается
+	static constexpr size_t MAX_SKIPPED_FRAMES = 100;
+	// Сообщения клиента не используются и читаются частями не больше этой
+	static constexpr size_t READ_CHUNK_SIZE = 512;
+
+	GameStreamSession(http_server::SessionStream&& stream, const model::PlayerHandle& handle);
+
+	// Принимает рукопожатие. Запрос нужен только на время вызова: ответ строится сразу
+	template <typename Request>
+	void Run(const Request& request) {
+		// таймауты HTTP больше не действуют, соединение проверяется ping-ами websocket
+		ws_.next_layer().expires_never();
+		ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+		ws_.async_accept(request, beast::bind_front_handler(&GameStreamSession::OnAccept, shared_from_this()));
+	}
+
+	// Может вызываться из любого потока: кадр передаётся в strand соединения
+	void Push(std::shared_ptr<const std::string> frame);
+	// Закрывает поток после уже начатой записи. Может вызываться из любого потока
+	void Stop();
+
+	const std::shared_ptr<model::GameSession>& GetGameSession() const { return session_;}
+	const model::Player& GetPlayer() const { return *player_;}
+	bool IsClosed() const { return closed_.load(std::memory_order_acquire);}
+	std::uint64_t GetSentFrames() const { return sent_frames_.load(std::memory_order_relaxed);}
+	std::uint64_t GetDroppedFrames() const { return dropped_frames_.load(std::memory_order_relaxed);}
+
+private:
+	void OnAccept(beast::error_code ec);
+	void Read();
+	void OnRead(beast::error_code ec, std::size_t bytes_read);
+	void Send(std::shared_ptr<const std::string>&& frame);
+	void Write();
+	void OnWrite(beast::error_code ec, std::size_t bytes_written);
+	void Close();
+	void CloseGracefully();
+
+	WebSocket ws_;
+	// подписчик держит сессию: её адрес - ключ подписки и не может достаться другой сессии
+	std::shared_ptr<model::GameSession> session_;
+	std::shared_ptr<model::Player> player_;
+	beast::flat_buffer read_buffer_;
+	std::shared_ptr<const std::string> writing_;
+	std::shared_ptr<const std::string> pending_;
+	bool accepted_{false};
+	size_t skipped_in_row_{0};
+	std::atomic<bool> closed_{false};
+	std::atomic<std::uint64_t> sent_frames_{0};
+	std::atomic<std::uint64_t> dropped_frames_{0};
+};
+
+/*
+ *  Подписчики игровых сессий. После тика состояние сессии сериализуется один раз,
+ *  и один и тот же кадр раздаётся всем её подписчикам.
+ */
+class GameStreamHub {
+public:
+	explicit GameStreamHub(model::Game& game) : game_(game) {}
+
+	GameStreamHub(const GameStreamHub&) = delete;
+	GameStreamHub& operator=(const GameStreamHub&) = delete;
+
+	// Новый подписчик сразу получает последний готовый снимок, если он есть
+	void Subscribe(std::shared_ptr<GameStreamSession> subscriber);
+	// Вызывается на strand сессии после её тика: закрывает потоки ушедших игроков и рассылает состояние.
+	// Без подписчиков состояние не сериализуется
+	void OnSessionTick(const std::shared_ptr<model::GameSession>& session);
+	// Раздаёт кадр подписчикам сессии и забывает закрытых
+	void Publish(const model::GameSession& session, const std::shared_ptr<const std::string>& frame);
+	size_t GetSubscribersCount(const model::GameSession& session) const;
+
+private:
+	// Закрывает и забывает подписчиков, чьих игроков уже нет в сессии. Вызывается на strand сессии
+	void DropLeftPlayers(const model::GameSession& session);
+
+	model::Game& game_;
+	mutable std::mutex mutex_;
+	std::unordered_map<const model::GameSession*, std::vector<std::weak_ptr<GameStreamSession>>> subscribers_;
+};
+
+}  // namespace http_handler
@@ -1,6 +1,8 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/write.hpp>
+#include <utility>
 using namespace std::literals;
 
 
@@ -11,39 +13,230 @@ namespace http_server {
     }
 
     void SessionBase::Read() {
-        request_ = {};
-        stream_.expires_after(30s);
-        http::async_read(stream_, buffer_, request_,
-        beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+        // Новые запросы не читаются, пока слишком много ответов ждут отправки
+        if (GetRequestsInFlight() >= MAX_PIPELINED_REQUESTS) {
+            read_paused_ = true;
+            return;
+        }
+
+        // Тело прошлого запроса отдаёт свою ёмкость следующему, заголовки освобождаются вместе с ареной
+        std::string body;
+        if (request_) {
+            body = std::move(request_->body());
+            body.clear();
+            request_.reset();
+        }
+        arena_.Reset();
+
+        parser_.emplace(std::piecewise_construct, std::forward_as_tuple(std::move(body)),
+                        std::forward_as_tuple(RequestAllocator{&arena_}));
+
+        if (buffer_.size() > 0) {
+            return ContinueRead();
+        }
+
+        // keep-alive соединение простаивает до первого байта следующего запроса
+        if (next_request_seq_ > 0) {
+            read_phase_ = ReadPhase::IDLE;
+            stream_.expires_after(tracker_->GetLimits().keep_alive_timeout);
+            return stream_.async_read_some(buffer_.prepare(IDLE_READ_SIZE),
+            MakePooledHandler(handler_memory_, beast::bind_front_handler(&SessionBase::OnIdleRead, GetSharedThis())));
+        }
+
+        ReadHeader();
     }
 
+    void SessionBase::OnIdleRead(beast::error_code ec, std::size_t bytes_read) {
+        if (ec) {
+            return OnRead(ec, bytes_read);
+        }
+        buffer_.commit(bytes_read);
+        ContinueRead();
+    }
 
-    void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
-        if (ec == http::error::end_of_stream) {
-            return Close();
+    void SessionBase::ContinueRead() {
+        // Запрос, уже целиком лежащий в буфере, разбирается без новой операции чтения
+        beast::error_code ec;
+        while ((buffer_.size() > 0) && !parser_->is_done()) {
+            const std::size_t used = parser_->put(buffer_.data(), ec);
+            buffer_.consume(used);
+            if (ec == http::error::need_more) {
+                ec = {};
+                break;
+            }
+            if (ec || (used == 0)) {
+                break;
+            }
         }
 
+        if (ec || parser_->is_done()) {
+            return OnRead(ec, 0);
+        }
+        if (parser_->is_header_done()) {
+            return ReadBody();
+        }
+        ReadHeader();
+    }
+
+    void SessionBase::ReadHeader() {
+        read_phase_ = ReadPhase::HEADER;
+        stream_.expires_after(tracker_->GetLimits().header_timeout);
+        http::async_read_header(stream_, buffer_, *parser_,
+        MakePooledHandler(handler_memory_, beast::bind_front_handler(&SessionBase::OnReadHeader, GetSharedThis())));
+    }
+
+    void SessionBase::OnReadHeader(beast::error_code ec, std::size_t bytes_read) {
+        if (ec || parser_->is_done()) {
+            return OnRead(ec, bytes_read);
+        }
+        ReadBody();
+    }
+
+    void SessionBase::ReadBody() {
+        read_phase_ = ReadPhase::BODY;
+        stream_.expires_after(tracker_->GetLimits().body_timeout);
+        http::async_read(stream_, buffer_, *parser_,
+        MakePooledHandler(handler_memory_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis())));
+    }
+
+    void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
         if (ec) {
-            return ReportError(ec, "read"sv);
+            read_finished_ = true;
+            if (closed_) {
+                return;
+            }
+
+            if (ec == beast::error::timeout) {
+                // поток уже закрыт по таймауту, ответы этому клиенту не отправить
+                closed_ = true;
+                switch (read_phase_) {
+                    case ReadPhase::IDLE: return SetCloseReason(CloseReason::KEEP_ALIVE_TIMEOUT);
+                    case ReadPhase::HEADER: return SetCloseReason(CloseReason::HEADER_TIMEOUT);
+                    case ReadPhase::BODY: return SetCloseReason(CloseReason::BODY_TIMEOUT);
+                }
+                return;
+            }
+
+            if ((ec != http::error::end_of_stream) && (ec != net::error::eof)) {
+                SetCloseReason(CloseReason::READ_ERROR);
+                return ReportError(ec, "read"sv);
+            }
+
+            // клиент закончил передачу: соединение закрывается после отправки всех ответов
+            SetCloseReason(CloseReason::CLIENT_CLOSED);
+            if (GetRequestsInFlight() == 0) {
+                Close();
+            }
+            return;
+        }
+
+        request_.emplace(parser_->release());
+        parser_.reset();
+
+        // Соединение переходит к WebSocket, только когда все предыдущие ответы уже отправлены
+        if (beast::websocket::is_upgrade(*request_) && (GetRequestsInFlight() == 0) && TryUpgrade(*request_, stream_)) {
+            closed_ = true;
+            read_finished_ = true;
+            return SetCloseReason(CloseReason::UPGRADED);
+        }
+
+        const std::uint64_t request_seq = next_request_seq_++;
+
+        const bool keep_alive = request_->keep_alive();
+        HandleRequest(std::move(*request_), request_seq);
+
+        // Запросы, уже лежащие в буфере, разбираются сразу, не дожидаясь ответа на этот
+        if (keep_alive) {
+            Read();
+        } else {
+            read_finished_ = true;
+            SetCloseReason(CloseReason::NOT_KEEP_ALIVE);
         }
-        HandleRequest(std::move(request_));
     }
 
-    void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    void SessionBase::EnqueueResponse(std::uint64_t request_seq, PendingResponsePtr&& response) {
+        GetResponseSlot(request_seq) = std::move(response);
+        Flush();
+    }
+
+    void SessionBase::Flush() {
+        if (closed_ || (responses_in_write_ > 0) || (GetRequestsInFlight() == 0)) {
+            return;
+        }
+
+        auto& first = GetResponseSlot(next_write_seq_);
+        if (!first) {
+            return;
+        }
+
+        // Ответ, который нельзя склеить с другими (например, файл), отправляется отдельно
+        stream_.expires_after(tracker_->GetLimits().write_timeout);
+        if (!first->CanGather()) {
+            responses_in_write_ = 1;
+            return first->AsyncWrite(stream_, MakePooledHandler(handler_memory_, WriteCompletion{GetSharedThis()}));
+        }
+
+        write_buffers_.clear();
+        for (std::uint64_t seq = next_write_seq_; seq < next_request_seq_; ++seq) {
+            auto& response = GetResponseSlot(seq);
+            if (!response || !response->CanGather()) {
+                break;
+            }
+
+            response->AppendBuffers(write_buffers_);
+            ++responses_in_write_;
+            if (response->NeedEof()) {
+                break;
+            }
+        }
+
+        net::async_write(stream_, BuffersView(write_buffers_), MakePooledHandler(handler_memory_, WriteCompletion{GetSharedThis()}));
+    }
+
+    void SessionBase::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
         if (ec) {
+            closed_ = true;
+            if (ec == beast::error::timeout) {
+                return SetCloseReason(CloseReason::WRITE_TIMEOUT);
+            }
+            SetCloseReason(CloseReason::WRITE_ERROR);
             return ReportError(ec, "write"sv);
         }
 
+        bool close = false;
+        for (size_t i = 0; i < responses_in_write_; ++i) {
+            auto& response = GetResponseSlot(next_write_seq_++);
+            close = close || response->NeedEof();
+            response.reset();
+        }
+        responses_in_write_ = 0;
+
         if (close) {
+            SetCloseReason(CloseReason::NOT_KEEP_ALIVE);
+            return Close();
+        }
+        if (read_finished_ && (GetRequestsInFlight() == 0)) {
             return Close();
         }
 
-        Read();
+        if (read_paused_) {
+            read_paused_ = false;
+            Read();
+        }
+
+        Flush();
+    }
+
+    void WriteCompletion::operator()(beast::error_code ec, std::size_t bytes_written) {
+        session->OnWrite(ec, bytes_written);
     }
 
     void SessionBase::Close() {
+        closed_ = true;
         beast::error_code ec;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+        // ожидающее чтение больше не нужно: сессия завершится вместе с ним
+        stream_.cancel();
     }
 
     void SessionBase::Run() {
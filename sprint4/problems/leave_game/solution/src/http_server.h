@@ -1,11 +1,22 @@
 #pragma once
 #include "sdk.h"
 #define BOOST_BEAST_USE_STD_STRING_VIEW
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket/rfc6455.hpp>
+#include <array>
+#include <concepts>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include "connection_arena.h"
+#include "connection_tracker.h"
+#include "io_context_pool.h"
+#include "pending_response.h"
 
 namespace http_server {
 
@@ -16,6 +27,14 @@ namespace http = beast::http;
 
     void ReportError(beast::error_code ec, std::string_view what);
 
+// SO_REUSEPORT: несколько acceptor-ов слушают один порт, ядро распределяет между ними соединения
+using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+/*
+ *  HTTP-сессия с конвейерной обработкой: следующий запрос читается, не дожидаясь ответа на предыдущий.
+ *  Ответы могут готовиться в разных strand, но отправляются строго в порядке запросов;
+ *  готовые подряд ответы с телом в памяти уходят одной записью.
+ */
 class SessionBase {
 public:
     SessionBase(const SessionBase&) = delete;
@@ -23,55 +42,121 @@ public:
     void Run();
 
 protected:
-    explicit SessionBase(tcp::socket&& socket)
-        : stream_(std::move(socket)) {
+    SessionBase(SessionSocket&& socket, std::shared_ptr<ConnectionTracker> tracker)
+        : tracker_(std::move(tracker))
+        , stream_(std::move(socket)) {
     }    
 
+   // Может вызываться из любого потока: ответ передаётся в strand сессии
    template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields>&& response) {
-        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
-
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                              self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                          });
+    void Write(std::uint64_t request_seq, http::response<Body, Fields>&& response) {
+        auto pending = MakePendingResponse(handler_memory_, std::move(response));
+
+        net::dispatch(stream_.get_executor(), MakePooledHandler(handler_memory_,
+                      [self = GetSharedThis(), request_seq, pending = std::move(pending)]() mutable {
+                          self->EnqueueResponse(request_seq, std::move(pending));
+                      }));
     }
 
-    using HttpRequest = http::request<http::string_body>;
+    // Заголовки запроса размещаются в арене соединения
+    using RequestAllocator = ArenaAllocator<char>;
+    using HttpRequest = http::request<http::string_body, http::basic_fields<RequestAllocator>>;
 
-    ~SessionBase() = default;
+    ~SessionBase() {
+        // соединение, закрытое без явной причины, пережило остановку сервера
+        tracker_->OnClosed(close_reason_.value_or(CloseReason::SHUTDOWN));
+    }
 
 private:
+    friend struct WriteCompletion;
+
+    // Ограничение числа запросов, ответы на которые ещё не отправлены
+    static constexpr size_t MAX_PIPELINED_REQUESTS = 16;
+    // сколько байт читается при ожидании следующего запроса keep-alive
+    static constexpr size_t IDLE_READ_SIZE = 4096;
+
+    // Этап чтения определяет таймаут и причину закрытия при его срабатывании
+    enum class ReadPhase {
+        IDLE,
+        HEADER,
+        BODY
+    };
+
     void Read();
+    void OnIdleRead(beast::error_code ec, std::size_t bytes_read);
+    void ContinueRead();
+    void ReadHeader();
+    void OnReadHeader(beast::error_code ec, std::size_t bytes_read);
+    void ReadBody();
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
-    void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    void EnqueueResponse(std::uint64_t request_seq, PendingResponsePtr&& response);
+    void Flush();
+    void OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
     void Close();
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    // Запоминается первая причина: последующие ошибки - её следствие
+    void SetCloseReason(CloseReason reason) {
+        if (!close_reason_) {
+            close_reason_ = reason;
+        }
+    }
+    size_t GetRequestsInFlight() const noexcept { return next_request_seq_ - next_write_seq_; }
+    PendingResponsePtr& GetResponseSlot(std::uint64_t request_seq) { return responses_[request_seq % MAX_PIPELINED_REQUESTS]; }
+    virtual void HandleRequest(HttpRequest&& request, std::uint64_t request_seq) = 0;
+    // Передаёт поток обработчику WebSocket. false - обработчик отказался, и запрос обрабатывается как обычный
+    virtual bool TryUpgrade(const HttpRequest& request, SessionStream& stream) = 0;
     
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;    
 
-    beast::tcp_stream stream_;
+    std::shared_ptr<ConnectionTracker> tracker_;
+    std::optional<CloseReason> close_reason_;
+    ReadPhase read_phase_{ReadPhase::HEADER};
+
+    // арена и пул объявлены первыми, чтобы пережить запрос, парсер, ответы и операции потока
+    ConnectionArena arena_;
+    HandlerMemoryPool handler_memory_;
+    SessionStream stream_;
     beast::flat_buffer buffer_;
-    HttpRequest request_;    
+    std::optional<http::request_parser<http::string_body, RequestAllocator>> parser_;
+    std::optional<HttpRequest> request_;
+
+    // Кольцо ответов по номерам запросов: [next_write_seq_, next_request_seq_)
+    std::array<PendingResponsePtr, MAX_PIPELINED_REQUESTS> responses_;
+    std::uint64_t next_request_seq_{0};
+    std::uint64_t next_write_seq_{0};
+    // число ответов из начала очереди, которые сейчас записываются
+    size_t responses_in_write_{0};
+    std::vector<net::const_buffer> write_buffers_;
+
+    bool read_paused_{false};
+    bool read_finished_{false};
+    bool closed_{false};
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
 public:
     template <typename Handler>
-    Session(tcp::socket&& socket, Handler&& request_handler)
-        : SessionBase(std::move(socket))
+    Session(SessionSocket&& socket, std::shared_ptr<ConnectionTracker> tracker, Handler&& request_handler)
+        : SessionBase(std::move(socket), std::move(tracker))
         , request_handler_(std::forward<Handler>(request_handler)) {
     }	
     
 private:
-    void HandleRequest(HttpRequest&& request) override {
-        request_handler_(std::move(request), [self = this->shared_from_this()](auto&& response) {
-            self->Write(std::move(response));
+    void HandleRequest(HttpRequest&& request, std::uint64_t request_seq) override {
+        request_handler_(std::move(request), [self = this->shared_from_this(), request_seq](auto&& response) {
+            self->Write(request_seq, std::move(response));
         });
     }
 
+    bool TryUpgrade(const HttpRequest& request, SessionStream& stream) override {
+        // Обработчик, умеющий принимать WebSocket, объявляет метод Upgrade и забирает поток, если возвращает true
+        if constexpr (requires { { request_handler_.Upgrade(request, stream) } -> std::convertible_to<bool>; }) {
+            return request_handler_.Upgrade(request, stream);
+        } else {
+            return false;
+        }
+    }
+
     std::shared_ptr<SessionBase> GetSharedThis() override {
         return this->shared_from_this();
     }        
@@ -83,10 +168,13 @@ template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+             std::shared_ptr<ConnectionTracker> tracker, bool reuse_port = false)
         : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
         , acceptor_(net::make_strand(ioc))
+        , retry_timer_(acceptor_.get_executor())
+        , tracker_(std::move(tracker))
         , request_handler_(std::forward<Handler>(request_handler)) {
         // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
         acceptor_.open(endpoint.protocol());
@@ -96,6 +184,9 @@ public:
         // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
         // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
         acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (reuse_port) {
+            acceptor_.set_option(ReusePort(true));
+        }
         // Привязываем acceptor к адресу и порту endpoint
         acceptor_.bind(endpoint);
         // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -109,6 +200,13 @@ public:
 
 private:
     void DoAccept() {
+        // При исчерпании лимита новые соединения ждут в очереди ядра, пока не закроется одно из текущих
+        if (!tracker_->TryOpen()) {
+            return tracker_->WaitForSlot([self = this->shared_from_this()] {
+                net::post(self->acceptor_.get_executor(), [self] { self->DoAccept(); });
+            });
+        }
+
         acceptor_.async_accept(
             // Передаём последовательный исполнитель, в котором будут вызываться обработчики
             // асинхронных операций сокета
@@ -125,11 +223,22 @@ private:
     }
 
     // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
-    void OnAccept(beast::error_code ec, tcp::socket socket) {
+    void OnAccept(beast::error_code ec, SessionSocket socket) {
         using namespace std::literals;
 
         if (ec) {
-            return ReportError(ec, "accept"sv);
+            tracker_->Release();
+            if (ec == net::error::operation_aborted) {
+                return;
+            }
+            ReportError(ec, "accept"sv);
+            // например, закончились дескрипторы: приём продолжается после паузы
+            retry_timer_.expires_after(ACCEPT_RETRY_DELAY);
+            return retry_timer_.async_wait([self = this->shared_from_this()](beast::error_code timer_ec) {
+                if (!timer_ec) {
+                    self->DoAccept();
+                }
+            });
         }
 
         // Асинхронно обрабатываем сессию
@@ -139,22 +248,39 @@ private:
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket&& socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+    void AsyncRunSession(SessionSocket&& socket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), tracker_, request_handler_)->Run();
     }
 
+    static constexpr auto ACCEPT_RETRY_DELAY = std::chrono::milliseconds(100);
+
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
+    net::steady_timer retry_timer_;
+    std::shared_ptr<ConnectionTracker> tracker_;
     RequestHandler request_handler_;
 };
 
 	template <typename RequestHandler>
-	void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+	void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler,
+	               std::shared_ptr<ConnectionTracker> tracker = std::make_shared<ConnectionTracker>()) {
 		// При помощи decay_t исключим ссылки из типа RequestHandler,
 		// чтобы Listener хранил RequestHandler по значению
 		using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-		std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+		std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), std::move(tracker))->Run();
+	}
+
+	// Каждый io_context пула получает свой acceptor на общем порту.
+	// Соединение обслуживается целиком в контексте, который его принял. Лимиты общие для всех контекстов
+	template <typename RequestHandler>
+	void ServeHttp(IoContextPool& pool, const tcp::endpoint& endpoint, RequestHandler&& handler,
+	               std::shared_ptr<ConnectionTracker> tracker = std::make_shared<ConnectionTracker>()) {
+		using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+		for (size_t i = 0; i < pool.GetSize(); ++i) {
+			std::make_shared<MyListener>(pool.GetContext(i), endpoint, handler, tracker, true)->Run();
+		}
 	}
 
 }  // namespace http_server
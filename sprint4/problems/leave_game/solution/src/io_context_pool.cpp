@@ -0,0 +1,57 @@
+#include "io_context_pool.h"
+
+#include <algorithm>
+#include <thread>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace http_server {
+
+namespace {
+
+void PinCurrentThread(size_t core) {
+#ifdef __linux__
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core % cores, &cpu_set);
+    // неудача не мешает работе: поток просто останется без привязки
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+    (void)core;
+#endif
+}
+
+}  // namespace
+
+IoContextPool::IoContextPool(size_t size) {
+    size = std::max<size_t>(1, size);
+    contexts_.reserve(size);
+    work_.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        // один поток на контекст: планировщик может не блокировать свою очередь
+        contexts_.push_back(std::make_unique<net::io_context>(1));
+        work_.push_back(net::make_work_guard(*contexts_.back()));
+    }
+}
+
+void IoContextPool::Run() {
+    std::vector<std::jthread> threads;
+    threads.reserve(contexts_.size());
+    for (size_t i = 0; i < contexts_.size(); ++i) {
+        threads.emplace_back([this, i] {
+            PinCurrentThread(i);
+            contexts_[i]->run();
+        });
+    }
+}
+
+void IoContextPool::Stop() {
+    for (auto& context : contexts_) {
+        context->stop();
+    }
+}
+
+}  // namespace http_server
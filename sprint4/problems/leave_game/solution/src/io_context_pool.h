@@ -0,0 +1,35 @@
+#pragma once
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <memory>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+/*
+ *  Набор io_context, по одному на ядро. Каждый обслуживается одним потоком,
+ *  закреплённым за своим ядром, поэтому планировщики не делят между собой мьютекс.
+ */
+class IoContextPool {
+public:
+    explicit IoContextPool(size_t size);
+    IoContextPool(const IoContextPool&) = delete;
+    IoContextPool& operator=(const IoContextPool&) = delete;
+
+    size_t GetSize() const noexcept { return contexts_.size(); }
+    net::io_context& GetContext(size_t index) { return *contexts_[index]; }
+
+    // Запускает контексты в собственных потоках и ждёт их завершения
+    void Run();
+    void Stop();
+
+private:
+    using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+    std::vector<std::unique_ptr<net::io_context>> contexts_;
+    std::vector<WorkGuard> work_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,494 @@
+#include "journal.h"
+#include "binary_writer.h"
+#include "game_session.h"
+#include "snapshot_writer.h"
+#include "state_archive.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace serialization {
+
+using binary_serializer::BinaryReader;
+using binary_serializer::BinaryWriter;
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view SEGMENT_SUFFIX = ".journal."sv;
+// длина и контрольная сумма пакета
+constexpr size_t BATCH_HEADER_SIZE = 2 * sizeof(std::uint32_t);
+
+[[noreturn]] void ThrowErrno(const std::string& what){
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+void WriteRecord(BinaryWriter& writer, JournalRecord record){
+	writer.U8(static_cast<std::uint8_t>(record));
+}
+
+// Состояние из файла сохранения с индексами игроков и трофеев по id
+class Replayer {
+public:
+	explicit Replayer(model::GameSessionsStates& states) : states_(states) {
+		for(size_t i = 0; i < states_.states.size(); ++i){
+			IndexSession(i);
+		}
+	}
+
+	void Apply(std::string_view payload){
+		BinaryReader reader(payload);
+		Session* session = nullptr;
+
+		while(reader.GetRemaining() > 0){
+			const auto record = static_cast<JournalRecord>(reader.U8());
+			if(record == JournalRecord::SESSION){
+				session = &FindSession(std::string(reader.Bytes()));
+				GetState(*session).player_id_ = static_cast<unsigned>(reader.Varint());
+				continue;
+			}
+			if(!session){
+				throw std::runtime_error("Journal record outside of a session");
+			}
+
+			switch(record){
+				case JournalRecord::JOIN:
+					Join(*session, ReadPlayerState(reader));
+					break;
+				case JournalRecord::DOG:
+					UpdateDog(*session, reader);
+					break;
+				case JournalRecord::PLAYER_LEFT:
+					session->players.erase(static_cast<unsigned>(reader.Varint()));
+					break;
+				case JournalRecord::LOOT:
+					AddLoot(*session, ReadLootInfo(reader));
+					break;
+				case JournalRecord::LOOT_REMOVED:
+					session->loots.erase(static_cast<unsigned>(reader.Varint()));
+					break;
+				default:
+					throw std::runtime_error("Unknown journal record "s + std::to_string(static_cast<int>(record)));
+			}
+		}
+	}
+
+	// Переносит в состояние только игроков и трофеи, оставшиеся в индексах
+	void Finish(){
+		for(auto& session : sessions_){
+			auto& state = GetState(session);
+			std::vector<model::PlayerState> players;
+			players.reserve(session.players.size());
+			for(size_t i = 0; i < state.player_state_.size(); ++i){
+				if(auto it = session.players.find(state.player_state_[i].id_); it != session.players.end() && it->second == i){
+					players.push_back(std::move(state.player_state_[i]));
+				}
+			}
+			state.player_state_ = std::move(players);
+
+			std::vector<model::LootInfo> loots;
+			loots.reserve(session.loots.size());
+			for(size_t i = 0; i < state.loots_info_state.size(); ++i){
+				if(auto it = session.loots.find(state.loots_info_state[i].id); it != session.loots.end() && it->second == i){
+					loots.push_back(state.loots_info_state[i]);
+				}
+			}
+			state.loots_info_state = std::move(loots);
+		}
+
+		std::erase_if(states_.states, [](const model::GameSessionState& state){ return state.player_state_.empty();});
+	}
+
+private:
+	struct Session {
+		size_t index;
+		// id - позиция в player_state_ и loots_info_state. Ушедшие игроки и собранные трофеи удаляются из индекса
+		std::unordered_map<unsigned, size_t> players;
+		std::unordered_map<unsigned, size_t> loots;
+	};
+
+	model::GameSessionState& GetState(const Session& session){
+		return states_.states[session.index];
+	}
+
+	void IndexSession(size_t index){
+		Session& session = sessions_.emplace_back(Session{index, {}, {}});
+		const auto& state = states_.states[index];
+		for(size_t i = 0; i < state.player_state_.size(); ++i){
+			session.players[state.player_state_[i].id_] = i;
+		}
+		for(size_t i = 0; i < state.loots_info_state.size(); ++i){
+			session.loots[state.loots_info_state[i].id] = i;
+		}
+	}
+
+	Session& FindSession(const std::string& map_id){
+		auto it = std::find_if(sessions_.begin(), sessions_.end(), [this, &map_id](const Session& session){
+			return GetState(session).map_id_ == map_id;
+		});
+		if(it != sessions_.end()){
+			return *it;
+		}
+
+		model::GameSessionState state;
+		state.map_id_ = map_id;
+		state.player_id_ = 0;
+		states_.states.push_back(std::move(state));
+		IndexSession(states_.states.size() - 1);
+		return sessions_.back();
+	}
+
+	void Join(Session& session, model::PlayerState player){
+		auto& players = GetState(session).player_state_;
+		if(auto it = session.players.find(player.id_); it != session.players.end()){
+			players[it->second] = std::move(player);
+			return;
+		}
+		session.players[player.id_] = players.size();
+		players.push_back(std::move(player));
+	}
+
+	void UpdateDog(Session& session, BinaryReader& reader){
+		const auto id = static_cast<unsigned>(reader.Varint());
+		const auto direction = reader.U8();
+		if(direction > static_cast<std::uint8_t>(model::DogDirection::STOP)){
+			throw std::runtime_error("Invalid dog direction in journal");
+		}
+
+		model::DogPos pos;
+		pos.current_road_index = static_cast<size_t>(reader.Varint());
+		pos.curr_position.x = reader.F64();
+		pos.curr_position.y = reader.F64();
+		pos.curr_speed.vx = reader.F64();
+		pos.curr_speed.vy = reader.F64();
+		auto bag = ReadLootsInfo(reader);
+		const auto score = reader.I32();
+		const auto play_time = reader.I32();
+
+		// собака игрока, ушедшего до сохранения, уже не нужна
+		auto it = session.players.find(id);
+		if(it == session.players.end()){
+			return;
+		}
+		auto& player = GetState(session).player_state_[it->second];
+		player.dog_direction_ = static_cast<model::DogDirection>(direction);
+		player.dog_position_ = pos;
+		player.gathered_loots_ = std::move(bag);
+		player.score_ = score;
+		player.play_time_ = play_time;
+	}
+
+	void AddLoot(Session& session, const model::LootInfo& loot){
+		auto& loots = GetState(session).loots_info_state;
+		if(auto it = session.loots.find(loot.id); it != session.loots.end()){
+			loots[it->second] = loot;
+			return;
+		}
+		session.loots[loot.id] = loots.size();
+		loots.push_back(loot);
+	}
+
+	model::GameSessionsStates& states_;
+	std::vector<Session> sessions_;
+};
+
+}  // namespace
+
+std::string EncodeJournalRecords(model::GameSession& session, const model::StateDelta& delta){
+	std::string out;
+	if(delta.players.empty() && delta.loots.empty() && delta.removed_players.empty() && delta.removed_loots.empty()){
+		return out;
+	}
+
+	BinaryWriter writer(out);
+	WriteRecord(writer, JournalRecord::SESSION);
+	writer.Bytes(session.GetMap()).Varint(session.GetNextPlayerId());
+
+	for(model::Player* player : delta.players){
+		// вошедший после базы игрок пишется целиком, остальные - только собакой
+		if(player->GetJoinedTick() > delta.base_tick){
+			WriteRecord(writer, JournalRecord::JOIN);
+			WritePlayerState(writer, player->GetState());
+			continue;
+		}
+
+		auto dog = player->GetDog();
+		const auto pos = dog->GetPositionOnMap();
+		WriteRecord(writer, JournalRecord::DOG);
+		writer.Varint(player->GetId()).U8(static_cast<std::uint8_t>(dog->GetDirection()))
+			  .Varint(pos.current_road_index)
+			  .F64(pos.curr_position.x).F64(pos.curr_position.y)
+			  .F64(pos.curr_speed.vx).F64(pos.curr_speed.vy);
+		WriteLootsInfo(writer, dog->GetGatheredLoot());
+		writer.I32(dog->GetScore()).I32(static_cast<std::int32_t>(dog->GetPlayTime()));
+	}
+
+	for(const model::LootInfo* loot : delta.loots){
+		WriteRecord(writer, JournalRecord::LOOT);
+		WriteLootInfo(writer, *loot);
+	}
+	for(unsigned id : delta.removed_players){
+		WriteRecord(writer, JournalRecord::PLAYER_LEFT);
+		writer.Varint(id);
+	}
+	for(unsigned id : delta.removed_loots){
+		WriteRecord(writer, JournalRecord::LOOT_REMOVED);
+		writer.Varint(id);
+	}
+	return out;
+}
+
+JournalReplay ReplayJournal(const std::filesystem::path& save_path, model::GameSessionsStates& states){
+	JournalReplay result;
+	Replayer replayer(states);
+
+	for(const auto& [segment, path] : Journal::FindSegments(save_path)){
+		const MappedFile file(path);
+		BinaryReader reader(file.GetData());
+		++result.segments;
+
+		while(reader.GetRemaining() > 0){
+			// сбой во время записи оставляет неполный пакет только в конце сегмента
+			if(reader.GetRemaining() < BATCH_HEADER_SIZE){
+				++result.torn_segments;
+				break;
+			}
+			const auto size = reader.U32();
+			const auto checksum = reader.U32();
+			if(size > reader.GetRemaining()){
+				++result.torn_segments;
+				break;
+			}
+			const std::string_view payload = reader.Raw(size);
+			if(Crc32(payload) != checksum){
+				++result.torn_segments;
+				break;
+			}
+
+			try{
+				replayer.Apply(payload);
+			}catch(const std::out_of_range&){
+				throw std::runtime_error("Malformed batch in journal " + path.string());
+			}
+			++result.batches;
+		}
+	}
+
+	replayer.Finish();
+	return result;
+}
+
+Journal::Journal(std::filesystem::path save_path, ErrorHandler on_error)
+	: save_path_(std::move(save_path)), on_error_(std::move(on_error)){
+	const auto segments = FindSegments(save_path_);
+	segment_ = segments.empty() ? 1 : segments.back().first + 1;
+	thread_ = std::jthread([this](std::stop_token stop){ Run(stop); });
+}
+
+Journal::~Journal(){
+	Commit();
+	// поток дописывает переданные пакеты и останавливается раньше, чем разрушаются остальные поля
+	thread_.request_stop();
+	thread_.join();
+	CloseSegment();
+}
+
+void Journal::Append(std::string_view records){
+	std::lock_guard lock(mutex_);
+	current_.append(records);
+}
+
+void Journal::Commit(){
+	{
+		std::lock_guard lock(mutex_);
+		CommitLocked();
+	}
+	wake_.notify_one();
+}
+
+std::uint64_t Journal::StartSegment(){
+	std::uint64_t segment;
+	{
+		std::lock_guard lock(mutex_);
+		CommitLocked();
+		segment = ++segment_;
+	}
+	wake_.notify_one();
+	return segment;
+}
+
+void Journal::DropSegmentsBefore(std::uint64_t segment){
+	{
+		std::lock_guard lock(mutex_);
+		drop_before_ = std::max(drop_before_, segment);
+	}
+	wake_.notify_one();
+}
+
+void Journal::Flush(){
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [this]{ return committed_.empty() && !writing_ && drop_before_ <= dropped_before_; });
+}
+
+std::uint64_t Journal::GetSegment() const {
+	std::lock_guard lock(mutex_);
+	return segment_;
+}
+
+std::filesystem::path Journal::GetSegmentPath(const std::filesystem::path& save_path, std::uint64_t segment){
+	std::filesystem::path path = save_path;
+	path += SEGMENT_SUFFIX;
+	path += std::to_string(segment);
+	return path;
+}
+
+std::vector<std::pair<std::uint64_t, std::filesystem::path>> Journal::FindSegments(const std::filesystem::path& save_path){
+	std::vector<std::pair<std::uint64_t, std::filesystem::path>> segments;
+	const std::filesystem::path dir = save_path.parent_path().empty() ? "." : save_path.parent_path();
+	const std::string prefix = save_path.filename().string() + std::string(SEGMENT_SUFFIX);
+
+	std::error_code ec;
+	for(const auto& entry : std::filesystem::directory_iterator(dir, ec)){
+		const std::string name = entry.path().filename().string();
+		if(!name.starts_with(prefix)){
+			continue;
+		}
+		std::uint64_t segment = 0;
+		const char* first = name.data() + prefix.size();
+		const char* last = name.data() + name.size();
+		if(auto [ptr, err] = std::from_chars(first, last, segment); err == std::errc{} && ptr == last && first != last){
+			segments.emplace_back(segment, entry.path());
+		}
+	}
+
+	std::sort(segments.begin(), segments.end());
+	return segments;
+}
+
+void Journal::CommitLocked(){
+	if(current_.empty()){
+		return;
+	}
+
+	std::string batch;
+	batch.reserve(BATCH_HEADER_SIZE + current_.size());
+	BinaryWriter writer(batch);
+	writer.U32(static_cast<std::uint32_t>(current_.size())).U32(Crc32(current_));
+	batch += current_;
+	current_.clear();
+
+	committed_.push_back(Batch{segment_, std::move(batch)});
+	committed_batches_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Journal::Run(std::stop_token stop){
+	std::unique_lock lock(mutex_);
+	while(true){
+		wake_.wait(lock, stop, [this]{ return !committed_.empty() || drop_before_ > dropped_before_; });
+		if(committed_.empty() && drop_before_ <= dropped_before_){
+			return;
+		}
+
+		// всё, что накопилось за время прошлой записи, пишется вместе
+		auto batches = std::move(committed_);
+		committed_.clear();
+		const std::uint64_t drop_before = drop_before_;
+		writing_ = true;
+		lock.unlock();
+
+		Write(batches);
+		if(drop_before > dropped_before_){
+			Drop(drop_before);
+		}
+
+		lock.lock();
+		dropped_before_ = std::max(dropped_before_, drop_before);
+		writing_ = false;
+		idle_.notify_all();
+	}
+}
+
+void Journal::Write(std::vector<Batch>& batches){
+	size_t i = 0;
+	while(i < batches.size()){
+		const std::uint64_t segment = batches[i].segment;
+		std::string group = std::move(batches[i].data);
+		for(++i; i < batches.size() && batches[i].segment == segment; ++i){
+			group += batches[i].data;
+		}
+
+		const auto path = GetSegmentPath(save_path_, segment);
+		off_t good_size = -1;
+		try{
+			if(fd_ < 0 || fd_segment_ != segment){
+				CloseSegment();
+				const bool created = !std::filesystem::exists(path);
+				fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+				if(fd_ < 0){
+					ThrowErrno("open " + path.string());
+				}
+				fd_segment_ = segment;
+				if(created){
+					// новый сегмент должен пережить сбой вместе с записью о нём в каталоге
+					SyncDirectory(path.parent_path());
+				}
+			}
+
+			good_size = ::lseek(fd_, 0, SEEK_END);
+			std::string_view data = group;
+			while(!data.empty()){
+				const ssize_t written = ::write(fd_, data.data(), data.size());
+				if(written < 0){
+					if(errno == EINTR){
+						continue;
+					}
+					ThrowErrno("write " + path.string());
+				}
+				data.remove_prefix(static_cast<size_t>(written));
+			}
+			if(::fdatasync(fd_) != 0){
+				ThrowErrno("fdatasync " + path.string());
+			}
+			syncs_.fetch_add(1, std::memory_order_relaxed);
+			written_bytes_.fetch_add(group.size(), std::memory_order_relaxed);
+		}catch(const std::exception& ex){
+			failed_.fetch_add(1, std::memory_order_relaxed);
+			// недописанный пакет отрезается, чтобы следующие не оказались за испорченным хвостом
+			if(fd_ >= 0 && good_size >= 0){
+				[[maybe_unused]] const int truncated = ::ftruncate(fd_, good_size);
+			}
+			CloseSegment();
+			if(on_error_){
+				on_error_(ex);
+			}
+		}
+	}
+}
+
+void Journal::Drop(std::uint64_t before){
+	for(const auto& [segment, path] : FindSegments(save_path_)){
+		if(segment >= before){
+			break;
+		}
+		if(fd_ >= 0 && fd_segment_ == segment){
+			CloseSegment();
+		}
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+	}
+}
+
+void Journal::CloseSegment(){
+	if(fd_ >= 0){
+		::close(fd_);
+		fd_ = -1;
+	}
+}
+
+}  // namespace serialization
@@ -0,0 +1,136 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace model {
+	class GameSession;
+	struct StateDelta;
+	struct GameSessionsStates;
+}
+
+/*
+ *  Журнал изменений между полными сохранениями состояния игры.
+ *
+ *  Каждый тик сессии дописывает в журнал свои изменения, в конце тика они собираются в пакет.
+ *  Пакеты пишутся отдельным потоком: всё, что накопилось за время прошлой записи, уходит
+ *  одним write и одним fdatasync (групповая фиксация), поэтому тик не ждёт диска.
+ *
+ *  Журнал делится на сегменты <файл сохранения>.journal.<номер>. Полное сохранение начинает
+ *  новый сегмент, а более старые удаляются, когда сохранение записано на диск.
+ *  Восстановление - последнее сохранение и все оставшиеся сегменты по порядку.
+ *
+ *  Пакет: u32 длина, u32 CRC-32, записи. Обрезанный при сбое хвост сегмента не проходит проверку и отбрасывается.
+ *  Записи повторяют состояние сущности целиком, поэтому повторное применение безопасно:
+ *    SESSION       строка id карты, varint следующий id игрока - последующие записи относятся к этой сессии
+ *    JOIN          игрок целиком, как в файле сохранения
+ *    DOG           varint id, u8 направление, varint индекс дороги, f64 x, f64 y, f64 vx, f64 vy,
+ *                  трофеи в рюкзаке, i32 очки, i32 время в игре
+ *    PLAYER_LEFT   varint id
+ *    LOOT          трофей
+ *    LOOT_REMOVED  varint id
+ */
+namespace serialization {
+
+enum class JournalRecord : std::uint8_t {
+	SESSION = 1,
+	JOIN = 2,
+	DOG = 3,
+	PLAYER_LEFT = 4,
+	LOOT = 5,
+	LOOT_REMOVED = 6
+};
+
+// Изменения сессии за тик. Пустая строка, если ничего не изменилось. Вызывается на strand сессии
+std::string EncodeJournalRecords(model::GameSession& session, const model::StateDelta& delta);
+
+struct JournalReplay {
+	size_t segments{0};
+	size_t batches{0};
+	// сегменты, хвост которых обрезан или испорчен
+	size_t torn_segments{0};
+};
+
+// Применяет к состоянию из файла сохранения все сегменты журнала save_path по порядку.
+// Сессии, оставшиеся без игроков, удаляются
+JournalReplay ReplayJournal(const std::filesystem::path& save_path, model::GameSessionsStates& states);
+
+class Journal {
+public:
+	using ErrorHandler = std::function<void(const std::exception&)>;
+
+	// Новые записи идут в сегмент после последнего найденного на диске
+	explicit Journal(std::filesystem::path save_path, ErrorHandler on_error = {});
+	// Дописывает накопленные записи на диск
+	~Journal();
+
+	Journal(const Journal&) = delete;
+	Journal& operator=(const Journal&) = delete;
+
+	// Может вызываться со strand-ов разных сессий одновременно
+	void Append(std::string_view records);
+	// Завершает тик: накопленные записи становятся пакетом и передаются потоку записи. Не ждёт диска
+	void Commit();
+	// Фиксирует накопленное и начинает новый сегмент. Возвращает его номер
+	std::uint64_t StartSegment();
+	// Сегменты до segment покрыты записанным сохранением и удаляются после уже переданных пакетов
+	void DropSegmentsBefore(std::uint64_t segment);
+	// Ждёт, пока всё переданное будет на диске
+	void Flush();
+
+	std::uint64_t GetSegment() const;
+	std::uint64_t GetCommittedBatches() const { return committed_batches_.load(std::memory_order_relaxed);}
+	std::uint64_t GetSyncs() const { return syncs_.load(std::memory_order_relaxed);}
+	std::uint64_t GetWrittenBytes() const { return written_bytes_.load(std::memory_order_relaxed);}
+	std::uint64_t GetFailedWrites() const { return failed_.load(std::memory_order_relaxed);}
+
+	static std::filesystem::path GetSegmentPath(const std::filesystem::path& save_path, std::uint64_t segment);
+	// Номера и пути сегментов журнала по возрастанию
+	static std::vector<std::pair<std::uint64_t, std::filesystem::path>> FindSegments(const std::filesystem::path& save_path);
+
+private:
+	struct Batch {
+		std::uint64_t segment;
+		std::string data;
+	};
+
+	void CommitLocked();
+	void Run(std::stop_token stop);
+	void Write(std::vector<Batch>& batches);
+	void Drop(std::uint64_t before);
+	void CloseSegment();
+
+	std::filesystem::path save_path_;
+	ErrorHandler on_error_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable_any wake_;
+	std::condition_variable idle_;
+	std::string current_;
+	std::uint64_t segment_{0};
+	std::vector<Batch> committed_;
+	std::uint64_t drop_before_{0};
+	bool writing_{false};
+
+	// открытый сегмент, используется только потоком записи
+	int fd_{-1};
+	std::uint64_t fd_segment_{0};
+	std::uint64_t dropped_before_{0};
+
+	std::atomic<std::uint64_t> committed_batches_{0};
+	std::atomic<std::uint64_t> syncs_{0};
+	std::atomic<std::uint64_t> written_bytes_{0};
+	std::atomic<std::uint64_t> failed_{0};
+
+	std::jthread thread_;
+};
+
+}  // namespace serialization
@@ -1,19 +1,22 @@
 #include "json_serializer.h"
 #include <utility>
-#include <boost/json.hpp>
 #include "game_session.h"
+#include "json_writer.h"
 
-namespace json = boost::json;
 using namespace std::literals;
 
 const int MILLISECONDS_IN_SECOND = 1000;
 namespace json_serializer {
 
    std::string MakeErrorResponce(const std::string& codeMessage, const std::string& errorMessage){
-        json::object resp_object;
-        resp_object["code"] = codeMessage;
-        resp_object["message"] = errorMessage;
-      	return json::serialize(resp_object);
+        std::string out;
+        JsonWriter writer(out);
+
+        writer.StartObject()
+        	  .Member("code", codeMessage)
+			  .Member("message", errorMessage)
+			  .EndObject();
+      	return out;
    }
 
    std::string MakeMapNotFoundResponce(){return	MakeErrorResponce("mapNotFound", "Map not found");}
@@ -21,198 +24,247 @@ namespace json_serializer {
    std::string MakeBadRequestResponce(){return	MakeErrorResponce("badRequest", "Bad request");}
 
    std::string MakeAuthResponce(const std::string& auth_key, unsigned playerId){
-        json::object resp_object;
-        
-        resp_object["authToken"] = auth_key;
-        resp_object["playerId"] = playerId;
-                    
-      	return json::serialize(resp_object);
+        std::string out;
+        JsonWriter writer(out);
+
+        writer.StartObject()
+        	  .Member("authToken", auth_key)
+			  .Member("playerId", playerId)
+			  .EndObject();
+      	return out;
    }
 
    std::string MakeMappedResponce(const std::map<std::string, std::string>& key_values){
-       json::object resp_object;
+       std::string out;
+       JsonWriter writer(out);
 
+       writer.StartObject();
        for(const auto&[key, value] : key_values){
-    	   resp_object[key] = value;
+    	   writer.Member(key, value);
 	   }
+       writer.EndObject();
 
-       return json::serialize(resp_object);
+       return out;
    }
 
    std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players_info){
-	   json::object resp_object;
+	   std::string out;
+	   JsonWriter writer(out);
 
+	   writer.StartObject();
 	   for(auto& player : players_info){
-		   json::object name_object;
-		   name_object["name"] = player->GetName();
-
-		   resp_object[std::to_string(player->GetId())] = name_object;
+		   writer.Key(player->GetId())
+		   	   	 .StartObject()
+				 .Member("name", player->GetName())
+				 .EndObject();
 	   }
+	   writer.EndObject();
 
-	  return json::serialize(resp_object);
+	  return out;
    }
 
-   json::array SerializeDogBag(const std::vector<model::LootInfo>& loots){
-      json::array bag_ar;
+   void SerializeDogBag(const std::vector<model::LootInfo>& loots, JsonWriter& writer){
+      writer.StartArray();
 
       for(const auto& cur_loot: loots){
-    	  json::object loot_object;
-
-    	  loot_object["id"] = cur_loot.id;
-		  loot_object["type"] = cur_loot.type;
-
-		  bag_ar.emplace_back(loot_object);
+    	  writer.StartObject()
+    	  	  	.Member("id", cur_loot.id)
+				.Member("type", cur_loot.type)
+				.EndObject();
       }
 
-	   return bag_ar;
+      writer.EndArray();
    }
 
-   json::object SerializePlayers(const std::vector<std::shared_ptr<model::Player>>& players){
-	   json::object players_object;
-
-	   for(auto& player : players){
-		    auto dog =  player->GetDog();
-
-	  		json::object dog_object;
-	  		json::array pos_ar, speed_ar;
-
-	  		auto pos = dog->GetPosition();
-	  		pos_ar.emplace_back(pos.x);
-	  		pos_ar.emplace_back(pos.y);
-
-	  		dog_object["pos"] = pos_ar;
+   void SerializePlayer(model::Player& player, JsonWriter& writer){
+	    auto dog =  player.GetDog();
+  		auto pos = dog->GetPosition();
+  		auto speed = dog->GetSpeed();
 
-	  		auto speed = dog->GetSpeed();
-	  		speed_ar.emplace_back(speed.vx);
-			speed_ar.emplace_back(speed.vy);
+  		writer.Key(player.GetId()).StartObject();
+  		writer.Key("pos").StartArray().Value(pos.x).Value(pos.y).EndArray();
+  		writer.Key("speed").StartArray().Value(speed.vx).Value(speed.vy).EndArray();
+  		writer.Member("dir", model::ConvertDogDirectionToString(dog->GetDirection()));
 
-			dog_object["speed"] = speed_ar;
+  		writer.Key("bag");
+  		SerializeDogBag(dog->GetGatheredLoot(), writer);
+  		writer.Member("score", dog->GetScore());
+  		writer.EndObject();
+   }
 
-			DogDirection dir = dog->GetDirection();
-			dog_object["dir"] = model::ConvertDogDirectionToString(dir);
+   void SerializePlayers(const std::vector<std::shared_ptr<model::Player>>& players, JsonWriter& writer){
+	   writer.StartObject();
 
-			dog_object["bag"] = SerializeDogBag(dog->GetGatheredLoot());
-			dog_object["score"] = dog->GetScore();
-			players_object[std::to_string(player->GetId())] = dog_object;
+	   for(auto& player : players){
+		   SerializePlayer(*player, writer);
 	  	}
 
-	   return players_object;
+	   writer.EndObject();
+   }
+
+   void SerializeLoot(size_t key, const model::LootInfo& loot, JsonWriter& writer){
+	   writer.Key(key).StartObject();
+	   writer.Key("pos").StartArray().Value(loot.x).Value(loot.y).EndArray();
+	   writer.Member("type", loot.type);
+	   writer.EndObject();
    }
 
-   json::object SerializeLoots(const std::vector<model::LootInfo>& loots){
-   	   	   json::object loots_object;
+   void SerializeLoots(const std::vector<model::LootInfo>& loots, JsonWriter& writer){
+   	   	   writer.StartObject();
 
    	   	   for(size_t i = 0; i < loots.size(); ++i)
    	   	   {
-   	   		json::object loot_object;
-   	   		json::array pos_ar;
-
-	  		pos_ar.emplace_back(loots[i].x);
-	  		pos_ar.emplace_back(loots[i].y);
-
-	  		loot_object["pos"] = pos_ar;
-   	   		loot_object["type"] = loots[i].type;
-   	   		loots_object[std::to_string(i)] = loot_object;
+   	   		SerializeLoot(i, loots[i], writer);
    	   	   }
 
-   	   	   return loots_object;
+   	   	   writer.EndObject();
       }
 
+   void SerializeIds(const std::vector<unsigned>& ids, JsonWriter& writer){
+	   writer.StartArray();
+	   for(unsigned id : ids){
+		   writer.Value(id);
+	   }
+	   writer.EndArray();
+   }
+
+   void WritePlayersDogInfo(std::string& out, const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots){
+	    JsonWriter writer(out);
+
+	    writer.StartObject();
+	    writer.Key("players");
+	    SerializePlayers(players, writer);
+	    writer.Key("lostObjects");
+	    SerializeLoots(loots, writer);
+	    writer.EndObject();
+   }
+
    std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots){
-	   json::object resp_object;
+	    std::string out;
+	    // одно выделение памяти под весь ответ
+	    out.reserve(64 + players.size() * 160 + loots.size() * 48);
+	    WritePlayersDogInfo(out, players, loots);
+	  	return out;
+   }
+
+   void WriteStateDelta(std::string& out, const model::StateDelta& delta){
+	    JsonWriter writer(out);
+
+	    writer.StartObject();
+	    writer.Member("tick", delta.tick);
+	    writer.Member("full", delta.full);
+
+	    writer.Key("players").StartObject();
+	    for(model::Player* player : delta.players){
+	    	SerializePlayer(*player, writer);
+	    }
+	    writer.EndObject();
+
+	    // трофеи в разнице определяются по id, а не по положению в списке, которое меняется при сборе
+	    writer.Key("lostObjects").StartObject();
+	    for(const model::LootInfo* loot : delta.loots){
+	    	SerializeLoot(loot->id, *loot, writer);
+	    }
+	    writer.EndObject();
+
+	    writer.Key("removedPlayers");
+	    SerializeIds(delta.removed_players, writer);
+	    writer.Key("removedObjects");
+	    SerializeIds(delta.removed_loots, writer);
+	    writer.EndObject();
+   }
 
-	    resp_object["players"] = SerializePlayers(players);
-	    resp_object["lostObjects"] = SerializeLoots(loots);
-	  	return json::serialize(resp_object);
+   std::string GetStateDeltaResponce(const model::StateDelta& delta){
+	    std::string out;
+	    out.reserve(128 + delta.players.size() * 160 + delta.loots.size() * 48);
+	    WriteStateDelta(out, delta);
+	    return out;
    }
 
-    void SerializeOffices(const model::Map& map ,json::object& root){
-    	json::array offices_ar;
+    void SerializeOffices(const model::Map& map, JsonWriter& writer){
+    	writer.Key("offices").StartArray();
     	for(const auto& office : map.GetOffices()){
-    		json::object office_obj;
-
-    		office_obj["id"] = *office.GetId();
-    		office_obj["x"] = office.GetPosition().x;
-    		office_obj["y"] = office.GetPosition().y;
-    		office_obj["offsetX"] = office.GetOffset().dx;
-    		office_obj["offsetY"] = office.GetOffset().dy;
-		
-    		offices_ar.emplace_back(office_obj);
+    		writer.StartObject()
+    			  .Member("id", *office.GetId())
+				  .Member("x", office.GetPosition().x)
+				  .Member("y", office.GetPosition().y)
+				  .Member("offsetX", office.GetOffset().dx)
+				  .Member("offsetY", office.GetOffset().dy)
+				  .EndObject();
     	}
-    	root["offices"] = offices_ar;
+    	writer.EndArray();
     }
 
-    void SerializeBuildings(const model::Map& map ,json::object& root){
-    	json::array buildings_ar;
+    void SerializeBuildings(const model::Map& map, JsonWriter& writer){
+    	writer.Key("buildings").StartArray();
     	for(const auto& building : map.GetBuildings()){
-    		json::object building_obj;
-
     		const auto& bounds = building.GetBounds();
 
-    		building_obj["x"] = bounds.position.x;
-    		building_obj["y"] = bounds.position.y;
-    		building_obj["w"] = bounds.size.width;
-    		building_obj["h"] = bounds.size.height;
-		
-    		buildings_ar.emplace_back(building_obj);
+    		writer.StartObject()
+    			  .Member("x", bounds.position.x)
+				  .Member("y", bounds.position.y)
+				  .Member("w", bounds.size.width)
+				  .Member("h", bounds.size.height)
+				  .EndObject();
     	}
-    	root["buildings"] = buildings_ar;
+    	writer.EndArray();
     }
 
-    void SerializeRoads(const model::Map& map ,json::object& root){
-    	json::array roads_ar;
+    void SerializeRoads(const model::Map& map, JsonWriter& writer){
+    	writer.Key("roads").StartArray();
     	for(const auto& road : map.GetRoads()){
-            json::object road_obj;
-		
             model::Point start = road.GetStart();
             model::Point end = road.GetEnd();
-		
-            road_obj["x0"] = start.x;
-            road_obj["y0"] = start.y;
-		
+
+            writer.StartObject()
+            	  .Member("x0", start.x)
+				  .Member("y0", start.y);
+
             if(road.IsHorizontal())
-                road_obj["x1"] = end.x;
+                writer.Member("x1", end.x);
             else
-                road_obj["y1"] = end.y;
+                writer.Member("y1", end.y);
 
-            roads_ar.emplace_back(road_obj);
+            writer.EndObject();
     	}
-    	root["roads"] = roads_ar;
+    	writer.EndArray();
     }
 
-    void SerializeLoots(const model::Map& map ,json::object& root){
-    	json::array loots_ar;
+    void SerializeLoots(const model::Map& map, JsonWriter& writer){
+    	writer.Key("lootTypes").StartArray();
     	for(const auto& loot : map.GetLoots()){
-    		json::object loot_obj;
-
-    		loot_obj["name"] = loot.GetName();
-    		loot_obj["file"] = loot.GetFile();
-    		loot_obj["type"] = loot.GetType();
+    		writer.StartObject()
+    			  .Member("name", loot.GetName())
+				  .Member("file", loot.GetFile())
+				  .Member("type", loot.GetType());
 
     		if(loot.GetRotation() >= 0)
-    			loot_obj["rotation"] = loot.GetRotation();
+    			writer.Member("rotation", loot.GetRotation());
 
     		if(!loot.GetColor().empty())
-    			loot_obj["color"] = loot.GetColor();
+    			writer.Member("color", loot.GetColor());
 
-    		loot_obj["scale"] = loot.GetScale();
-                loot_obj["value"] = loot.GetScore();
-    		loots_ar.emplace_back(loot_obj);
+    		writer.Member("scale", loot.GetScale())
+    			  .Member("value", loot.GetScore())
+				  .EndObject();
     	}
-    	root["lootTypes"] = loots_ar;
+    	writer.EndArray();
     }
 
     std::string GetMapListResponce(const model::Game& game){
-        json::array map_ar;
+        std::string out;
+        JsonWriter writer(out);
+
+        writer.StartArray();
         for( const auto& map: game.GetMaps()){
-            json::object map_obj;
-	
-            map_obj[ "id" ] = *map.GetId();
-            map_obj[ "name" ] = map.GetName();
-            map_ar.emplace_back(map_obj);
+            writer.StartObject()
+            	  .Member("id", *map.GetId())
+				  .Member("name", map.GetName())
+				  .EndObject();
         }
+        writer.EndArray();
   
-        return json::serialize(map_ar);
+        return out;
     }
 
     std::string GetMapContentResponce(const model::Game& game, const std::string& map_id){
@@ -222,29 +274,35 @@ namespace json_serializer {
     		return ("");
 		}
 
-    	json::object root;
+    	std::string out;
+    	JsonWriter writer(out);
 
-    	root[ "id" ] = *mapFound->GetId() ;
-    	root["name"] = mapFound->GetName();
+    	writer.StartObject()
+    		  .Member("id", *mapFound->GetId())
+			  .Member("name", mapFound->GetName());
 
-    	SerializeRoads(*mapFound, root);
-    	SerializeBuildings(*mapFound, root);
-    	SerializeOffices(*mapFound, root);
-    	SerializeLoots(*mapFound, root);
-    	return json::serialize(root);
+    	SerializeRoads(*mapFound, writer);
+    	SerializeBuildings(*mapFound, writer);
+    	SerializeOffices(*mapFound, writer);
+    	SerializeLoots(*mapFound, writer);
+    	writer.EndObject();
+    	return out;
     }
 
     std::string MakeRecordsResponce(const model::Game& game, int start, int max_items){
-    	json::array map_ar;
-        for( const auto& record: game.GetRecords(start, max_items)){
-            json::object map_obj;
+    	std::string out;
+    	JsonWriter writer(out);
 
-            map_obj[ "name" ] = record.name;
-    	    map_obj[ "score" ] = record.score;
-    	    map_obj[ "playTime" ] = (double)record.playTime / MILLISECONDS_IN_SECOND;
-    	    map_ar.emplace_back(map_obj);
+    	writer.StartArray();
+        for( const auto& record: game.GetRecords(start, max_items)){
+            writer.StartObject()
+            	  .Member("name", record.name)
+				  .Member("score", record.score)
+				  .Member("playTime", (double)record.playTime / MILLISECONDS_IN_SECOND)
+				  .EndObject();
         }
+        writer.EndArray();
 
-        return json::serialize(map_ar);
+        return out;
     }
 }  // namespace json_serializer
@@ -5,6 +5,7 @@
 namespace model
 {
 	class Player;
+	struct StateDelta;
 }
 
 namespace json_serializer {
@@ -18,5 +19,10 @@ std::string GetMapListResponce(const model::Game& game);
 std::string GetMapContentResponce(const model::Game& game, const std::string& map_id);
 std::string GetPlayerInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players_info);
 std::string GetPlayersDogInfoResponce(const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots);
+// Дописывает состояние игроков и трофеев в out, позволяя переиспользовать буфер
+void WritePlayersDogInfo(std::string& out, const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots);
+// Изменения состояния после тика клиента: {"tick", "full", "players", "lostObjects", "removedPlayers", "removedObjects"}
+std::string GetStateDeltaResponce(const model::StateDelta& delta);
+void WriteStateDelta(std::string& out, const model::StateDelta& delta);
 
 }  // namespace json_serializer
@@ -0,0 +1,164 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace json_serializer {
+
+namespace {
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+}  // namespace
+
+void JsonWriter::BeforeValue(){
+    if(after_key_){
+        after_key_ = false;
+        return;
+    }
+
+    if(depth_ > 0){
+        const std::uint64_t bit = std::uint64_t{1} << (depth_ - 1);
+        if(has_items_ & bit){
+            out_.push_back(',');
+        }
+        has_items_ |= bit;
+    }
+}
+
+void JsonWriter::Open(char bracket){
+    BeforeValue();
+    if(depth_ == 64){
+        throw std::length_error("JSON nesting is too deep");
+    }
+
+    out_.push_back(bracket);
+    ++depth_;
+    has_items_ &= ~(std::uint64_t{1} << (depth_ - 1));
+}
+
+void JsonWriter::Close(char bracket){
+    --depth_;
+    out_.push_back(bracket);
+}
+
+JsonWriter& JsonWriter::StartObject(){
+    Open('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject(){
+    Close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::StartArray(){
+    Open('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray(){
+    Close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key){
+    BeforeValue();
+    WriteString(key);
+    out_.push_back(':');
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::uint64_t key){
+    BeforeValue();
+    out_.push_back('"');
+    WriteNumber(key);
+    out_.append("\":");
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::string_view value){
+    BeforeValue();
+    WriteString(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::int64_t value){
+    BeforeValue();
+    WriteNumber(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(std::uint64_t value){
+    BeforeValue();
+    WriteNumber(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(double value){
+    BeforeValue();
+    if(!std::isfinite(value)){
+        // в JSON нет бесконечностей и NaN
+        out_.append("null");
+        return *this;
+    }
+
+    // целое значение остаётся вещественным числом и для клиента: 10 -> 10.0
+    const size_t begin = out_.size();
+    WriteNumber(value);
+    if(out_.find_first_of(".e", begin) == std::string::npos){
+        out_.append(".0");
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(bool value){
+    BeforeValue();
+    out_.append(value ? "true" : "false");
+    return *this;
+}
+
+template <typename T>
+void JsonWriter::WriteNumber(T value){
+    // кратчайшая запись, при чтении дающая то же число
+    char buffer[32];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out_.append(buffer, end);
+}
+
+void JsonWriter::WriteString(std::string_view str){
+    out_.push_back('"');
+
+    size_t plain_begin = 0;
+    for(size_t i = 0; i < str.size(); ++i){
+        const unsigned char ch = static_cast<unsigned char>(str[i]);
+        if((ch >= 0x20) && (ch != '"') && (ch != '\\')){
+            continue;
+        }
+
+        out_.append(str.data() + plain_begin, i - plain_begin);
+        plain_begin = i + 1;
+
+        switch(ch){
+            case '"':  out_.append("\\\""); break;
+            case '\\': out_.append("\\\\"); break;
+            case '\b': out_.append("\\b"); break;
+            case '\f': out_.append("\\f"); break;
+            case '\n': out_.append("\\n"); break;
+            case '\r': out_.append("\\r"); break;
+            case '\t': out_.append("\\t"); break;
+            default:
+                out_.append("\\u00");
+                out_.push_back(HEX_DIGITS[ch >> 4]);
+                out_.push_back(HEX_DIGITS[ch & 0xF]);
+        }
+    }
+
+    out_.append(str.data() + plain_begin, str.size() - plain_begin);
+    out_.push_back('"');
+}
+
+}  // namespace json_serializer
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace json_serializer {
+
+/*
+ *  Потоковая запись JSON в строку без построения дерева boost::json.
+ *  Запятые и двоеточия расставляются автоматически, вложенность - до 64 уровней.
+ *  Строка out может переиспользоваться между ответами, писатель только дописывает в неё.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    JsonWriter& StartObject();
+    JsonWriter& EndObject();
+    JsonWriter& StartArray();
+    JsonWriter& EndArray();
+
+    JsonWriter& Key(std::string_view key);
+    // Числовой ключ объекта ("0", "1", ...) без промежуточной строки
+    JsonWriter& Key(std::uint64_t key);
+
+    JsonWriter& Value(std::string_view value);
+    JsonWriter& Value(const char* value) { return Value(std::string_view(value)); }
+    JsonWriter& Value(const std::string& value) { return Value(std::string_view(value)); }
+    JsonWriter& Value(int value) { return Value(static_cast<std::int64_t>(value)); }
+    JsonWriter& Value(unsigned value) { return Value(static_cast<std::uint64_t>(value)); }
+    JsonWriter& Value(std::int64_t value);
+    JsonWriter& Value(std::uint64_t value);
+    JsonWriter& Value(double value);
+    JsonWriter& Value(bool value);
+
+    template <typename T>
+    JsonWriter& Member(std::string_view key, const T& value) {
+        Key(key);
+        return Value(value);
+    }
+
+private:
+    void BeforeValue();
+    void Open(char bracket);
+    void Close(char bracket);
+    void WriteString(std::string_view str);
+
+    template <typename T>
+    void WriteNumber(T value);
+
+    std::string& out_;
+    // бит уровня вложенности выставлен, если на этом уровне уже записан элемент
+    std::uint64_t has_items_{0};
+    unsigned depth_{0};
+    bool after_key_{false};
+};
+
+}  // namespace json_serializer
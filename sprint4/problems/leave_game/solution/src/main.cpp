@@ -8,6 +8,7 @@
 #include "model_serialization.h"
 #include <cstdlib>
 #include "postgres.h"
+#include "retired_writer.h"
 #include <memory>
 #include "utility_functions.h"
 using namespace std::literals;
@@ -30,6 +31,30 @@ void RunWorkers(unsigned num_threads, const Fn& fn) {
     fn();
 }
 
+void LogConnectionsClosed(const http_server::ConnectionTracker& connections) {
+	std::vector<std::pair<std::string_view, std::uint64_t>> counters;
+	for(size_t i = 0; i < static_cast<size_t>(http_server::CloseReason::COUNT); ++i){
+		const auto reason = static_cast<http_server::CloseReason>(i);
+		counters.emplace_back(http_server::ConvertCloseReasonToString(reason), connections.GetClosedConnections(reason));
+	}
+	event_logger::LogConnectionsClosed(counters);
+}
+
+// Передаёт общему обработчику запросы и соединения, переходящие на WebSocket
+struct ServeRequests {
+	std::shared_ptr<http_handler::RequestHandler> handler;
+
+	template <typename Request, typename Send>
+	void operator()(Request&& req, Send&& send) const {
+		(*handler)(std::forward<Request>(req), std::forward<Send>(send));
+	}
+
+	template <typename Request>
+	bool Upgrade(const Request& req, http_server::SessionStream& stream) const {
+		return handler->Upgrade(req, stream);
+	}
+};
+
 }  // namespace
 
 int main(int argc, const char* argv[]) {
@@ -42,8 +67,20 @@ int main(int argc, const char* argv[]) {
     try {
     	 postgres::Database db{pqxx::connection{GetConfigFromEnv().db_url}};
     	 db.CreateTable();
-        // 1. Загружаем карту из файла и построить модель игры
+        // 1. Инициализируем io_context
+        const unsigned num_threads = std::thread::hardware_concurrency();
+        net::io_context ioc(num_threads);
+        // В режиме io-context-per-core соединения принимаются и обслуживаются отдельными io_context,
+        // а ioc остаётся за игровыми сессиями, тиками и сигналами
+        std::optional<http_server::IoContextPool> io_pool;
+        if(args->io_context_per_core)
+        	io_pool.emplace(num_threads);
+        auto connections = std::make_shared<http_server::ConnectionTracker>(args->server_limits);
+
+        // 2. Загружаем карту из файла и построить модель игры
         model::Game game = json_loader::LoadGame(args->config_file, args->www_root);
+        // Каждая игровая сессия обрабатывается на собственном strand
+        game.SetIoContext(ioc);
         if(args->tick_period > 0)
         	game.SetTickPeriod(args->tick_period);
 
@@ -52,19 +89,30 @@ int main(int argc, const char* argv[]) {
         	game.SetSavePeriod(args->save_period);
 
         	DeserializeSessions(game);
+        	game.SetSnapshotWriter(std::make_shared<serialization::SnapshotWriter>(args->save_file, GetSessionsEncoder(args->save_file),
+        			[path = args->save_file](const std::exception& ex){
+        				event_logger::LogStateSaveFailed(path, ex.what());
+        			}));
+        	game.SetJournal(std::make_shared<serialization::Journal>(args->save_file,
+        			[path = args->save_file](const std::exception& ex){
+        				event_logger::LogStateSaveFailed(path, ex.what());
+        			}));
         }
         game.SetSpawnInRandomPoint(args->spawn_random_points);
-
-        // 2. Инициализируем io_context
-        const unsigned num_threads = std::thread::hardware_concurrency();
-        net::io_context ioc(num_threads);
+        // вышедшие на пенсию игроки пишутся в базу пачками, не задерживая тик
+        game.SetRetiredWriter(std::make_shared<postgres::RetiredWriter>(
+        		[](const postgres::RetiredWriter::Records& records){ SaveRetiredPlayers(records); },
+        		[](const std::exception& ex){ event_logger::LogRetiredSaveFailed(ex.what()); }));
 
         // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         // Подписываемся на сигналы и при их получении завершаем работу сервера
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc, &game](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        signals.async_wait([&ioc, &io_pool, &game, connections](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
         		if (!ec) {
         			ioc.stop();
+        			if(io_pool)
+        				io_pool->Stop();
+        			LogConnectionsClosed(*connections);
         			SerializeSessions(game);
         			event_logger::LogServerEnd("server exited", EXIT_SUCCESS);
         		}
@@ -77,18 +125,27 @@ int main(int argc, const char* argv[]) {
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
         
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto&& req, auto&& send) {
-        	handler->operator()(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        });
+        const ServeRequests serve{handler};
+        // Запросы к игре по-прежнему выполняются на strand-ах сессий в ioc
+        if(io_pool)
+        	http_server::ServeHttp(*io_pool, {address, port}, serve, connections);
+        else
+        	http_server::ServeHttp(ioc, {address, port}, serve, connections);
         
 	event_logger::InitLogger();
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         event_logger::LogStartServer(address.to_string(), port, "server started");
 
         // 6. Запускаем обработку асинхронных операций
+        std::jthread network;
+        if(io_pool)
+        	network = std::jthread([&io_pool] { io_pool->Run(); });
+
         RunWorkers(std::max(1u, num_threads), [&ioc] {
             ioc.run();
         });
+        if(io_pool)
+        	io_pool->Stop();
         
     } catch (const std::exception& ex) {
         event_logger::LogServerEnd("server exited", EXIT_FAILURE, ex.what());
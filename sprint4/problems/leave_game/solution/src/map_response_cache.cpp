@@ -0,0 +1,138 @@
+#include "map_response_cache.h"
+#include "json_serializer.h"
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+
+namespace http_handler {
+
+namespace io = boost::iostreams;
+using namespace std::literals;
+
+namespace {
+
+std::uint64_t HashFnv1a(std::string_view data) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for(unsigned char ch : data){
+        hash ^= ch;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string_view Trim(std::string_view str) noexcept {
+    while(!str.empty() && ((str.front() == ' ') || (str.front() == '\t'))){
+        str.remove_prefix(1);
+    }
+    while(!str.empty() && ((str.back() == ' ') || (str.back() == '\t'))){
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+bool IEquals(std::string_view lhs, std::string_view rhs) noexcept {
+    if(lhs.size() != rhs.size()){
+        return false;
+    }
+    for(size_t i = 0; i < lhs.size(); ++i){
+        if(std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i]))){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Вызывает fn для каждого элемента списка, разделённого запятыми
+template <typename Fn>
+bool AnyListItem(std::string_view list, Fn&& fn){
+    while(!list.empty()){
+        auto comma = list.find(',');
+        if(fn(Trim(list.substr(0, comma)))){
+            return true;
+        }
+        if(comma == std::string_view::npos){
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+}  // namespace
+
+std::string GzipCompress(std::string_view data){
+    std::string out;
+    {
+        io::filtering_ostream os;
+        os.push(io::gzip_compressor(io::gzip_params(io::gzip::best_compression)));
+        os.push(io::back_inserter(out));
+        os.write(data.data(), data.size());
+    }
+    return out;
+}
+
+CachedBody MakeCachedBody(std::string body){
+    CachedBody res;
+
+    char hash[24];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(HashFnv1a(body)));
+    res.etag = "\""s + hash + "\"";
+    res.gzip_etag = "\""s + hash + "-gzip\"";
+
+    // маленькие ответы сжатие только увеличит
+    std::string compressed = GzipCompress(body);
+    if(compressed.size() < body.size()){
+        res.gzip = std::make_shared<const std::string>(std::move(compressed));
+    }
+    res.identity = std::make_shared<const std::string>(std::move(body));
+
+    return res;
+}
+
+MapResponseCache::MapResponseCache(const model::Game& game)
+: map_list_(MakeCachedBody(json_serializer::GetMapListResponce(game))) {
+    for(const auto& map : game.GetMaps()){
+        maps_.emplace(*map.GetId(), MakeCachedBody(json_serializer::GetMapContentResponce(game, *map.GetId())));
+    }
+}
+
+const CachedBody* MapResponseCache::FindMap(std::string_view map_id) const {
+    auto it = maps_.find(map_id);
+    return (it != maps_.end()) ? &it->second : nullptr;
+}
+
+bool AcceptsGzip(std::string_view accept_encoding){
+    return AnyListItem(accept_encoding, [](std::string_view item){
+        auto semicolon = item.find(';');
+        if(!IEquals(Trim(item.substr(0, semicolon)), "gzip")){
+            return false;
+        }
+        if(semicolon == std::string_view::npos){
+            return true;
+        }
+
+        // gzip;q=0 означает отказ от сжатия
+        auto params = Trim(item.substr(semicolon + 1));
+        if((params.size() < 2) || !IEquals(params.substr(0, 2), "q=")){
+            return true;
+        }
+        params.remove_prefix(2);
+        return params.find_first_not_of("0.") != std::string_view::npos;
+    });
+}
+
+bool MatchesETag(std::string_view if_none_match, std::string_view etag){
+    return AnyListItem(if_none_match, [etag](std::string_view item){
+        // для If-None-Match применяется слабое сравнение
+        if(item.starts_with("W/")){
+            item.remove_prefix(2);
+        }
+        return (item == "*") || (item == etag);
+    });
+}
+
+}  // namespace http_handler
@@ -0,0 +1,42 @@
+#pragma once
+#include "model.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+// Готовое тело ответа в двух вариантах кодирования
+struct CachedBody {
+    std::shared_ptr<const std::string> identity;
+    std::shared_ptr<const std::string> gzip;
+    std::string etag;
+    std::string gzip_etag;
+};
+
+/*
+ *  Ответы /api/v1/maps, сформированные один раз при запуске сервера.
+ *  Карты не меняются после загрузки игры, поэтому тела ответов и их ETag неизменны.
+ */
+class MapResponseCache {
+public:
+    explicit MapResponseCache(const model::Game& game);
+
+    const CachedBody& GetMapList() const noexcept { return map_list_; }
+    const CachedBody* FindMap(std::string_view map_id) const;
+
+private:
+    CachedBody map_list_;
+    std::map<std::string, CachedBody, std::less<>> maps_;
+};
+
+CachedBody MakeCachedBody(std::string body);
+std::string GzipCompress(std::string_view data);
+
+// Разбор заголовков Accept-Encoding и If-None-Match
+bool AcceptsGzip(std::string_view accept_encoding);
+bool MatchesETag(std::string_view if_none_match, std::string_view etag);
+
+}  // namespace http_handler
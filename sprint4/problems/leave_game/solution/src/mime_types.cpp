@@ -0,0 +1,48 @@
+#include "mime_types.h"
+
+#include <map>
+
+namespace http_handler {
+
+std::map <std::string_view, std::string> extensionToMime {
+{".htm", "text/html"}, 
+{".html", "text/html"},
+{".css", "text/css"},
+{".txt", "text/plain"},
+{".js", "text/javascript"},
+{".json", "application/json"},
+{".xml", "application/xml"},
+{".png", "image/png"},
+{".jpg", "image/jpeg"},
+{".jpe", "image/jpeg"},
+{".jpeg", "image/jpeg"},
+{".gif", "image/gif"},
+{".bmp", "image/bmp"},
+{".ico", "image/vnd.microsoft.icon"},
+{".tiff", "image/tiff"},
+{".tif", "image/tiff"},
+{".svg", "image/svg+xml"},
+{".svgz", "image/svg+xml"},
+{".mp3", "audio/mpeg"}
+};
+
+std::string GetMimeType(std::string_view extension){
+  auto it = extensionToMime.find(extension);
+  if(it != extensionToMime.end())	
+	return it->second;
+   return "";
+}
+
+std::string_view GetFileExtension(std::string_view path){
+  auto dotPosition = path.find_last_of('.');
+  if(dotPosition != std::string_view::npos){
+
+    auto extension = path.substr(dotPosition);
+    if(!extension.empty()){
+        return extension;
+      }
+    }
+  return "";
+}
+
+}  // namespace http_handler
@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+// Расширение файла вместе с точкой, пустое, если его нет
+std::string_view GetFileExtension(std::string_view path);
+// MIME-тип по расширению, пустой для неизвестного расширения
+std::string GetMimeType(std::string_view extension);
+
+}  // namespace http_handler
@@ -1,9 +1,15 @@
 #include "model.h"
 #include "server_exceptions.h"
 #include "model_serialization.h"
+#include "journal.h"
+#include "retired_writer.h"
+#include "road_topology.h"
+#include "utils.h"
 #include <algorithm>
 #include "utility_functions.h"
 #include <mutex>
+#include <atomic>
+#include <boost/asio/dispatch.hpp>
 
 namespace model {
 using namespace std::literals;
@@ -28,8 +34,20 @@ void Map::AddOffice(Office office) {
     }
 }
 
+void Map::BuildRoadTopology(){
+	road_topology_ = std::make_shared<RoadTopology>(roads_);
+}
+
+const RoadTopology& Map::GetRoadTopology() const{
+	if(!road_topology_){
+		throw std::logic_error("Road topology of map "s + *id_ + " is not built"s);
+	}
+	return *road_topology_;
+}
+
 void Game::AddMap(Map map) {
     const size_t index = maps_.size();
+    map.BuildRoadTopology();
 
     if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
         throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
@@ -60,7 +78,20 @@ std::shared_ptr<GameSession> Game::FindSession(const std::string& map_name){
 	return res;
 }
 
+std::shared_ptr<GameSession> Game::CreateSession(const std::string& map_id){
+	auto [loot_period, loot_probability] = GetLootParameters();
+	std::optional<Strand> strand;
+	if(ioc_){
+		strand.emplace(boost::asio::make_strand(*ioc_));
+	}
+
+	auto session = std::make_shared<GameSession>(map_id, loot_period, loot_probability, std::move(strand));
+	sessions_.push_back(session);
+	return session;
+}
+
 size_t Game::GetNumPlayersInAllSessions(){
+	std::shared_lock lock(*sessions_mutex_);
 	size_t players_coutner = 0;
 		std::for_each(sessions_.begin(), sessions_.end(),[&players_coutner](std::shared_ptr<GameSession>& session){
 			players_coutner += session->GetNumPlayers();
@@ -69,38 +100,81 @@ size_t Game::GetNumPlayersInAllSessions(){
 	return players_coutner;
 }
 
+std::shared_ptr<GameSession> Game::AcquireSession(const std::string& map_id, const std::string& player_name){
+	if(player_name.empty()){
+		throw EmptyNameException();
+	}
+
+	if(!FindMap(Map::Id(map_id))){
+		throw MapNotFoundException();
+	}
+
+	std::unique_lock lock(*sessions_mutex_);
+	std::shared_ptr<GameSession> session = FindSession(map_id);
+	if(!session){
+		session = CreateSession(map_id);
+	}
+
+	// пока вход не завершён, тик не удалит опустевшую сессию
+	session->BeginJoin();
+	return session;
+}
+
+Game::PlayerAuthInfo Game::AddPlayer(const std::shared_ptr<GameSession>& session, const std::string& player_name){
+	const Map* mapToAdd = FindMap(Map::Id(session->GetMap()));
+	auto player = session->AddPlayer(player_name, const_cast<Map*>(mapToAdd), spawn_in_random_points_, default_bag_capacity_);
+	{
+		std::unique_lock lock(*sessions_mutex_);
+		IndexPlayerToken(session, player);
+	}
+	session->EndJoin();
+	return {player->GetToken(), player->GetId()};
+}
 
 Game::PlayerAuthInfo Game::AddPlayer(const std::string& map_id, const std::string& player_name) {
-   const Map* mapToAdd = FindMap(Map::Id(map_id));
-   if(player_name.empty()){
-	    throw EmptyNameException();
-   }
-
-   if(!mapToAdd){
-	    throw MapNotFoundException();
-   }
-
-    std::shared_ptr<GameSession> session = FindSession(map_id);
-    if(!session){
-    	auto [loot_period, loot_probability] = GetLootParameters();
-    	session = std::make_shared<GameSession>(map_id, loot_period, loot_probability);
-    	sessions_.push_back(session);
-    }
+	return AddPlayer(AcquireSession(map_id, player_name), player_name);
+}
+
+std::optional<TokenKey> MakeTokenKey(std::string_view token){
+	if(token.size() != TOKEN_SIZE){
+		return std::nullopt;
+	}
 
-    auto player = session->AddPlayer(player_name, const_cast<Map*>(mapToAdd), spawn_in_random_points_, default_bag_capacity_);
-    return {player->GetToken(), player->GetId()};
+	TokenKey key;
+	std::copy(token.begin(), token.end(), key.begin());
+	return key;
 }
 
-std::shared_ptr<GameSession> Game::GetSessionForToken(const std::string& auth_token){
-	auto itFind = std::find_if(sessions_.begin(), sessions_.end(),[&auth_token](std::shared_ptr<GameSession>& session){
-		return session->HasPlayerWithAuthToken(auth_token) == true;
-	});
+void Game::IndexPlayerToken(const std::shared_ptr<GameSession>& session, const std::shared_ptr<Player>& player){
+	auto key = MakeTokenKey(player->GetToken());
+	if(!key){
+		throw std::logic_error("Invalid player token size");
+	}
+
+	token_index_[*key] = PlayerHandle{session, player};
+}
+
+std::optional<PlayerHandle> Game::FindPlayerByToken(std::string_view auth_token) const{
+	auto key = MakeTokenKey(auth_token);
+	if(!key){
+		return std::nullopt;
+	}
+
+	std::shared_lock lock(*sessions_mutex_);
+	if(auto it = token_index_.find(*key); it != token_index_.end()){
+		return it->second;
+	}
 
-	if(itFind == sessions_.end()){
+	return std::nullopt;
+}
+
+std::shared_ptr<GameSession> Game::GetSessionForToken(const std::string& auth_token){
+	auto handle = FindPlayerByToken(auth_token);
+	if(!handle){
 		return std::shared_ptr<GameSession>();
 	}
 
-	return (*itFind);
+	return handle->session;
 }
 
 const std::vector<std::shared_ptr<Player>> Game::FindAllPlayersForAuthInfo(const std::string& auth_token){
@@ -122,55 +196,25 @@ const vector<LootInfo> Game::GetLootsForAuthInfo(const std::string& auth_token){
 }
 
 std::shared_ptr<Player> Game::GetPlayerWithAuthToken(const std::string& auth_token){
-	auto itFind = std::find_if(sessions_.begin(), sessions_.end(),[&auth_token](std::shared_ptr<GameSession>& session){
-			return session->HasPlayerWithAuthToken(auth_token) == true;
-		});
-
-	if(itFind == sessions_.end()){
+	auto handle = FindPlayerByToken(auth_token);
+	if(!handle){
 		throw PlayerAbsentException();
 	}
 
-	return (*itFind)->GetPlayerWithAuthToken(auth_token);
+	return handle->player;
 }
 
 bool Game::HasSessionWithAuthInfo(const std::string& auth_token){
-	auto itFind = std::find_if(sessions_.begin(), sessions_.end(),[&auth_token](std::shared_ptr<GameSession>& session){
-				return session->HasPlayerWithAuthToken(auth_token) == true;
-			});
-
-	if(itFind == sessions_.end()){
-		return false;
-	}
-
-	return true;
+	return FindPlayerByToken(auth_token).has_value();
 }
 
 std::shared_ptr<GameSession> Game::GetSessionWithAuthInfo(const std::string& auth_token){
-	auto itFind = std::find_if(sessions_.begin(), sessions_.end(),[&auth_token](std::shared_ptr<GameSession>& session){
-					return session->HasPlayerWithAuthToken(auth_token) == true;
-				});
-
-	if(itFind == sessions_.end()){
+	auto handle = FindPlayerByToken(auth_token);
+	if(!handle){
 		throw InvalidSessionException();
 	}
 
-	return *itFind;
-}
-
-void Game::MoveDogs(int deltaTime){
-	std::for_each(sessions_.begin(), sessions_.end(),[deltaTime](std::shared_ptr<GameSession>& session){
-		session->MoveDogs(deltaTime);
-	});
-}
-
-void Game::GenerateLoot(int deltaTime){
-	std::for_each(sessions_.begin(), sessions_.end(),[this, deltaTime](std::shared_ptr<GameSession>& session){
-		const auto& mapName =  session->GetMap();
-		const Map* pMap = this->FindMap(model::Map::Id(mapName));
-		if(pMap){
-			session->GenerateLoot(deltaTime, pMap);
-		}
-	});
+	return handle->session;
 }
 
 void Game::SetLootParameters(double period, double probability){
@@ -181,6 +225,7 @@ void Game::SetLootParameters(double period, double probability){
 std::shared_ptr<GameSessionsStates> Game::GetGameSessionsStates() const{
 	std::shared_ptr<GameSessionsStates> res = std::make_shared<GameSessionsStates>();
 
+	std::shared_lock lock(*sessions_mutex_);
 	for(const auto& session : sessions_){
 		res->states.push_back(session->GetState());
 	}
@@ -188,101 +233,187 @@ std::shared_ptr<GameSessionsStates> Game::GetGameSessionsStates() const{
 	return res;
 }
 
-void Game::SaveSessions(int deltaTime){
-	if(!save_period_){
-		return;
+void Game::RestoreSessions(const model::GameSessionsStates& sessions){
+	std::vector<std::shared_ptr<GameSession>> restored;
+	std::vector<Map*> maps;
+	restored.reserve(sessions.states.size());
+	maps.reserve(sessions.states.size());
+	{
+		std::unique_lock lock(*sessions_mutex_);
+		for(const auto& state : sessions.states){
+			const Map* map = FindMap(Map::Id(state.map_id_));
+			if(!map){
+				throw MapNotFoundException();
+			}
+			restored.push_back(CreateSession(state.map_id_));
+			maps.push_back(const_cast<Map*>(map));
+		}
 	}
-	SerializeSessions(*this, deltaTime, save_period_);
-}
 
-void Game::RestoreSessions(const model::GameSessionsStates& sessions){
-	std::for_each(sessions.states.begin(), sessions.states.end(), [this](auto& state){
-
-		auto [loot_period, loot_probability] = GetLootParameters();
-		auto session = std::make_shared<GameSession>(state.map_id_, loot_period, loot_probability);
-		session->SetPlayerId(state.player_id_);
-		session->SetLootsInfo(state.loots_info_state);
-		const Map* mapToAdd = FindMap(Map::Id(state.map_id_));
-
-		std::for_each(state.player_state_.begin(), state.player_state_.end(),
-					  [this, mapToAdd, &session](auto& pl_state){
-					   auto player = session->AddPlayer(pl_state.name_, const_cast<Map*>(mapToAdd),
-							   	   	   	   	   	   	    spawn_in_random_points_, default_bag_capacity_);
-					   player->SetToken(pl_state.token_);
-					   player->SetId(pl_state.id_);
-					   auto dog = player->GetDog();
-
-					   dog->SetDirection(pl_state.dog_direction_);
-					   dog->SetPositionOnMap(pl_state.dog_position_);
-					   dog->SetGatheredLoot(pl_state.gathered_loots_);
-					   dog->SetBagCapacity(pl_state.bag_capacity_);
-					   dog->SetScore(pl_state.score_);
-					   dog->SetPlayTime(pl_state.play_time_);
-					 });
-
-		sessions_.push_back(session);
+	// сессии ещё не тикают и не связаны друг с другом, поэтому восстанавливаются параллельно
+	utils::ParallelFor(restored.size(), [&](size_t i){
+		restored[i]->RestoreState(sessions.states[i], maps[i]);
 	});
+
+	std::unique_lock lock(*sessions_mutex_);
+	size_t players = token_index_.size();
+	for(const auto& session : restored){
+		players += session->GetNumPlayers();
+	}
+	token_index_.reserve(players);
+	for(const auto& session : restored){
+		for(const auto& player : session->GetPlayers()){
+			IndexPlayerToken(session, player);
+		}
+	}
 }
 
-void Game::HandleRetiredPlayers(){
-	std::lock_guard lg(db_update_mutex);
-	auto expired_players = FindExpiredPlayers();
-	if(expired_players.empty())
+void Game::TickSessions(int deltaTime, std::function<void(std::shared_ptr<TickResult>)> on_done){
+	auto result = std::make_shared<TickResult>();
+
+	if(save_period_){
+		time_without_saving_ += deltaTime;
+		if(time_without_saving_ >= save_period_){
+			result->states = std::make_shared<GameSessionsStates>();
+			time_without_saving_ = 0;
+			// изменения этого тика уже идут в новый сегмент, прежние покрываются сохранением
+			if(journal_){
+				result->journal_segment = journal_->StartSegment();
+			}
+		}
+	}
+
+	std::vector<std::shared_ptr<GameSession>> sessions;
+	{
+		std::shared_lock lock(*sessions_mutex_);
+		sessions = sessions_;
+	}
+
+	if(sessions.empty()){
+		on_done(std::move(result));
 		return;
-	SaveExpiredPlayers(expired_players);
-	DeleteExpiredPlayers(expired_players);
+	}
+
+	auto remaining = std::make_shared<std::atomic<size_t>>(sessions.size());
+	auto shared_done = std::make_shared<std::function<void(std::shared_ptr<TickResult>)>>(std::move(on_done));
+
+	for(const auto& session : sessions){
+		auto task = [this, session, deltaTime, result, remaining, shared_done]{
+			TickSession(session, deltaTime, *result);
+			if(--(*remaining) == 0){
+				(*shared_done)(result);
+			}
+		};
+
+		if(session->HasStrand()){
+			boost::asio::dispatch(session->GetStrand(), std::move(task));
+		} else {
+			task();
+		}
+	}
 }
 
-std::vector<RetiredSessionPlayers> Game::FindExpiredPlayers(){
-	std::vector<RetiredSessionPlayers> res;
+void Game::ApplyPendingActions(const std::shared_ptr<GameSession>& session){
+	const Map* pMap = FindMap(Map::Id(session->GetMap()));
+	const double map_speed = pMap ? pMap->GetDogSpeed() : 0.0;
+	session->ApplyPendingActions(map_speed > 0.0 ? map_speed : default_dog_speed_);
+}
+
+void Game::TickSession(const std::shared_ptr<GameSession>& session, int deltaTime, TickResult& result){
+	// команды, пришедшие после прошлого тика, действуют с начала этого
+	ApplyPendingActions(session);
 
-	for(auto itSession = sessions_.begin(); itSession != sessions_.end(); ++itSession){
-		RetiredSessionPlayers pairs;
-		const auto& players = (*itSession)->GetPlayers();
+	if(const Map* pMap = FindMap(Map::Id(session->GetMap()))){
+		session->GenerateLoot(deltaTime, pMap);
+	}
+	session->MoveDogs(deltaTime);
 
-		for(auto itPlayer = players.begin(); itPlayer != players.end(); ++itPlayer){
-				auto dog = (*itPlayer)->GetDog();
-				auto idle_time = dog->GetIdleTime();
-				if(idle_time >= dog_retierement_time_)
-				{
-					pairs.second.push_back(*itPlayer);
-				}
+	// состояние снимается после движения, как и при сохранении в конце тика
+	if(result.states){
+		auto state = session->GetState();
+		std::lock_guard lock(result.mutex);
+		result.states->states.push_back(std::move(state));
+	}
+
+	auto expired_players = session->FindExpiredPlayers(dog_retierement_time_);
+	if(!expired_players.empty()){
+		{
+			std::lock_guard lock(result.mutex);
+			result.retired_players.emplace_back(session, expired_players);
 		}
+		DeleteExpiredPlayers(session, expired_players);
+	}
+	session->FinishTick();
 
-		if(!pairs.second.empty()){
-			pairs.first = *itSession;
-			res.push_back(pairs);
+	if(journal_){
+		const auto records = serialization::EncodeJournalRecords(*session, session->GetChangesSince(session->GetTick() - 1));
+		if(!records.empty()){
+			journal_->Append(records);
+		}
+	}
+
+	if(session_tick_listener_){
+		session_tick_listener_(session);
+	}
+}
+
+void Game::FinishTick(const TickResult& result){
+	std::lock_guard lg(db_update_mutex);
+	SaveExpiredPlayers(result.retired_players);
+
+	if(journal_){
+		journal_->Commit();
+	}
+
+	if(result.states){
+		if(snapshot_writer_){
+			std::function<void()> on_written;
+			if(journal_){
+				on_written = [journal = journal_, segment = result.journal_segment]{ journal->DropSegmentsBefore(segment); };
+			}
+			snapshot_writer_->Submit(result.states, std::move(on_written));
+		} else {
+			SerializeSessions(*result.states, save_path_);
+			if(journal_){
+				journal_->DropSegmentsBefore(result.journal_segment);
+			}
 		}
 	}
-	return res;
 }
 
 void Game::SaveExpiredPlayers(const std::vector<RetiredSessionPlayers>& expired_sessions_players){
 
+	std::vector<PlayerRecordItem> records;
 	for(auto itSesPlrs = expired_sessions_players.begin(); itSesPlrs != expired_sessions_players.end(); ++itSesPlrs){
 		for(auto itPlayer = itSesPlrs->second.begin(); itPlayer != itSesPlrs->second.end(); ++itPlayer){
 			auto dog = (*itPlayer)->GetDog();
-			SaveRetiredPlayer((*itPlayer)->GetName(), dog->GetScore(), dog->GetPlayTime());
+			records.push_back(MakeRetiredRecord((*itPlayer)->GetName(), dog->GetScore(), dog->GetPlayTime()));
 		}
 	}
+	if(records.empty()){
+		return;
+	}
+
+	if(retired_writer_){
+		retired_writer_->Enqueue(std::move(records));
+	} else {
+		SaveRetiredPlayers(records);
+	}
 }
 
-void Game::DeleteExpiredPlayers(const std::vector<RetiredSessionPlayers>& expired_sessions_players){
-	for(auto itSesPlrs = expired_sessions_players.begin(); itSesPlrs != expired_sessions_players.end(); ++itSesPlrs){
-		auto itSes = std::find_if(sessions_.begin(), sessions_.end(), [itSesPlrs](auto& elem){
-			return elem == itSesPlrs->first;
-		});
+void Game::DeleteExpiredPlayers(const std::shared_ptr<GameSession>& session, const std::vector<std::shared_ptr<Player>>& expired_players){
+	session->DeleteRetiredPlayers(expired_players);
 
-		if(itSes == sessions_.end()){
-			continue;
+	std::unique_lock lock(*sessions_mutex_);
+	for(const auto& player : expired_players){
+		if(auto key = MakeTokenKey(player->GetToken())){
+			token_index_.erase(*key);
 		}
+	}
 
-		(*itSes)->DeleteRetiredPlayers(itSesPlrs->second);
-
-		if(!(*itSes)->GetNumPlayers()){
-			const auto new_end{std::remove(std::begin(sessions_), std::end(sessions_), *itSes)};
-			sessions_.erase(new_end, std::end(sessions_));
-		}
+	if(!session->GetNumPlayers() && !session->GetPendingJoins()){
+		const auto new_end{std::remove(std::begin(sessions_), std::end(sessions_), session)};
+		sessions_.erase(new_end, std::end(sessions_));
 	}
 }
 
@@ -4,13 +4,33 @@
 #include "tagged.h"
 #include <memory>
 #include <functional>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+namespace boost::asio {
+	class io_context;
+}
 
 namespace model {
 	class Player;
 	class GameSession;
+	class RoadTopology;
 	struct GameSessionsStates;
 }
 
+namespace serialization {
+	class SnapshotWriter;
+	class Journal;
+}
+
+namespace postgres {
+	class RetiredWriter;
+}
+
 using RetiredSessionPlayers = std::pair<std::shared_ptr<model::GameSession>, std::vector<std::shared_ptr<model::Player>>>;
 namespace model {
 
@@ -222,6 +242,7 @@ public:
 
     void AddRoad(const Road& road) {
         roads_.emplace_back(road);
+        road_topology_.reset();
     }
 
     void AddBuilding(const Building& building) {
@@ -237,7 +258,10 @@ public:
 
     void SetDogSpeed(double speed) { dog_speed_ = speed; }
     void SetBagCapacity(unsigned capacity) { bag_capacity_ = capacity;}
-    
+
+    // Топология строится один раз, когда все дороги карты уже добавлены
+    void BuildRoadTopology();
+    const RoadTopology& GetRoadTopology() const;
 
 private:
     using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
@@ -250,6 +274,7 @@ private:
     OfficeIdToIndex warehouse_id_to_index_;
     Offices offices_;
     Loots loots_;
+    std::shared_ptr<const RoadTopology> road_topology_;
     double dog_speed_{0.0};
     unsigned bag_capacity_{};
 };
@@ -273,6 +298,23 @@ struct DogPos{
 
 enum class DogDirection { NORTH, SOUTH, WEST, EAST, STOP };
 
+// Токен игрока фиксированной длины - ключ глобального индекса Game
+constexpr size_t TOKEN_SIZE = 32;
+using TokenKey = std::array<char, TOKEN_SIZE>;
+
+struct TokenKeyHasher {
+    size_t operator()(const TokenKey& key) const noexcept {
+        return std::hash<std::string_view>{}(std::string_view(key.data(), key.size()));
+    }
+};
+
+std::optional<TokenKey> MakeTokenKey(std::string_view token);
+
+struct PlayerHandle {
+    std::shared_ptr<GameSession> session;
+    std::shared_ptr<Player> player;
+};
+
 struct PlayerRecordItem{
 	std::string id;
 	std::string name;
@@ -280,6 +322,16 @@ struct PlayerRecordItem{
 	int playTime;
 };
 
+// Результаты тика, собранные со всех игровых сессий
+struct TickResult {
+	std::mutex mutex;
+	std::vector<RetiredSessionPlayers> retired_players;
+	// заполняется, если в этом тике нужно сохранить состояние игры
+	std::shared_ptr<GameSessionsStates> states;
+	// сегмент журнала, начатый вместе с этим сохранением
+	std::uint64_t journal_segment{0};
+};
+
 class Game {
 public:
     using Maps = std::vector<Map>;
@@ -293,6 +345,27 @@ public:
     void AddSavePath(const std::filesystem::path& save_path) {
     	save_path_ = save_path;
     }
+    // С ним сохранение по периоду не задерживает тик: состояние записывается в фоновом потоке
+    void SetSnapshotWriter(std::shared_ptr<serialization::SnapshotWriter> writer) {
+    	snapshot_writer_ = std::move(writer);
+    }
+    const std::shared_ptr<serialization::SnapshotWriter>& GetSnapshotWriter() const {
+    	return snapshot_writer_;
+    }
+    // Изменения каждого тика дописываются в журнал, и между сохранениями состояние не теряется
+    void SetJournal(std::shared_ptr<serialization::Journal> journal) {
+    	journal_ = std::move(journal);
+    }
+    const std::shared_ptr<serialization::Journal>& GetJournal() const {
+    	return journal_;
+    }
+    // С ним тик только ставит вышедших на пенсию игроков в очередь, а в базу их пишет поток писателя
+    void SetRetiredWriter(std::shared_ptr<postgres::RetiredWriter> writer) {
+    	retired_writer_ = std::move(writer);
+    }
+    const std::shared_ptr<postgres::RetiredWriter>& GetRetiredWriter() const {
+    	return retired_writer_;
+    }
 
 
     const std::filesystem::path& GetBasePath() {
@@ -318,8 +391,14 @@ public:
     bool HasSessionWithAuthInfo(const std::string& auth_token);
     Game::PlayerAuthInfo AddPlayer(const std::string& map_id, const std::string& player_name);
 
+    // Находит (или создаёт) сессию карты для входа игрока. Сам игрок добавляется
+    // вызовом AddPlayer(session, ...) на strand этой сессии.
+    std::shared_ptr<GameSession> AcquireSession(const std::string& map_id, const std::string& player_name);
+    Game::PlayerAuthInfo AddPlayer(const std::shared_ptr<GameSession>& session, const std::string& player_name);
+
     const std::vector<LootInfo> GetLootsForAuthInfo(const std::string& auth_token);
     std::shared_ptr<Player> GetPlayerWithAuthToken(const std::string& auth_token);
+    std::optional<PlayerHandle> FindPlayerByToken(std::string_view auth_token) const;
     double GetDefaultDogSpeed() { return default_dog_speed_;}
     std::shared_ptr<GameSession> GetSessionWithAuthInfo(const std::string& auth_token);
     int GetTickPeriod() { return tick_period_;}
@@ -337,34 +416,57 @@ public:
     void SetSavePeriod(int period) { save_period_ = period; }
     void SetLootParameters(double period, double probability);
     void SetDefaultBagCapacity(unsigned capacity) { default_bag_capacity_ = capacity; }
+    // Сессии, созданные после вызова, получают собственный strand в этом io_context
+    void SetIoContext(boost::asio::io_context& ioc) { ioc_ = &ioc; }
+    // Вызывается на strand сессии после каждого её тика, например, чтобы разослать состояние подписчикам
+    void SetSessionTickListener(std::function<void(const std::shared_ptr<GameSession>&)> listener) {
+    	session_tick_listener_ = std::move(listener);
+    }
 
-    void MoveDogs(int deltaTime);
-    void GenerateLoot(int deltaTime);
-    void SaveSessions(int deltaTime);
+    // Параллельно выполняет тик всех сессий на их strand-ах и вызывает on_done
+    // после завершения последней. Без io_context сессии обрабатываются сразу.
+    // Счёт времени до сохранения не защищён: вызовы должны идти последовательно, с одного strand-а
+    void TickSessions(int deltaTime, std::function<void(std::shared_ptr<TickResult>)> on_done);
+    // Применяет команды игроков, накопленные сессией. Вызывается на strand сессии
+    void ApplyPendingActions(const std::shared_ptr<GameSession>& session);
+    // Сохраняет вышедших на пенсию игроков и состояние игры, собранные в тике
+    void FinishTick(const TickResult& result);
     void RestoreSessions(const model::GameSessionsStates& sessions);
-    void HandleRetiredPlayers();
 
 private:
     std::shared_ptr<GameSession> FindSession(const std::string& map_name);
     std::shared_ptr<GameSession> GetSessionForToken(const std::string& auth_token);
-    std::vector<RetiredSessionPlayers> FindExpiredPlayers();
+    std::shared_ptr<GameSession> CreateSession(const std::string& map_id);
+    void IndexPlayerToken(const std::shared_ptr<GameSession>& session, const std::shared_ptr<Player>& player);
+    void TickSession(const std::shared_ptr<GameSession>& session, int deltaTime, TickResult& result);
+    void DeleteExpiredPlayers(const std::shared_ptr<GameSession>& session, const std::vector<std::shared_ptr<Player>>& expired_players);
 
     void SaveExpiredPlayers(const std::vector<RetiredSessionPlayers>& expired_sessions_players);
-    void DeleteExpiredPlayers(const std::vector<RetiredSessionPlayers>& expired_sessions_players);
 private:
     using MapIdHasher = util::TaggedHasher<Map::Id>;
     using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
+    using TokenToPlayer = std::unordered_map<TokenKey, PlayerHandle, TokenKeyHasher>;
 
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
     std::filesystem::path base_path_;
     std::filesystem::path save_path_;
+    std::shared_ptr<serialization::SnapshotWriter> snapshot_writer_;
+    std::shared_ptr<serialization::Journal> journal_;
+    std::shared_ptr<postgres::RetiredWriter> retired_writer_;
+    boost::asio::io_context* ioc_{nullptr};
+    std::function<void(const std::shared_ptr<GameSession>&)> session_tick_listener_;
+
+    // защищает sessions_ и token_index_, к которым обращаются strand-ы разных сессий
+    std::unique_ptr<std::shared_mutex> sessions_mutex_ = std::make_unique<std::shared_mutex>();
     std::vector<std::shared_ptr<GameSession>> sessions_;
+    TokenToPlayer token_index_;
     
     double default_dog_speed_{0.0};
     double dog_retierement_time_{60.0*1000};
     int tick_period_{-1};
     int save_period_{0};
+    int time_without_saving_{0};
     bool spawn_in_random_points_{false};
     double loot_period_{};
     double loot_probability_{};
@@ -10,6 +10,9 @@
 #include "dog.h"
 #include "game_session.h"
 #include "geom.h"
+#include "snapshot_writer.h"
+#include "journal.h"
+#include "state_archive.h"
 #include <chrono>
 
 namespace geom {
@@ -63,41 +66,87 @@ namespace /*serialization*/ {
 
 using InputArchive = boost::archive::text_iarchive;
 using OutputArchive = boost::archive::text_oarchive;
-using TimeInterval = std::chrono::milliseconds;
+std::string EncodeSessions(const model::GameSessionsStates& states){
+	 std::stringstream ss;
+	 {
+		 OutputArchive oa{ss};
+		 oa << states;
+	 }
+	 return std::move(ss).str();
+}
+
+std::string EncodeSessions(const model::GameSessionsStates& states, serialization::SaveFormat format){
+	return format == serialization::SaveFormat::BINARY ? serialization::EncodeBinaryArchive(states) : EncodeSessions(states);
+}
 
-TimeInterval time_without_saving_{};
+// Кодировщик для фоновой записи в файл path
+serialization::SnapshotWriter::Encoder GetSessionsEncoder(const std::filesystem::path& path){
+	return [format = serialization::GetSaveFormat(path)](const model::GameSessionsStates& states){
+		return EncodeSessions(states, format);
+	};
+}
+
+// Формат файла определяется по содержимому, поэтому читаются и сохранения прежних версий
+model::GameSessionsStates LoadSessions(std::string_view data){
+	if(serialization::IsBinaryArchive(data)){
+		return serialization::DecodeBinaryArchive(data);
+	}
+
+	model::GameSessionsStates states;
+	std::istringstream ss{std::string(data)};
+	InputArchive ia{ss};
+	ia >> states;
+	return states;
+}
+
+// Файл сохранения заменяется целиком, поэтому прерванная запись не портит прошлое сохранение
+void SerializeSessions(const model::GameSessionsStates& states, const std::filesystem::path& save_path){
+	serialization::WriteFileAtomically(save_path, EncodeSessions(states, serialization::GetSaveFormat(save_path)));
+}
 
 void DeserializeSessions(model::Game& game){
 	model::GameSessionsStates states;
 
 	if(std::filesystem::exists(game.GetSavePath())){
-		std::ifstream file{game.GetSavePath()};
-		InputArchive ia{file};
-		ia >> states;
+		// двоичное сохранение разбирается прямо из отображённого файла, без копии в памяти
+		const serialization::MappedFile file(game.GetSavePath());
+		const std::string_view data = file.GetData();
+		states = LoadSessions(data);
+		// сохранение в другом формате сразу переписывается в формате, выбранном для файла
+		const bool is_binary = serialization::IsBinaryArchive(data);
+		if(is_binary != (serialization::GetSaveFormat(game.GetSavePath()) == serialization::SaveFormat::BINARY)){
+			SerializeSessions(states, game.GetSavePath());
+		}
 	}
+	// изменения после последнего сохранения
+	serialization::ReplayJournal(game.GetSavePath(), states);
 	game.RestoreSessions(states);
 }
 
-
 void SerializeSessions(const model::Game& game){
-	 std::stringstream ss;
-	 OutputArchive oa{ss};
-	 oa << *game.GetGameSessionsStates();
-
-	 std::ofstream ofs(game.GetSavePath());
-	 ofs << ss.str();
-}
-
-void SerializeSessions(const model::Game& game, int deltaTime, int savePeriod){
-	time_without_saving_ += TimeInterval{deltaTime};
-
-	if(time_without_saving_ < TimeInterval{savePeriod}){
-		return ;
+	if(game.GetSavePath().empty()){
+		return;
+	}
+	const auto& journal = game.GetJournal();
+	const std::uint64_t segment = journal ? journal->StartSegment() : 0;
+	auto states = game.GetGameSessionsStates();
+	if(const auto& writer = game.GetSnapshotWriter()){
+		// через тот же поток, чтобы запись более старого снимка не легла поверх этого
+		std::function<void()> on_written;
+		if(journal){
+			on_written = [journal, segment]{ journal->DropSegmentsBefore(segment); };
+		}
+		writer->Submit(std::move(states), std::move(on_written));
+		writer->Flush();
+	} else {
+		SerializeSessions(*states, game.GetSavePath());
+		if(journal){
+			journal->DropSegmentsBefore(segment);
+		}
+	}
+	if(journal){
+		journal->Flush();
 	}
-
-	SerializeSessions(game);
-
-	time_without_saving_ = {};
 }
 
 void SerializeGameSession(const model::GameSession& session){
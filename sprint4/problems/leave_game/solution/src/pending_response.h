@@ -0,0 +1,175 @@
+#pragma once
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "connection_arena.h"
+#include "shared_string_body.h"
+
+namespace http_server {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+// Сокет сессии сразу связан со strand: тип исполнителя известен, и его копирование не требует выделения памяти
+using SessionExecutor = net::strand<net::io_context::executor_type>;
+using SessionStream = beast::basic_stream<tcp, SessionExecutor>;
+using SessionSocket = SessionStream::socket_type;
+
+class SessionBase;
+
+// Завершение записи ответов сессии
+struct WriteCompletion {
+    std::shared_ptr<SessionBase> session;
+
+    void operator()(beast::error_code ec, std::size_t bytes_written);
+};
+
+using WriteCompletionHandler = PooledHandler<WriteCompletion>;
+
+// Представление буферов без владения: операция записи копирует его вместо копирования вектора
+class BuffersView {
+public:
+    using value_type = net::const_buffer;
+    using const_iterator = const net::const_buffer*;
+
+    explicit BuffersView(const std::vector<net::const_buffer>& buffers) noexcept
+        : first_(buffers.data()), last_(buffers.data() + buffers.size()) {
+    }
+
+    const_iterator begin() const noexcept { return first_; }
+    const_iterator end() const noexcept { return last_; }
+
+private:
+    const_iterator first_;
+    const_iterator last_;
+};
+
+// Тело, которое целиком лежит в памяти и отдаётся готовыми буферами
+template <typename Body>
+struct IsGatherableBody : std::false_type {};
+
+template <>
+struct IsGatherableBody<http::string_body> : std::true_type {};
+
+template <>
+struct IsGatherableBody<http::empty_body> : std::true_type {};
+
+template <>
+struct IsGatherableBody<SharedStringBody> : std::true_type {};
+
+/*
+ *  Ответ, ожидающий отправки в очереди сессии.
+ *  Ответы с телом в памяти отдают буферы заголовков и тела, и несколько таких ответов уходят одной записью.
+ *  Остальные (например, файлы) отправляются по одному через http::async_write.
+ */
+class PendingResponse {
+public:
+    virtual ~PendingResponse() = default;
+
+    virtual bool CanGather() const = 0;
+    // Буферы действительны, пока ответ не удалён из очереди
+    virtual void AppendBuffers(std::vector<net::const_buffer>& buffers) = 0;
+    virtual void AsyncWrite(SessionStream& stream, WriteCompletionHandler&& handler) = 0;
+    virtual bool NeedEof() const = 0;
+};
+
+template <typename Body, typename Fields>
+class PendingResponseImpl final : public PendingResponse {
+public:
+    explicit PendingResponseImpl(http::response<Body, Fields>&& response)
+        : response_(std::move(response)) {
+    }
+
+    bool CanGather() const override {
+        if constexpr (IsGatherableBody<Body>::value) {
+            return !response_.chunked();
+        } else {
+            return false;
+        }
+    }
+
+    void AppendBuffers(std::vector<net::const_buffer>& buffers) override {
+        if constexpr (IsGatherableBody<Body>::value) {
+            // Так же, как http::serializer: строка статуса и поля, затем тело без копирования
+            fields_writer_.emplace(response_.base(), response_.version(), response_.result_int());
+            Append(buffers, fields_writer_->get());
+
+            typename Body::writer body_writer(response_.base(), response_.body());
+            beast::error_code ec;
+            body_writer.init(ec);
+            while (!ec) {
+                auto result = body_writer.get(ec);
+                if (!result) {
+                    break;
+                }
+                Append(buffers, result->first);
+                if (!result->second) {
+                    break;
+                }
+            }
+        }
+    }
+
+    void AsyncWrite(SessionStream& stream, WriteCompletionHandler&& handler) override {
+        http::async_write(stream, response_, std::move(handler));
+    }
+
+    bool NeedEof() const override {
+        return response_.need_eof();
+    }
+
+private:
+    template <typename ConstBufferSequence>
+    static void Append(std::vector<net::const_buffer>& buffers, const ConstBufferSequence& sequence) {
+        for (auto it = net::buffer_sequence_begin(sequence); it != net::buffer_sequence_end(sequence); ++it) {
+            if (net::const_buffer buffer = *it; buffer.size() > 0) {
+                buffers.push_back(buffer);
+            }
+        }
+    }
+
+    http::response<Body, Fields> response_;
+    std::optional<typename Fields::writer> fields_writer_;
+};
+
+// Ответы размещаются в пуле памяти соединения
+class PendingResponseDeleter {
+public:
+    PendingResponseDeleter() = default;
+    PendingResponseDeleter(HandlerMemoryPool* pool, size_t size) noexcept : pool_(pool), size_(size) {}
+
+    void operator()(PendingResponse* response) const noexcept {
+        response->~PendingResponse();
+        pool_->Deallocate(response, size_);
+    }
+
+private:
+    HandlerMemoryPool* pool_{nullptr};
+    size_t size_{0};
+};
+
+using PendingResponsePtr = std::unique_ptr<PendingResponse, PendingResponseDeleter>;
+
+template <typename Body, typename Fields>
+PendingResponsePtr MakePendingResponse(HandlerMemoryPool& pool, http::response<Body, Fields>&& response) {
+    using Impl = PendingResponseImpl<Body, Fields>;
+    static_assert(alignof(Impl) <= alignof(std::max_align_t));
+
+    void* memory = pool.Allocate(sizeof(Impl));
+    try {
+        return PendingResponsePtr(new (memory) Impl(std::move(response)), PendingResponseDeleter(&pool, sizeof(Impl)));
+    } catch (...) {
+        pool.Deallocate(memory, sizeof(Impl));
+        throw;
+    }
+}
+
+}  // namespace http_server
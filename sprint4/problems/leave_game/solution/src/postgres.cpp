@@ -18,6 +18,23 @@ void RetiredRepositoryImpl::SaveRetired(const model::PlayerRecordItem& retired){
 	work.commit();
 }
 
+void RetiredRepositoryImpl::SaveRetired(const std::vector<model::PlayerRecordItem>& retired){
+	if(retired.empty()){
+		return;
+	}
+
+	pqxx::work work{connection_};
+	std::string query = "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES "s;
+	for(size_t i = 0; i < retired.size(); ++i){
+		const auto& record = retired[i];
+		query += (i == 0 ? "("s : ", ("s) + work.quote(record.id) + ", "s + work.quote(record.name) + ", "s
+				 + std::to_string(record.score) + ", "s + std::to_string(record.playTime) + ")"s;
+	}
+	query += " ON CONFLICT (id) DO NOTHING;"s;
+	work.exec(query);
+	work.commit();
+}
+
 std::vector<model::PlayerRecordItem> RetiredRepositoryImpl::GetRetired(int start, int max_items){
 	pqxx::read_transaction rd(connection_);
 	auto req = boost::format("SELECT id, name, score, play_time_ms FROM retired_players ORDER BY score DESC, play_time_ms LIMIT %1% OFFSET %2%;") % max_items % start;
@@ -12,6 +12,9 @@ public:
     {}
 
     void SaveRetired(const model::PlayerRecordItem& retired);
+    // Одна транзакция и один INSERT на всю пачку. Запись с уже сохранённым id пропускается,
+    // поэтому пачку, о фиксации которой ответ не пришёл, можно повторить
+    void SaveRetired(const std::vector<model::PlayerRecordItem>& retired);
     std::vector<model::PlayerRecordItem> GetRetired(int start = 0, int max_items = 100);
 private:
     pqxx::connection& connection_;
@@ -6,47 +6,6 @@ namespace sys = boost::system;
 
 namespace http_handler {
 
-std::map <std::string_view, std::string> extensionToMime {
-{".htm", "text/html"}, 
-{".html", "text/html"},
-{".css", "text/css"},
-{".txt", "text/plain"},
-{".js", "text/javascript"},
-{".json", "application/json"},
-{".xml", "application/xml"},
-{".png", "image/png"},
-{".jpg", "image/jpeg"},
-{".jpe", "image/jpeg"},
-{".jpeg", "image/jpeg"},
-{".gif", "image/gif"},
-{".bmp", "image/bmp"},
-{".ico", "image/vnd.microsoft.icon"},
-{".tiff", "image/tiff"},
-{".tif", "image/tiff"},
-{".svg", "image/svg+xml"},
-{".svgz", "image/svg+xml"},
-{".mp3", "audio/mpeg"}
-};
-
-std::string GetMimeType(std::string_view extension){
-  auto it = extensionToMime.find(extension);
-  if(it != extensionToMime.end())	
-	return it->second;
-   return "";
-}
-
-std::string_view GetFileExtension(std::string_view path){
-  auto dotPosition = path.find_last_of('.');
-  if(dotPosition != std::string_view::npos){
-
-    auto extension = path.substr(dotPosition);
-    if(!extension.empty()){
-        return extension;
-      }
-    }
-  return "";
-}
-
 StaticFileResponce MakeFileResponce(const std::filesystem::path& json_path, const std::string& mime_type){
     http::response<http::file_body> res;
     res.version(11);  // HTTP/1.1
@@ -65,4 +24,42 @@ StaticFileResponce MakeFileResponce(const std::filesystem::path& json_path, cons
     res.prepare_payload();
     return res;
  }
+SharedStringResponse MakeStaticFileResponse(const StaticFile& file, http::status status, bool with_body,
+                                            unsigned http_version, bool keep_alive){
+    const bool not_modified = (status == http::status::not_modified);
+    auto resp = MakeSharedStringResponse(status, (with_body && !not_modified) ? file.content : nullptr, http_version, keep_alive,
+    									 file.mime_type, {{http::field::etag, file.etag}, {http::field::last_modified, file.last_modified}});
+    if(not_modified){
+    	resp.erase(http::field::content_type);
+    }else if(!with_body){
+    	// на HEAD - те же заголовки, что у GET, включая размер файла, даже если он не хранится в памяти
+    	resp.content_length(file.size);
+    }
+    return resp;
+}
+
+SharedStringResponse MakeCachedResponse(const CachedBody& body, http::verb method, std::string_view accept_encoding,
+                                        std::string_view if_none_match, unsigned http_version, bool keep_alive){
+    const bool use_gzip = body.gzip && AcceptsGzip(accept_encoding);
+    const std::string& etag = use_gzip ? body.gzip_etag : body.etag;
+
+    if(MatchesETag(if_none_match, etag)){
+    	auto resp = MakeSharedStringResponse(http::status::not_modified, nullptr, http_version, keep_alive, ContentType::APPLICATION_JSON,
+    										 {{http::field::cache_control, "no-cache"sv}, {http::field::etag, etag}, {http::field::vary, "Accept-Encoding"sv}});
+    	resp.erase(http::field::content_type);
+    	return resp;
+    }
+
+    auto resp = MakeSharedStringResponse(http::status::ok, use_gzip ? body.gzip : body.identity, http_version, keep_alive, ContentType::APPLICATION_JSON,
+    									 {{http::field::cache_control, "no-cache"sv}, {http::field::etag, etag}, {http::field::vary, "Accept-Encoding"sv}});
+    if(use_gzip){
+    	resp.set(http::field::content_encoding, "gzip"sv);
+    }
+    // на HEAD отвечаем только заголовками, но Content-Length остаётся тем же, что у GET
+    if(method == http::verb::head){
+    	resp.body().reset();
+    }
+    return resp;
+}
+
 }  // namespace http_handler
@@ -3,6 +3,9 @@
 #include "model.h"
 #include "event_logger.h"
 #include "api_handler.h"
+#include "map_response_cache.h"
+#include "static_file_cache.h"
+#include "mime_types.h"
 namespace net = boost::asio;
 
 const std::string_view apiPrefix = "/api/";
@@ -15,14 +18,16 @@ using StaticFileResponce = http::response<http::file_body>;
 
 
 StaticFileResponce MakeFileResponce(const std::filesystem::path& json_path, const std::string& mime_type);
-std::string_view GetFileExtension(std::string_view path);
-std::string GetMimeType(std::string_view extension);
 std::filesystem::path GetResourcePath(std::string_view target);
+SharedStringResponse MakeStaticFileResponse(const StaticFile& file, http::status status, bool with_body,
+                                            unsigned http_version, bool keep_alive);
+SharedStringResponse MakeCachedResponse(const CachedBody& body, http::verb method, std::string_view accept_encoding,
+                                        std::string_view if_none_match, unsigned http_version, bool keep_alive);
 
 class RequestHandler: public std::enable_shared_from_this<RequestHandler> {
 public:
     explicit RequestHandler(model::Game& game, net::io_context& ioc)
-        : game_{game}, strand_(net::make_strand(ioc)) {
+        : game_{game}, strand_(net::make_strand(ioc)), map_responses_(game), static_files_(game.GetBasePath()) {
         api_handler_ = std::make_shared<ApiHandler>(game, strand_);
     }
 
@@ -31,16 +36,13 @@ public:
 
     template <typename Body, typename Allocator, typename Send>
     void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-    		std::string request = {req.target().begin(), req.target().end()};
-
-    		if(api_handler_->IsApiRequest(request)){
-    			return net::dispatch(strand_, [self = shared_from_this(), request, send, req]
-    						{
-    			    	       // Этот assert не выстрелит, так как лямбда-функция будет выполняться внутри strand
-    			    		   assert(self->strand_.running_in_this_thread());
-    			    	       auto resp = self->api_handler_->HandleApiRequest(request, req.method(), req[http::field::authorization], req.body(), req.version(),req.keep_alive());
-    			    	       send(std::move(resp));
-    			    	    });
+    		if(auto route = FindApiRoute(req.target())){
+    			// Ответ отправляется из strand игровой сессии или общего strand модели
+    			// Тело запроса переносится в обработчик без копирования
+    			return api_handler_->HandleApiRequest(*route, req.target(), req.method(), req[http::field::authorization],
+    												  req[http::field::accept], std::move(req.body()), req.version(), req.keep_alive(),
+    												  ResponseSender{[send](StringResponse&& resp){ send(std::move(resp)); },
+    												  				 [send](SharedStringResponse&& resp){ send(std::move(resp)); }});
     	    }
 
    			if((req.method() != http::verb::get) && (req.method() != http::verb::head)){
@@ -67,22 +69,22 @@ public:
    			if(target.starts_with(mapPrefix)){
                target.remove_prefix(mapPrefix.size());
 
+               // Ответы по картам подготовлены заранее и отдаются без сериализации
+               const CachedBody* cached = nullptr;
                if(target.empty()){
-            	   resp = MakeStringResponse(http::status::ok, json_serializer::GetMapListResponce(game_), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
+            	   cached = &map_responses_.GetMapList();
                }else{
-
             	   target.remove_prefix(1);
-            	   const auto& responce = json_serializer::GetMapContentResponce(game_, {target.begin(), target.end()});
-            	   if(!responce.empty()){
-            		   if(req.method() == http::verb::get)
-            			   resp = MakeStringResponse(http::status::ok, responce, req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-            		   else
-            			   resp = MakeStringResponse(http::status::ok, "", req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-
-            	   }else{
-            		   resp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
-            	   }
+            	   cached = map_responses_.FindMap(target);
+               }
+
+               if(cached){
+            	   send(MakeCachedResponse(*cached, req.method(), req[http::field::accept_encoding], req[http::field::if_none_match],
+            			   	   	   	   	   req.version(), req.keep_alive()));
+            	   return;
                }
+
+               resp = MakeStringResponse(http::status::not_found, json_serializer::MakeMapNotFoundResponce(), req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, {{http::field::cache_control, "no-cache"sv}});
                send(std::move(resp));
                return;
          }
@@ -92,15 +94,25 @@ public:
    				if((target.size() == 1) && target.starts_with('/'))
    					target = "/index.html";
 
-   				auto extension = GetFileExtension(target);
-   				std::string mimeType = GetMimeType(extension);
-   				std::filesystem::path basePath = game_.GetBasePath();
-   				basePath += target;
-
    				auto first_tick = std::chrono::steady_clock::now();
 
-   				auto fileResp = MakeFileResponce(basePath, mimeType);
-   				send(std::move(fileResp));
+   				// Небольшие файлы отдаются из памяти, без открытия файла на каждый запрос
+   				auto file = static_files_.Get({target.begin(), target.end()});
+   				const std::string& mimeType = file->mime_type;
+
+   				if(IsNotModified(*file, req[http::field::if_none_match], req[http::field::if_modified_since])){
+   					send(MakeStaticFileResponse(*file, http::status::not_modified, false, req.version(), req.keep_alive()));
+   				}else if(file->content || (req.method() == http::verb::head)){
+   					// большой файл на HEAD не открывается: заголовки берутся из кэша
+   					send(MakeStaticFileResponse(*file, http::status::ok, req.method() == http::verb::get, req.version(), req.keep_alive()));
+   				}else{
+   					auto fileResp = MakeFileResponce(file->path, mimeType);
+   					fileResp.version(req.version());
+   					fileResp.keep_alive(req.keep_alive());
+   					fileResp.set(http::field::etag, file->etag);
+   					fileResp.set(http::field::last_modified, file->last_modified);
+   					send(std::move(fileResp));
+   				}
 
    				auto last_tick = std::chrono::steady_clock::now();
    				auto time_delta = std::chrono::duration_cast<std::chrono::microseconds>(last_tick - first_tick);
@@ -115,10 +127,31 @@ public:
    		}
     }
 
+    // Подписка на состояние сессии по WebSocket. Остальные запросы на обновление соединения
+    // и подписки без действующего токена обрабатываются как обычные запросы
+    template <typename Body, typename Allocator>
+    bool Upgrade(const http::request<Body, http::basic_fields<Allocator>>& req, http_server::SessionStream& stream) {
+    	if((FindApiRoute(req.target()) != ApiRoute::STREAM) || (req.method() != http::verb::get)){
+    		return false;
+    	}
+
+    	auto handle = api_handler_->FindStreamPlayer(req.target(), req[http::field::authorization]);
+    	if(!handle){
+    		return false;
+    	}
+
+    	auto subscriber = std::make_shared<GameStreamSession>(std::move(stream), *handle);
+    	subscriber->Run(req);
+    	api_handler_->GetStreams().Subscribe(std::move(subscriber));
+    	return true;
+    }
+
 private:
     Strand strand_;
     model::Game& game_;
     std::shared_ptr<ApiHandler> api_handler_;
+    MapResponseCache map_responses_;
+    StaticFileCache static_files_;
 };
 
 class SyncWriteOStreamAdapter {
@@ -0,0 +1,94 @@
+#include "retired_writer.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace postgres {
+
+RetiredWriter::RetiredWriter(BatchSaver saver, ErrorHandler on_error, Limits limits)
+	: saver_(std::move(saver)), on_error_(std::move(on_error)), limits_(limits),
+	  thread_([this](std::stop_token stop){ Run(stop); }){
+}
+
+RetiredWriter::~RetiredWriter(){
+	// поток дописывает очередь и останавливается раньше, чем разрушаются остальные поля
+	thread_.request_stop();
+	thread_.join();
+}
+
+void RetiredWriter::Enqueue(Records records){
+	if(records.empty()){
+		return;
+	}
+	{
+		std::unique_lock lock(mutex_);
+		if(queue_.size() >= limits_.capacity){
+			blocked_enqueues_.fetch_add(1, std::memory_order_relaxed);
+			space_.wait(lock, [this]{ return queue_.size() < limits_.capacity; });
+		}
+		queue_.insert(queue_.end(), std::make_move_iterator(records.begin()), std::make_move_iterator(records.end()));
+	}
+	wake_.notify_one();
+}
+
+void RetiredWriter::Flush(){
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [this]{ return queue_.empty() && !writing_; });
+}
+
+size_t RetiredWriter::GetQueueSize() const {
+	std::lock_guard lock(mutex_);
+	return queue_.size();
+}
+
+void RetiredWriter::Run(std::stop_token stop){
+	std::unique_lock lock(mutex_);
+	while(true){
+		// при остановке очередь ещё записывается
+		wake_.wait(lock, stop, [this]{ return !queue_.empty(); });
+		if(queue_.empty()){
+			return;
+		}
+
+		const size_t size = std::min(queue_.size(), limits_.max_batch);
+		Records batch(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.begin() + size));
+		queue_.erase(queue_.begin(), queue_.begin() + size);
+		writing_ = true;
+		lock.unlock();
+		space_.notify_all();
+
+		auto delay = limits_.min_retry_delay;
+		while(!Save(batch)){
+			if(stop.stop_requested()){
+				dropped_records_.fetch_add(batch.size(), std::memory_order_relaxed);
+				break;
+			}
+			// пауза между попытками прерывается остановкой, после неё пачка пробуется последний раз
+			lock.lock();
+			wake_.wait_for(lock, stop, delay, []{ return false; });
+			lock.unlock();
+			delay = std::min(delay * 2, limits_.max_retry_delay);
+		}
+
+		lock.lock();
+		writing_ = false;
+		idle_.notify_all();
+	}
+}
+
+bool RetiredWriter::Save(const Records& batch){
+	try{
+		saver_(batch);
+		saved_records_.fetch_add(batch.size(), std::memory_order_relaxed);
+		saved_batches_.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}catch(const std::exception& ex){
+		failed_batches_.fetch_add(1, std::memory_order_relaxed);
+		if(on_error_){
+			on_error_(ex);
+		}
+		return false;
+	}
+}
+
+}  // namespace postgres
@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "model.h"
+
+namespace postgres {
+
+struct RetiredWriterLimits {
+	// записей в одной транзакции
+	size_t max_batch{1000};
+	// записей в очереди, после которых Enqueue ждёт
+	size_t capacity{100000};
+	// пауза перед повтором удваивается после каждой неудачи
+	std::chrono::milliseconds min_retry_delay{100};
+	std::chrono::milliseconds max_retry_delay{5000};
+};
+
+/*
+ *  Запись вышедших на пенсию игроков в базу в отдельном потоке. Тик только ставит записи в очередь.
+ *  Всё, что накопилось за время прошлой транзакции (не больше max_batch записей), уходит следующей одной транзакцией.
+ *  Пачка, которую не удалось записать, повторяется с растущей паузой, а новые записи тем временем ждут в очереди.
+ *  Когда в очереди capacity записей, Enqueue ждёт места: тик замедляется, но записи не теряются.
+ */
+class RetiredWriter {
+public:
+	using Records = std::vector<model::PlayerRecordItem>;
+	// Сохраняет пачку одной транзакцией. Исключение - транзакция не прошла, и пачка будет повторена
+	using BatchSaver = std::function<void(const Records&)>;
+	using ErrorHandler = std::function<void(const std::exception&)>;
+
+	using Limits = RetiredWriterLimits;
+
+	RetiredWriter(BatchSaver saver, ErrorHandler on_error = {}, Limits limits = {});
+	// Записывает оставшееся в очереди. Пачка, которая и тогда не записалась, теряется и учитывается в GetDroppedRecords
+	~RetiredWriter();
+
+	RetiredWriter(const RetiredWriter&) = delete;
+	RetiredWriter& operator=(const RetiredWriter&) = delete;
+
+	// Не ждёт базы, пока в очереди есть место. Может вызываться из любого потока
+	void Enqueue(Records records);
+	// Ждёт, пока все поставленные записи будут в базе
+	void Flush();
+
+	size_t GetQueueSize() const;
+	std::uint64_t GetSavedRecords() const { return saved_records_.load(std::memory_order_relaxed);}
+	std::uint64_t GetSavedBatches() const { return saved_batches_.load(std::memory_order_relaxed);}
+	std::uint64_t GetFailedBatches() const { return failed_batches_.load(std::memory_order_relaxed);}
+	std::uint64_t GetDroppedRecords() const { return dropped_records_.load(std::memory_order_relaxed);}
+	// Сколько раз Enqueue ждал места в очереди
+	std::uint64_t GetBlockedEnqueues() const { return blocked_enqueues_.load(std::memory_order_relaxed);}
+
+private:
+	void Run(std::stop_token stop);
+	bool Save(const Records& batch);
+
+	BatchSaver saver_;
+	ErrorHandler on_error_;
+	Limits limits_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable_any wake_;
+	std::condition_variable space_;
+	std::condition_variable idle_;
+	std::deque<model::PlayerRecordItem> queue_;
+	bool writing_{false};
+
+	std::atomic<std::uint64_t> saved_records_{0};
+	std::atomic<std::uint64_t> saved_batches_{0};
+	std::atomic<std::uint64_t> failed_batches_{0};
+	std::atomic<std::uint64_t> dropped_records_{0};
+	std::atomic<std::uint64_t> blocked_enqueues_{0};
+
+	std::jthread thread_;
+};
+
+}  // namespace postgres
@@ -0,0 +1,73 @@
+#include "road_topology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <tuple>
+
+namespace model {
+
+void RoadAxisIndex::Add(Coord fixed, Coord begin, Coord end, size_t road_index){
+    auto [min, max] = std::minmax({begin, end});
+    spans_.push_back({fixed, min, max, max, road_index});
+}
+
+void RoadAxisIndex::Build(){
+    std::sort(spans_.begin(), spans_.end(), [](const Span& lhs, const Span& rhs){
+        return std::tie(lhs.fixed, lhs.begin, lhs.road_index) < std::tie(rhs.fixed, rhs.begin, rhs.road_index);
+    });
+
+    for(size_t i = 1; i < spans_.size(); ++i){
+        if(spans_[i].fixed == spans_[i - 1].fixed){
+            spans_[i].max_end = std::max(spans_[i].end, spans_[i - 1].max_end);
+        }
+    }
+}
+
+std::optional<size_t> RoadAxisIndex::Find(double coord, double max_dist, double from, double to) const {
+    std::optional<size_t> res;
+
+    // Расстояние проверяется тем же условием |fixed - coord| <= max_dist, что и при переборе дорог
+    auto first = std::partition_point(spans_.begin(), spans_.end(), [coord, max_dist](const Span& span){
+        return (span.fixed < coord) && (std::abs(span.fixed - coord) > max_dist);
+    });
+
+    while((first != spans_.end()) && (std::abs(first->fixed - coord) <= max_dist)){
+        const Coord fixed = first->fixed;
+        auto last = std::partition_point(first, spans_.end(), [fixed](const Span& span){
+            return span.fixed == fixed;
+        });
+
+        // отрезки, начинающиеся не позже from, просматриваются с конца, пока их концы могут достать до to
+        auto it = std::partition_point(first, last, [from](const Span& span){
+            return span.begin <= from;
+        });
+        while((it != first) && (std::prev(it)->max_end >= to)){
+            --it;
+            if((it->end >= to) && (!res || (it->road_index < *res))){
+                res = it->road_index;
+            }
+        }
+
+        first = last;
+    }
+
+    return res;
+}
+
+RoadTopology::RoadTopology(std::vector<Road> roads)
+: roads_(std::move(roads)) {
+    for(size_t i = 0; i < roads_.size(); ++i){
+        const auto& road = roads_[i];
+        if(road.IsHorizontal()){
+            horizontal_index_.Add(road.GetStart().y, road.GetStart().x, road.GetEnd().x, i);
+        }
+        if(road.IsVertical()){
+            vertical_index_.Add(road.GetStart().x, road.GetStart().y, road.GetEnd().y, i);
+        }
+    }
+    horizontal_index_.Build();
+    vertical_index_.Build();
+}
+
+}  // namespace model
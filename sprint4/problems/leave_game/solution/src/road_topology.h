@@ -0,0 +1,55 @@
+#pragma once
+#include "model.h"
+
+#include <optional>
+#include <vector>
+
+namespace model {
+
+/*
+ *  Индекс дорог одной оси: отрезки упорядочены по неизменной координате дороги
+ *  (y для горизонтальных, x для вертикальных), а внутри неё - по началу отрезка.
+ */
+class RoadAxisIndex {
+public:
+    void Add(Coord fixed, Coord begin, Coord end, size_t road_index);
+    void Build();
+
+    // Дорога с наименьшим индексом, лежащая не дальше max_dist от coord и содержащая отрезок [from, to]
+    std::optional<size_t> Find(double coord, double max_dist, double from, double to) const;
+
+private:
+    struct Span{
+        Coord fixed{};
+        Coord begin{};
+        Coord end{};
+        // наибольший конец среди отрезков с той же fixed до этого включительно
+        Coord max_end{};
+        size_t road_index{};
+    };
+
+    std::vector<Span> spans_;
+};
+
+/*
+ *  Неизменяемая топология дорог карты: индексы дорог по осям для поиска ближайшей дороги.
+ *  Строится один раз при добавлении карты в игру и разделяется всеми собаками на ней.
+ */
+class RoadTopology {
+public:
+    explicit RoadTopology(std::vector<Road> roads);
+
+    const std::vector<Road>& GetRoads() const noexcept { return roads_; }
+    const Road& GetRoad(size_t road_index) const { return roads_[road_index]; }
+    size_t GetNumRoads() const noexcept { return roads_.size(); }
+
+    const RoadAxisIndex& GetHorizontalIndex() const noexcept { return horizontal_index_; }
+    const RoadAxisIndex& GetVerticalIndex() const noexcept { return vertical_index_; }
+
+private:
+    std::vector<Road> roads_;
+    RoadAxisIndex horizontal_index_;
+    RoadAxisIndex vertical_index_;
+};
+
+}  // namespace model
@@ -0,0 +1,209 @@
+#include "snapshot_writer.h"
+
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace serialization {
+
+namespace {
+
+[[noreturn]] void ThrowErrno(const std::string& what){
+	throw std::system_error(errno, std::generic_category(), what);
+}
+
+class FileDescriptor {
+public:
+	explicit FileDescriptor(int fd) : fd_(fd) {}
+	~FileDescriptor(){
+		if(fd_ >= 0){
+			::close(fd_);
+		}
+	}
+
+	FileDescriptor(const FileDescriptor&) = delete;
+	FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+	int Get() const { return fd_;}
+	// Ошибка close после записи означает, что данные могли не дойти до диска
+	void Close(const std::string& what){
+		const int fd = fd_;
+		fd_ = -1;
+		if(::close(fd) != 0){
+			ThrowErrno(what);
+		}
+	}
+
+private:
+	int fd_;
+};
+
+void WriteAll(int fd, std::string_view data, const std::string& what){
+	while(!data.empty()){
+		const ssize_t written = ::write(fd, data.data(), data.size());
+		if(written < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			ThrowErrno(what);
+		}
+		data.remove_prefix(static_cast<size_t>(written));
+	}
+}
+
+}  // namespace
+
+void SyncDirectory(const std::filesystem::path& dir){
+	FileDescriptor fd(::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+	if(fd.Get() < 0 || ::fsync(fd.Get()) != 0){
+		ThrowErrno("sync directory " + dir.string());
+	}
+}
+
+void WriteFileAtomically(const std::filesystem::path& path, std::string_view data){
+	std::filesystem::path tmp_path = path;
+	tmp_path += ".tmp";
+
+	try{
+		FileDescriptor fd(::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+		if(fd.Get() < 0){
+			ThrowErrno("open " + tmp_path.string());
+		}
+		WriteAll(fd.Get(), data, "write " + tmp_path.string());
+		if(::fsync(fd.Get()) != 0){
+			ThrowErrno("fsync " + tmp_path.string());
+		}
+		fd.Close("close " + tmp_path.string());
+
+		std::filesystem::rename(tmp_path, path);
+	}catch(...){
+		std::error_code ec;
+		std::filesystem::remove(tmp_path, ec);
+		throw;
+	}
+
+	SyncDirectory(path.parent_path());
+}
+
+std::string ReadFile(const std::filesystem::path& path){
+	FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	if(fd.Get() < 0){
+		ThrowErrno("open " + path.string());
+	}
+
+	std::string data(std::filesystem::file_size(path), '\0');
+	size_t read_total = 0;
+	while(read_total < data.size()){
+		const ssize_t read = ::read(fd.Get(), data.data() + read_total, data.size() - read_total);
+		if(read < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			ThrowErrno("read " + path.string());
+		}
+		if(read == 0){
+			break;
+		}
+		read_total += static_cast<size_t>(read);
+	}
+	data.resize(read_total);
+	return data;
+}
+
+MappedFile::MappedFile(const std::filesystem::path& path){
+	FileDescriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	struct stat st{};
+	if(fd.Get() < 0 || ::fstat(fd.Get(), &st) != 0){
+		ThrowErrno("open " + path.string());
+	}
+	// пустой файл отобразить нельзя
+	if(st.st_size == 0){
+		return;
+	}
+
+	void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd.Get(), 0);
+	if(data == MAP_FAILED){
+		ThrowErrno("mmap " + path.string());
+	}
+	// файл читается целиком, и сразу несколькими потоками
+	::madvise(data, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+	data_ = static_cast<const char*>(data);
+	size_ = static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile(){
+	if(data_){
+		::munmap(const_cast<char*>(data_), size_);
+	}
+}
+
+SnapshotWriter::SnapshotWriter(std::filesystem::path path, Encoder encoder, ErrorHandler on_error)
+	: path_(std::move(path)), encoder_(std::move(encoder)), on_error_(std::move(on_error)),
+	  thread_([this](std::stop_token stop){ Run(stop); }){
+}
+
+void SnapshotWriter::Submit(States states, Callback on_written){
+	{
+		std::lock_guard lock(mutex_);
+		if(pending_){
+			replaced_.fetch_add(1, std::memory_order_relaxed);
+			// большой снимок освобождается дольше, чем передаётся, поэтому это делает поток записи
+			replaced_states_.push_back(std::move(pending_));
+		}
+		pending_ = std::move(states);
+		pending_on_written_ = std::move(on_written);
+	}
+	wake_.notify_one();
+}
+
+void SnapshotWriter::Flush(){
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [this]{ return !pending_ && !writing_; });
+}
+
+void SnapshotWriter::Run(std::stop_token stop){
+	std::unique_lock lock(mutex_);
+	while(true){
+		// при остановке ожидающий снимок ещё записывается
+		wake_.wait(lock, stop, [this]{ return pending_ != nullptr; });
+		if(!pending_){
+			return;
+		}
+
+		auto states = std::move(pending_);
+		auto on_written = std::move(pending_on_written_);
+		pending_on_written_ = nullptr;
+		auto replaced = std::move(replaced_states_);
+		writing_ = true;
+		lock.unlock();
+
+		replaced.clear();
+		if(Write(*states) && on_written){
+			on_written();
+		}
+		states.reset();
+
+		lock.lock();
+		writing_ = false;
+		idle_.notify_all();
+	}
+}
+
+bool SnapshotWriter::Write(const model::GameSessionsStates& states){
+	try{
+		WriteFileAtomically(path_, encoder_(states));
+		written_.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}catch(const std::exception& ex){
+		failed_.fetch_add(1, std::memory_order_relaxed);
+		if(on_error_){
+			on_error_(ex);
+		}
+		return false;
+	}
+}
+
+}  // namespace serialization
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace model {
+	struct GameSessionsStates;
+}
+
+namespace serialization {
+
+// Заменяет файл целиком: данные пишутся во временный файл рядом, сбрасываются на диск (fsync)
+// и переименовываются поверх старого. После сбоя остаётся старый или новый файл, но не обрезанный.
+// Бросает std::system_error
+void WriteFileAtomically(const std::filesystem::path& path, std::string_view data);
+// Созданный или переименованный файл попадает на диск только вместе с каталогом. Бросает std::system_error
+void SyncDirectory(const std::filesystem::path& dir);
+// Читает файл целиком. Бросает std::system_error
+std::string ReadFile(const std::filesystem::path& path);
+
+// Файл, отображённый в память только для чтения: данные не копируются, а страницы
+// подгружаются по мере чтения. Файл можно заменять WriteFileAtomically, пока он отображён
+class MappedFile {
+public:
+	// Бросает std::system_error
+	explicit MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	std::string_view GetData() const { return {data_, size_};}
+
+private:
+	const char* data_{nullptr};
+	size_t size_{0};
+};
+
+/*
+ *  Сохранение состояния игры в отдельном потоке. Тик только передаёт снятое состояние,
+ *  сериализация и запись на диск выполняются здесь.
+ *  Ожидающий снимок хранится один: если диск не успевает, более новый заменяет его.
+ */
+class SnapshotWriter {
+public:
+	using States = std::shared_ptr<const model::GameSessionsStates>;
+	using Encoder = std::function<std::string(const model::GameSessionsStates&)>;
+	using ErrorHandler = std::function<void(const std::exception&)>;
+	using Callback = std::function<void()>;
+
+	SnapshotWriter(std::filesystem::path path, Encoder encoder, ErrorHandler on_error = {});
+
+	SnapshotWriter(const SnapshotWriter&) = delete;
+	SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+	// Не ждёт записи. Может вызываться из любого потока.
+	// on_written вызывается потоком записи, когда снимок на диске; для заменённого снимка не вызывается
+	void Submit(States states, Callback on_written = {});
+	// Ждёт, пока все переданные снимки будут записаны или заменены более новыми
+	void Flush();
+
+	const std::filesystem::path& GetPath() const { return path_;}
+	std::uint64_t GetWrittenSnapshots() const { return written_.load(std::memory_order_relaxed);}
+	std::uint64_t GetReplacedSnapshots() const { return replaced_.load(std::memory_order_relaxed);}
+	std::uint64_t GetFailedWrites() const { return failed_.load(std::memory_order_relaxed);}
+
+private:
+	void Run(std::stop_token stop);
+	bool Write(const model::GameSessionsStates& states);
+
+	std::filesystem::path path_;
+	Encoder encoder_;
+	ErrorHandler on_error_;
+
+	std::mutex mutex_;
+	std::condition_variable_any wake_;
+	std::condition_variable idle_;
+	States pending_;
+	Callback pending_on_written_;
+	std::vector<States> replaced_states_;
+	bool writing_{false};
+
+	std::atomic<std::uint64_t> written_{0};
+	std::atomic<std::uint64_t> replaced_{0};
+	std::atomic<std::uint64_t> failed_{0};
+
+	// последним: поток стартует, когда остальные поля готовы, и при разрушении
+	// дописывает ожидающий снимок и завершается раньше них
+	std::jthread thread_;
+};
+
+}  // namespace serialization
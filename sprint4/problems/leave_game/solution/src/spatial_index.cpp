@@ -0,0 +1,86 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace collision_detector {
+
+std::int64_t ItemsGrid::ToCell(double coord) const {
+    return static_cast<std::int64_t>(std::floor(coord / cell_size_));
+}
+
+ItemsGrid::CellKey ItemsGrid::MakeKey(std::int64_t cell_x, std::int64_t cell_y) noexcept {
+    return (static_cast<CellKey>(static_cast<std::uint32_t>(cell_x)) << 32) | static_cast<std::uint32_t>(cell_y);
+}
+
+void ItemsGrid::Add(const Item& item){
+    CellKey key = MakeKey(ToCell(item.position.x), ToCell(item.position.y));
+    cells_[key].push_back(item);
+    ++items_count_;
+
+    if(item.item_type == ItemType::Loot){
+        loot_cells_[item.id] = key;
+    }
+}
+
+bool ItemsGrid::RemoveLoot(unsigned loot_id){
+    auto itCell = loot_cells_.find(loot_id);
+    if(itCell == loot_cells_.end()){
+        return false;
+    }
+
+    auto& items = cells_[itCell->second];
+    auto itItem = std::find_if(items.begin(), items.end(), [loot_id](const Item& item){
+        return item.item_type == ItemType::Loot && item.id == loot_id;
+    });
+
+    if(itItem != items.end()){
+        *itItem = items.back();
+        items.pop_back();
+        --items_count_;
+    }
+
+    if(items.empty()){
+        cells_.erase(itCell->second);
+    }
+
+    loot_cells_.erase(itCell);
+    return true;
+}
+
+void ItemsGrid::ClearLoots(){
+    for(auto it = cells_.begin(); it != cells_.end();){
+        auto& items = it->second;
+        const auto new_end = std::remove_if(items.begin(), items.end(), [](const Item& item){
+            return item.item_type == ItemType::Loot;
+        });
+
+        items_count_ -= std::distance(new_end, items.end());
+        items.erase(new_end, items.end());
+        it = items.empty() ? cells_.erase(it) : std::next(it);
+    }
+
+    loot_cells_.clear();
+}
+
+void ItemsGrid::FindNear(const Gatherer& gatherer, double margin, std::vector<Item>& out) const {
+    auto [min_x, max_x] = std::minmax(gatherer.start_pos.x, gatherer.end_pos.x);
+    auto [min_y, max_y] = std::minmax(gatherer.start_pos.y, gatherer.end_pos.y);
+
+    const std::int64_t first_x = ToCell(min_x - margin);
+    const std::int64_t last_x = ToCell(max_x + margin);
+    const std::int64_t first_y = ToCell(min_y - margin);
+    const std::int64_t last_y = ToCell(max_y + margin);
+
+    for(std::int64_t cell_x = first_x; cell_x <= last_x; ++cell_x){
+        for(std::int64_t cell_y = first_y; cell_y <= last_y; ++cell_y){
+            auto itCell = cells_.find(MakeKey(cell_x, cell_y));
+            if(itCell == cells_.end()){
+                continue;
+            }
+
+            out.insert(out.end(), itCell->second.begin(), itCell->second.end());
+        }
+    }
+}
+
+}  // namespace collision_detector
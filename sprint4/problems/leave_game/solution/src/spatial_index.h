@@ -0,0 +1,42 @@
+#pragma once
+#include "collision_detector.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace collision_detector {
+
+/*
+ *  Равномерная сетка предметов (трофеи и базы) игровой сессии.
+ *  Позволяет выбрать только те предметы, которые лежат рядом с отрезком,
+ *  пройденным собакой за тик, не перебирая все предметы карты.
+ */
+class ItemsGrid {
+public:
+    explicit ItemsGrid(double cell_size = 4.0)
+    : cell_size_{cell_size} {
+    }
+
+    void Add(const Item& item);
+    bool RemoveLoot(unsigned loot_id);
+    void ClearLoots();
+
+    // Добавляет в out предметы, находящиеся не дальше margin от ограничивающего прямоугольника отрезка
+    void FindNear(const Gatherer& gatherer, double margin, std::vector<Item>& out) const;
+
+    size_t Size() const noexcept { return items_count_; }
+
+private:
+    using CellKey = std::uint64_t;
+
+    std::int64_t ToCell(double coord) const;
+    static CellKey MakeKey(std::int64_t cell_x, std::int64_t cell_y) noexcept;
+
+    double cell_size_;
+    size_t items_count_{0};
+    std::unordered_map<CellKey, std::vector<Item>> cells_;
+    std::unordered_map<unsigned, CellKey> loot_cells_;
+};
+
+}  // namespace collision_detector
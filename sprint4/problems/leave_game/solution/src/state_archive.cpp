@@ -0,0 +1,205 @@
+#include "state_archive.h"
+#include "binary_writer.h"
+#include "game_session.h"
+#include "utils.h"
+
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace serialization {
+
+using binary_serializer::BinaryReader;
+using binary_serializer::BinaryWriter;
+using namespace std::literals;
+
+namespace {
+
+// длина и контрольная сумма секции
+constexpr size_t SECTION_HEADER_SIZE = 2 * sizeof(std::uint32_t);
+// минимальные размеры записей, чтобы число из испорченного файла не заставило выделить лишнюю память
+constexpr size_t MIN_LOOT_SIZE = 2 + 2 * sizeof(double);
+constexpr size_t MIN_PLAYER_SIZE = 5 + 4 * sizeof(double) + 2 + 2 * sizeof(std::int32_t);
+
+void PutU32At(std::string& out, size_t pos, std::uint32_t value){
+	for(size_t i = 0; i < sizeof(value); ++i){
+		out[pos + i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+	}
+}
+
+void WriteSession(BinaryWriter& writer, const model::GameSessionState& session){
+	writer.Bytes(session.map_id_).Varint(session.player_id_);
+	writer.Varint(session.player_state_.size());
+	for(const auto& player : session.player_state_){
+		WritePlayerState(writer, player);
+	}
+	WriteLootsInfo(writer, session.loots_info_state);
+}
+
+model::GameSessionState ReadSession(std::string_view payload){
+	BinaryReader reader(payload);
+	model::GameSessionState session;
+	session.map_id_ = reader.Bytes();
+	session.player_id_ = static_cast<unsigned>(reader.Varint());
+
+	const auto players = reader.Varint();
+	session.player_state_.reserve(std::min<std::uint64_t>(players, reader.GetRemaining() / MIN_PLAYER_SIZE));
+	for(std::uint64_t i = 0; i < players; ++i){
+		session.player_state_.push_back(ReadPlayerState(reader));
+	}
+	session.loots_info_state = ReadLootsInfo(reader);
+
+	if(reader.GetRemaining() != 0){
+		throw std::runtime_error("Unexpected data at the end of a session in state file");
+	}
+	return session;
+}
+
+}  // namespace
+
+std::uint32_t Crc32(std::string_view data){
+	boost::crc_32_type crc;
+	crc.process_bytes(data.data(), data.size());
+	return crc.checksum();
+}
+
+void WriteLootInfo(BinaryWriter& writer, const model::LootInfo& loot){
+	writer.Varint(loot.id).Varint(loot.type).F64(loot.x).F64(loot.y);
+}
+
+model::LootInfo ReadLootInfo(BinaryReader& reader){
+	model::LootInfo loot;
+	loot.id = static_cast<unsigned>(reader.Varint());
+	loot.type = static_cast<unsigned>(reader.Varint());
+	loot.x = reader.F64();
+	loot.y = reader.F64();
+	return loot;
+}
+
+void WriteLootsInfo(BinaryWriter& writer, const std::vector<model::LootInfo>& loots){
+	writer.Varint(loots.size());
+	for(const auto& loot : loots){
+		WriteLootInfo(writer, loot);
+	}
+}
+
+std::vector<model::LootInfo> ReadLootsInfo(BinaryReader& reader){
+	const auto count = reader.Varint();
+	std::vector<model::LootInfo> loots;
+	loots.reserve(std::min<std::uint64_t>(count, reader.GetRemaining() / MIN_LOOT_SIZE));
+	for(std::uint64_t i = 0; i < count; ++i){
+		loots.push_back(ReadLootInfo(reader));
+	}
+	return loots;
+}
+
+void WritePlayerState(BinaryWriter& writer, const model::PlayerState& player){
+	const auto& pos = player.dog_position_;
+	writer.Bytes(player.name_).Bytes(player.token_).Varint(player.id_)
+		  .U8(static_cast<std::uint8_t>(player.dog_direction_))
+		  .Varint(pos.current_road_index)
+		  .F64(pos.curr_position.x).F64(pos.curr_position.y)
+		  .F64(pos.curr_speed.vx).F64(pos.curr_speed.vy);
+	WriteLootsInfo(writer, player.gathered_loots_);
+	writer.Varint(player.bag_capacity_).I32(player.score_).I32(player.play_time_);
+}
+
+model::PlayerState ReadPlayerState(BinaryReader& reader){
+	model::PlayerState player;
+	player.name_ = reader.Bytes();
+	player.token_ = reader.Bytes();
+	player.id_ = static_cast<unsigned>(reader.Varint());
+
+	const auto direction = reader.U8();
+	if(direction > static_cast<std::uint8_t>(model::DogDirection::STOP)){
+		throw std::runtime_error("Invalid dog direction in state file");
+	}
+	player.dog_direction_ = static_cast<model::DogDirection>(direction);
+
+	auto& pos = player.dog_position_;
+	pos.current_road_index = static_cast<size_t>(reader.Varint());
+	pos.curr_position.x = reader.F64();
+	pos.curr_position.y = reader.F64();
+	pos.curr_speed.vx = reader.F64();
+	pos.curr_speed.vy = reader.F64();
+
+	player.gathered_loots_ = ReadLootsInfo(reader);
+	player.bag_capacity_ = static_cast<unsigned>(reader.Varint());
+	player.score_ = reader.I32();
+	player.play_time_ = reader.I32();
+	return player;
+}
+
+SaveFormat GetSaveFormat(const std::filesystem::path& path){
+	return path.extension() == ".txt" ? SaveFormat::TEXT : SaveFormat::BINARY;
+}
+
+bool IsBinaryArchive(std::string_view data){
+	return data.starts_with(BINARY_ARCHIVE_MAGIC);
+}
+
+std::string EncodeBinaryArchive(const model::GameSessionsStates& states){
+	std::string out;
+	BinaryWriter writer(out);
+	writer.U32(0);
+	out.replace(0, BINARY_ARCHIVE_MAGIC.size(), BINARY_ARCHIVE_MAGIC);
+	writer.U32(BINARY_ARCHIVE_VERSION).U32(static_cast<std::uint32_t>(states.states.size()));
+
+	for(const auto& session : states.states){
+		// длина и сумма известны только после записи сессии
+		const size_t section_start = out.size();
+		writer.U32(0).U32(0);
+		WriteSession(writer, session);
+
+		const std::string_view payload = std::string_view(out).substr(section_start + SECTION_HEADER_SIZE);
+		if(payload.size() > UINT32_MAX){
+			throw std::length_error("Game session is too large for state file");
+		}
+		PutU32At(out, section_start, static_cast<std::uint32_t>(payload.size()));
+		PutU32At(out, section_start + sizeof(std::uint32_t), Crc32(payload));
+	}
+	return out;
+}
+
+model::GameSessionsStates DecodeBinaryArchive(std::string_view data){
+	if(!IsBinaryArchive(data)){
+		throw std::runtime_error("Not a binary state file");
+	}
+
+	try{
+		BinaryReader reader(data);
+		reader.Raw(BINARY_ARCHIVE_MAGIC.size());
+		if(const auto version = reader.U32(); version != BINARY_ARCHIVE_VERSION){
+			throw std::runtime_error("Unsupported state file version "s + std::to_string(version));
+		}
+
+		const auto sessions = reader.U32();
+		std::vector<std::pair<std::uint32_t, std::string_view>> sections;
+		sections.reserve(std::min<size_t>(sessions, reader.GetRemaining() / SECTION_HEADER_SIZE));
+		for(std::uint32_t i = 0; i < sessions; ++i){
+			const auto size = reader.U32();
+			const auto checksum = reader.U32();
+			sections.emplace_back(checksum, reader.Raw(size));
+		}
+
+		if(reader.GetRemaining() != 0){
+			throw std::runtime_error("Unexpected data at the end of state file");
+		}
+
+		// секции независимы, поэтому сессии проверяются и разбираются параллельно
+		model::GameSessionsStates states;
+		states.states.resize(sections.size());
+		utils::ParallelFor(sections.size(), [&sections, &states](size_t i){
+			const auto& [checksum, payload] = sections[i];
+			if(Crc32(payload) != checksum){
+				throw std::runtime_error("Checksum mismatch in session "s + std::to_string(i) + " of state file");
+			}
+			states.states[i] = ReadSession(payload);
+		});
+		return states;
+	}catch(const std::out_of_range&){
+		throw std::runtime_error("State file is truncated");
+	}
+}
+
+}  // namespace serialization
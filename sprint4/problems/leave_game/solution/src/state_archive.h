@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace model {
+	struct GameSessionsStates;
+	struct PlayerState;
+	struct LootInfo;
+}
+
+namespace binary_serializer {
+	class BinaryWriter;
+	class BinaryReader;
+}
+
+/*
+ *  Двоичный файл сохранения состояния игры.
+ *
+ *  Заголовок: "GSAV", u32 версия, u32 число секций.
+ *  Секция - одна игровая сессия: u32 длина данных, u32 CRC-32 данных, данные.
+ *  Целые фиксированной ширины и double - little-endian, счётчики и id - varint, строки - varint длина и байты.
+ *
+ *  сессия:  строка id карты, varint следующий id игрока, varint число игроков, игроки,
+ *           varint число трофеев на карте, трофеи
+ *  игрок:   строка имя, строка токен, varint id, u8 направление, varint индекс дороги,
+ *           f64 x, f64 y, f64 vx, f64 vy, varint число предметов в рюкзаке, предметы,
+ *           varint вместимость рюкзака, i32 очки, i32 время в игре
+ *  трофей:  varint id, varint тип, f64 x, f64 y
+ */
+namespace serialization {
+
+enum class SaveFormat {
+	TEXT,    // boost::archive::text_oarchive, формат прежних сохранений
+	BINARY
+};
+
+constexpr std::string_view BINARY_ARCHIVE_MAGIC = "GSAV";
+constexpr std::uint32_t BINARY_ARCHIVE_VERSION = 1;
+
+// Формат, в котором сохраняется файл: текстовый для *.txt, двоичный для остальных
+SaveFormat GetSaveFormat(const std::filesystem::path& path);
+// Формат прочитанного файла определяется по его началу
+bool IsBinaryArchive(std::string_view data);
+
+std::string EncodeBinaryArchive(const model::GameSessionsStates& states);
+// Бросает std::runtime_error, если файл обрезан, испорчен или записан более новой версией
+model::GameSessionsStates DecodeBinaryArchive(std::string_view data);
+
+// CRC-32 секций файла сохранения и пакетов журнала
+std::uint32_t Crc32(std::string_view data);
+
+// Записи игрока и трофеев в формате файла сохранения, общие с журналом.
+// Чтение бросает std::out_of_range на обрезанных данных и std::runtime_error на неверных
+void WritePlayerState(binary_serializer::BinaryWriter& writer, const model::PlayerState& player);
+model::PlayerState ReadPlayerState(binary_serializer::BinaryReader& reader);
+void WriteLootInfo(binary_serializer::BinaryWriter& writer, const model::LootInfo& loot);
+model::LootInfo ReadLootInfo(binary_serializer::BinaryReader& reader);
+void WriteLootsInfo(binary_serializer::BinaryWriter& writer, const std::vector<model::LootInfo>& loots);
+std::vector<model::LootInfo> ReadLootsInfo(binary_serializer::BinaryReader& reader);
+
+}  // namespace serialization
@@ -0,0 +1,103 @@
+#include "static_file_cache.h"
+#include "mime_types.h"
+#include "map_response_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <system_error>
+
+namespace http_handler {
+
+std::shared_ptr<const StaticFile> StaticFileCache::Get(const std::string& target){
+    {
+        std::lock_guard lock(mutex_);
+        auto it = index_.find(target);
+        if(it != index_.end()){
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+    }
+
+    // файл читается без блокировки, чтобы не задерживать запросы к уже закэшированным файлам
+    auto file = Load(target);
+
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = index_.try_emplace(target);
+    if(!inserted){
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+
+    lru_.emplace_front(target, file);
+    it->second = lru_.begin();
+    cached_bytes_ += file->content ? file->size : 0;
+    Evict();
+
+    return file;
+}
+
+std::uint64_t StaticFileCache::GetCachedBytes() const {
+    std::lock_guard lock(mutex_);
+    return cached_bytes_;
+}
+
+std::shared_ptr<const StaticFile> StaticFileCache::Load(const std::string& target) const {
+    auto file = std::make_shared<StaticFile>();
+    file->path = base_path_;
+    file->path += target;
+
+    file->size = std::filesystem::file_size(file->path);
+    const auto mtime = std::filesystem::last_write_time(file->path);
+    file->last_modified = FormatHttpDate(mtime);
+    file->mime_type = GetMimeType(GetFileExtension(target));
+
+    char etag[48];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"", static_cast<unsigned long long>(file->size),
+                  static_cast<unsigned long long>(mtime.time_since_epoch().count()));
+    file->etag = etag;
+
+    if(file->size <= MAX_CACHED_FILE_SIZE){
+        std::string content(file->size, '\0');
+        std::ifstream in(file->path, std::ios::binary);
+        if(!in.read(content.data(), content.size())){
+            throw std::filesystem::filesystem_error("Failed to read file", file->path,
+                                                    std::make_error_code(std::errc::io_error));
+        }
+        file->content = std::make_shared<const std::string>(std::move(content));
+    }
+
+    return file;
+}
+
+void StaticFileCache::Evict(){
+    while((cached_bytes_ > capacity_) && !lru_.empty()){
+        const auto& [target, file] = lru_.back();
+        cached_bytes_ -= file->content ? file->size : 0;
+        index_.erase(target);
+        lru_.pop_back();
+    }
+}
+
+std::string FormatHttpDate(std::filesystem::file_time_type time){
+    const auto sys_time = std::chrono::file_clock::to_sys(time);
+    const std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::time_point_cast<std::chrono::system_clock::duration>(sys_time));
+
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+
+    char buffer[64];
+    const auto size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return {buffer, size};
+}
+
+bool IsNotModified(const StaticFile& file, std::string_view if_none_match, std::string_view if_modified_since){
+    if(!if_none_match.empty()){
+        return MatchesETag(if_none_match, file.etag);
+    }
+    // дата сравнивается как строка: клиент возвращает значение Last-Modified без изменений
+    return !if_modified_since.empty() && (if_modified_since == file.last_modified);
+}
+
+}  // namespace http_handler
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace http_handler {
+
+// Статический файл с заранее подготовленными заголовками ответа
+struct StaticFile {
+    std::filesystem::path path;
+    std::string mime_type;
+    std::string etag;
+    std::string last_modified;
+    std::uint64_t size{0};
+    // содержимое хранится только для небольших файлов, большие читаются с диска при отправке
+    std::shared_ptr<const std::string> content;
+};
+
+/*
+ *  LRU-кэш статических файлов каталога www_root.
+ *  Содержимое файлов не проверяется повторно: статика не меняется во время работы сервера.
+ */
+class StaticFileCache {
+public:
+    static constexpr std::uint64_t MAX_CACHED_FILE_SIZE = 1024 * 1024;
+    static constexpr std::uint64_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+    explicit StaticFileCache(std::filesystem::path base_path, std::uint64_t capacity = DEFAULT_CAPACITY)
+        : base_path_(std::move(base_path)), capacity_(capacity) {}
+
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    // Бросает std::filesystem::filesystem_error, если файла нет
+    std::shared_ptr<const StaticFile> Get(const std::string& target);
+
+    std::uint64_t GetCachedBytes() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const StaticFile>>;
+
+    std::shared_ptr<const StaticFile> Load(const std::string& target) const;
+    void Evict();
+
+    std::filesystem::path base_path_;
+    std::uint64_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::uint64_t cached_bytes_{0};
+};
+
+std::string FormatHttpDate(std::filesystem::file_time_type time);
+
+// Ответ 304 для условного запроса: If-None-Match проверяется раньше If-Modified-Since
+bool IsNotModified(const StaticFile& file, std::string_view if_none_match, std::string_view if_modified_since);
+
+}  // namespace http_handler
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 namespace net = boost::asio;
 namespace sys = boost::system;
 
@@ -7,7 +8,8 @@ namespace http_handler {
 class Ticker : public std::enable_shared_from_this<Ticker> {
 public:
     using Strand = net::strand<net::io_context::executor_type>;
-    using Handler = std::function<void(std::chrono::milliseconds delta)>;
+    // Обработчик вызывает done после завершения тика, только тогда планируется следующий
+    using Handler = std::function<void(std::chrono::milliseconds delta, std::function<void()> done)>;
 
     Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
     :strand_(strand), period_(period), handler_(handler)  {
@@ -16,11 +18,13 @@ public:
     bool HasStarted() {return has_started_;}
 
     void Start() {
-        last_tick_ = std::chrono::steady_clock::now();
+        if(has_started_.exchange(true)){
+            return;
+        }
         net::dispatch(strand_, [self = shared_from_this()] {
+             self->last_tick_ = std::chrono::steady_clock::now();
              self->ScheduleTick();
          });
-        has_started_ = true;
     }
 
 private:
@@ -35,9 +39,12 @@ private:
     void OnTick(sys::error_code ec) {
         auto current_tick = std::chrono::steady_clock::now();
         auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(current_tick - last_tick_);
-        handler_(delta);
         last_tick_ = current_tick;
-        ScheduleTick();
+        handler_(delta, [self = shared_from_this()] {
+            net::dispatch(self->strand_, [self] {
+                self->ScheduleTick();
+            });
+        });
     }
 
 
@@ -46,6 +53,6 @@ private:
     std::chrono::milliseconds period_;
     Handler handler_;
     std::chrono::time_point<std::chrono::steady_clock> last_tick_;
-    bool has_started_{false};
+    std::atomic<bool> has_started_{false};
 };
 }
@@ -4,6 +4,7 @@
 #include "tagged_uuid.h"
 #include "postgres.h"
 #include "connection_engine.h"
+#include "connection_tracker.h"
 
 struct Args {
     int tick_period{0};
@@ -12,6 +13,8 @@ struct Args {
     std::string www_root;
     std::string save_file;
     bool spawn_random_points{false};
+    bool io_context_per_core{false};
+    http_server::ServerLimits server_limits;
 };
 
 struct AppConfig {
@@ -29,14 +32,23 @@ namespace {
     Args args;
     std::string tick_period;
     std::string save_period;
+    size_t max_connections = args.server_limits.max_connections;
+    int keep_alive_timeout = static_cast<int>(args.server_limits.keep_alive_timeout.count());
+    int header_timeout = static_cast<int>(args.server_limits.header_timeout.count());
+    int body_timeout = static_cast<int>(args.server_limits.body_timeout.count());
     desc.add_options()
         ("help,h", "produce help message")
         ("tick-period,t", po::value(&tick_period)->value_name("milliseconds"s), " set tick period")  //
         ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path") //
         ("www-root,w", po::value(&args.www_root)->value_name("dir"s), "set static files root") //        
 		("randomize-spawn-points", "spawn dogs at random positions") //
-		("state-file,f", po::value(&args.save_file)->value_name("file"s), "set file to save server state") //
-		("save-state-period,p",  po::value(&save_period)->value_name("milliseconds"s), "time period to save server state in milliseconds");
+		("state-file,f", po::value(&args.save_file)->value_name("file"s), "set file to save server state (text archive for *.txt, binary otherwise; both are read)") //
+		("save-state-period,p",  po::value(&save_period)->value_name("milliseconds"s), "time period to save server state in milliseconds") //
+		("io-context-per-core", "accept and serve connections on a separate io_context per core (SO_REUSEPORT)") //
+		("max-connections", po::value(&max_connections)->value_name("count"s), "maximum number of open connections") //
+		("keep-alive-timeout", po::value(&keep_alive_timeout)->value_name("milliseconds"s), "close idle keep-alive connections after timeout") //
+		("header-timeout", po::value(&header_timeout)->value_name("milliseconds"s), "time limit for receiving request headers") //
+		("body-timeout", po::value(&body_timeout)->value_name("milliseconds"s), "time limit for receiving request body");
         
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -66,6 +78,11 @@ namespace {
     }
     
     args.spawn_random_points = vm.contains("randomize-spawn-points"s) ? true : false;
+    args.io_context_per_core = vm.contains("io-context-per-core"s);
+    args.server_limits.max_connections = max_connections;
+    args.server_limits.keep_alive_timeout = std::chrono::milliseconds(keep_alive_timeout);
+    args.server_limits.header_timeout = std::chrono::milliseconds(header_timeout);
+    args.server_limits.body_timeout = std::chrono::milliseconds(body_timeout);
 
     return args;
 } 
@@ -80,17 +97,20 @@ AppConfig GetConfigFromEnv() {
     return config;
 }
 
-void SaveRetiredPlayer(const std::string& player_name, int score, int play_time){
+// id выдаётся сразу, поэтому повторная запись того же игрока в базу ничего не добавит
+model::PlayerRecordItem MakeRetiredRecord(const std::string& player_name, int score, int play_time){
 	struct PlayerTag {};
 	using PlayerId = util::TaggedUUID<PlayerTag>;
 
-	model::PlayerRecordItem record{PlayerId::New().ToString(), player_name, score, play_time};
+	return {PlayerId::New().ToString(), player_name, score, play_time};
+}
 
+void SaveRetiredPlayers(const std::vector<model::PlayerRecordItem>& records){
 	ConnectionPoolSingleton* inst = ConnectionPoolSingleton::getInstance();
 	auto* conn_pool = inst->GetPool();
 	auto conn = conn_pool->GetConnection();
 	postgres::RetiredRepositoryImpl rep{*conn};
-	rep.SaveRetired(record);
+	rep.SaveRetired(records);
 }
 
 std::vector<model::PlayerRecordItem> GetRetiredPlayers(int start, int max_items){
@@ -106,13 +126,4 @@ double ConvertPlayTimeToDouble(int play_time){
 	return static_cast<double>(play_time) / millisec_In_Second;
 }
 
-std::string GetRequestStringWithoutParameters(const std::string& request){
-	std::string np_request = request;
-	auto pos = request.rfind('?');
-	if(pos != std::string::npos)
-		np_request = request.substr(0, pos);
-
-	return np_request;
-}
-
 }
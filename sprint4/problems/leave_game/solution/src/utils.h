@@ -1,5 +1,11 @@
 #pragma once
 #include <random>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace utils
 {
@@ -11,5 +17,45 @@ template<typename T>
 		std::uniform_int_distribution<T> distribution(minValue, maxValue);
 		return distribution(engine);
 	}
-}
 
+// Вызывает fn(i) для каждого i из [0, count) в потоках по числу ядер.
+// Первое исключение из fn пробрасывается, когда все потоки завершены
+template<typename Fn>
+	void ParallelFor(size_t count, Fn&& fn){
+		const size_t threads = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+		if(threads <= 1){
+			for(size_t i = 0; i < count; ++i){
+				fn(i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> next{0};
+		std::exception_ptr error;
+		std::mutex error_mutex;
+		auto worker = [&]{
+			for(size_t i = next++; i < count; i = next++){
+				try{
+					fn(i);
+				}catch(...){
+					std::lock_guard lock(error_mutex);
+					if(!error){
+						error = std::current_exception();
+					}
+				}
+			}
+		};
+
+		{
+			std::vector<std::jthread> workers;
+			workers.reserve(threads - 1);
+			for(size_t i = 1; i < threads; ++i){
+				workers.emplace_back(worker);
+			}
+			worker();
+		}
+		if(error){
+			std::rethrow_exception(error);
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../src/action_queue.h"
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "test_fixtures.h"
+
+TEST_CASE("Dog::SetSpeed with constexpr direction table", "[benchmark]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::GameSession session("map", 5.0, 0.5);
+	auto dog = session.AddPlayer("dog", &map, false, 3)->GetDog();
+
+	BENCHMARK("SetSpeed") {
+		dog->SetSpeed(model::DogDirection::EAST, 1.5);
+		return dog->GetSpeed().vx;
+	};
+
+	model::ActionQueue queue;
+	BENCHMARK("TryPush + Drain") {
+		queue.TryPush(model::PlayerAction{1});
+		return queue.Drain([](model::PlayerAction){});
+	};
+}
@@ -0,0 +1,133 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/action_queue.h"
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "test_fixtures.h"
+
+TEST_CASE("Action queue keeps every command of concurrent producers", "[model]") {
+	constexpr unsigned PRODUCERS = 4;
+	constexpr unsigned PER_PRODUCER = 50000;
+	model::ActionQueue queue(1024);
+
+	std::vector<std::thread> producers;
+	for(unsigned p = 0; p < PRODUCERS; ++p){
+		producers.emplace_back([&queue, p]{
+			for(unsigned i = 0; i < PER_PRODUCER; ++i){
+				// номер производителя в старших разрядах, порядковый номер - в младших
+				while(!queue.TryPush(model::PlayerAction{p << 24 | i})){
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	std::vector<unsigned> next(PRODUCERS, 0);
+	size_t received = 0;
+	bool ordered = true;
+	while(received < PRODUCERS * PER_PRODUCER){
+		received += queue.Drain([&](model::PlayerAction action){
+			const unsigned producer = action.player_id >> 24;
+			ordered = ordered && ((action.player_id & 0xFFFFFF) == next[producer]);
+			++next[producer];
+		});
+	}
+	for(auto& producer : producers){
+		producer.join();
+	}
+
+	CHECK(ordered);
+	CHECK(queue.GetDepth() == 0);
+	CHECK(queue.GetPushedCount() == PRODUCERS * PER_PRODUCER);
+	CHECK(queue.GetMaxDepth() <= queue.GetCapacity());
+	WARN("max queue depth " << queue.GetMaxDepth() << ", rejected pushes " << queue.GetRejectedCount());
+}
+
+TEST_CASE("Full action queue rejects commands", "[model]") {
+	model::ActionQueue queue(4);
+	for(unsigned i = 0; i < 4; ++i){
+		CHECK(queue.TryPush(model::PlayerAction{i}));
+	}
+	CHECK_FALSE(queue.TryPush(model::PlayerAction{4}));
+	CHECK(queue.GetRejectedCount() == 1);
+	CHECK(queue.GetMaxDepth() == 4);
+
+	CHECK(queue.Drain([](model::PlayerAction){}) == 4);
+	CHECK(queue.TryPush(model::PlayerAction{5}));
+
+	// занятое место недоступно другим писателям, пока не заполнено или не отменено
+	for(unsigned i = 0; i < 3; ++i){
+		CHECK(queue.TryReserve());
+	}
+	CHECK_FALSE(queue.TryPush(model::PlayerAction{6}));
+	queue.CancelReservation();
+	CHECK(queue.TryPush(model::PlayerAction{7}));
+	queue.PushReserved(model::PlayerAction{8});
+	queue.PushReserved(model::PlayerAction{9});
+	CHECK(queue.GetDepth() == 4);
+	CHECK(queue.Drain([](model::PlayerAction){}) == 4);
+}
+
+TEST_CASE("Full session queue keeps commands of players already waiting for the tick", "[model]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::GameSession session("map", 5.0, 0.5);
+	const size_t capacity = session.GetActionQueue().GetCapacity();
+	std::vector<std::shared_ptr<model::Player>> players;
+	for(size_t i = 0; i <= capacity; ++i){
+		players.push_back(session.AddPlayer("dog" + std::to_string(i), &map, false, 3));
+	}
+	for(size_t i = 0; i < capacity; ++i){
+		REQUIRE(session.EnqueueAction(*players[i], model::DogDirection::EAST));
+	}
+
+	// у последнего игрока нет записи в заполненной очереди, а первый меняет направление в своей
+	CHECK_FALSE(session.EnqueueAction(*players.back(), model::DogDirection::EAST));
+	CHECK(session.EnqueueAction(*players.front(), model::DogDirection::SOUTH));
+
+	CHECK(session.ApplyPendingActions(2.0) == capacity);
+	CHECK(players.front()->GetDog()->GetSpeed().vy == 2.0);
+	CHECK(players.back()->GetDog()->GetSpeed().vx == 0.0);
+	CHECK_FALSE(players.front()->TakePendingDirection());
+	CHECK_FALSE(players.back()->TakePendingDirection());
+}
+
+TEST_CASE("Session applies the last pending command of each player", "[model]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::GameSession session("map", 5.0, 0.5);
+	auto first = session.AddPlayer("first", &map, false, 3);
+	auto second = session.AddPlayer("second", &map, false, 3);
+
+	session.SetCachedState(std::make_shared<const std::string>("{}"));
+	CHECK(session.EnqueueAction(*first, model::DogDirection::EAST));
+	CHECK(session.GetCachedState() == nullptr);
+	CHECK(session.EnqueueAction(*first, model::DogDirection::SOUTH));
+	CHECK(session.EnqueueAction(*second, model::DogDirection::WEST));
+
+	// повторная команда игрока не занимает новую запись
+	CHECK(session.GetActionQueue().GetDepth() == 2);
+	CHECK(first->GetDog()->GetSpeed().vy == 0.0);
+
+	CHECK(session.ApplyPendingActions(2.0) == 2);
+	CHECK(first->GetDog()->GetDirection() == model::DogDirection::SOUTH);
+	CHECK(first->GetDog()->GetSpeed().vx == 0.0);
+	CHECK(first->GetDog()->GetSpeed().vy == 2.0);
+	CHECK(second->GetDog()->GetSpeed().vx == -2.0);
+	CHECK(session.GetActionQueue().GetDepth() == 0);
+}
+
+TEST_CASE("Stopped dog keeps its direction", "[model]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::GameSession session("map", 5.0, 0.5);
+	auto dog = session.AddPlayer("dog", &map, false, 3)->GetDog();
+
+	dog->SetSpeed(model::DogDirection::NORTH, 1.5);
+	CHECK(dog->GetSpeed().vy == -1.5);
+	dog->SetSpeed(model::DogDirection::STOP, 1.5);
+	CHECK(dog->GetSpeed().vx == 0.0);
+	CHECK(dog->GetSpeed().vy == 0.0);
+	CHECK(dog->GetDirection() == model::DogDirection::NORTH);
+}
@@ -0,0 +1,36 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> allocations_count{0};
+thread_local bool counting_enabled = true;
+
+}
+
+namespace allocation_counter {
+
+size_t GetAllocationsCount(){
+	return allocations_count.load(std::memory_order_relaxed);
+}
+
+void SetCountingOnThisThread(bool enabled){
+	counting_enabled = enabled;
+}
+
+}
+
+void* operator new(std::size_t size){
+	if(counting_enabled){
+		allocations_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	if(void* ptr = std::malloc(size ? size : 1)){
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
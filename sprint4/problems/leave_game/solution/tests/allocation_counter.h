@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+// Глобальный operator new бенчмарков подсчитывает выделения памяти
+namespace allocation_counter {
+
+size_t GetAllocationsCount();
+
+// Выделения в потоке, где подсчёт выключен, не учитываются (например, в потоке клиента нагрузочного теста)
+void SetCountingOnThisThread(bool enabled);
+
+template <typename Fn>
+size_t CountAllocations(Fn&& fn){
+	const size_t before = GetAllocationsCount();
+	fn();
+	return GetAllocationsCount() - before;
+}
+
+}
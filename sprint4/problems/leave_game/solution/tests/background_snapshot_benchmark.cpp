@@ -0,0 +1,78 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/snapshot_writer.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+model::Game MakeGame(size_t dogs, const fs::path& save_path){
+	model::Game game;
+	fixtures::SetupSavedGame(game, {fixtures::MakeSmallMap()}, save_path);
+	for(size_t i = 0; i < dogs; ++i){
+		game.AddPlayer("map", "dog" + std::to_string(i));
+	}
+	// сохранение на каждом тике
+	game.SetSavePeriod(1);
+	return game;
+}
+
+model::GameSessionsStates LoadStates(const fs::path& path){
+	return LoadSessions(serialization::ReadFile(path));
+}
+
+// Время, на которое сохранение задерживает завершение тика
+std::chrono::microseconds MeasureTickStall(model::Game& game){
+	std::chrono::microseconds stall{};
+	game.TickSessions(1, [&game, &stall](std::shared_ptr<model::TickResult> result){
+		REQUIRE(result->states);
+		stall = fixtures::Measure<std::chrono::microseconds>([&]{ game.FinishTick(*result); });
+	});
+	return stall;
+}
+
+}
+
+TEST_CASE("Tick stall of periodic saving: synchronous vs background writer", "[benchmark]") {
+	fixtures::TempDir dir("snapshot_stall_test");
+
+	for(size_t dogs : {1000, 20000}){
+		const fs::path save_path = dir.GetPath() / ("state" + std::to_string(dogs) + ".arch");
+		model::Game game = MakeGame(dogs, save_path);
+
+		std::shared_ptr<model::GameSessionsStates> states;
+		const auto capture = fixtures::Measure<std::chrono::microseconds>([&]{ states = game.GetGameSessionsStates(); });
+		REQUIRE(states->states.front().player_state_.size() == dogs);
+
+		const auto sync_stall = MeasureTickStall(game);
+
+		auto writer = std::make_shared<serialization::SnapshotWriter>(save_path, GetSessionsEncoder(save_path));
+		game.SetSnapshotWriter(writer);
+		constexpr size_t TICKS = 11;
+		std::vector<std::chrono::microseconds> stalls;
+		for(size_t i = 0; i < TICKS; ++i){
+			stalls.push_back(MeasureTickStall(game));
+		}
+		writer->Flush();
+		// максимум включает переключение на поток записи, если ядро одно
+		std::sort(stalls.begin(), stalls.end());
+		const auto background_stall = stalls[TICKS / 2];
+
+		WARN(dogs << " dogs: state capture " << capture.count() << " us, save stall: synchronous "
+			 << sync_stall.count() << " us, background median " << background_stall.count()
+			 << " us, max " << stalls.back().count() << " us");
+		CHECK(writer->GetWrittenSnapshots() >= 1);
+		CHECK(writer->GetWrittenSnapshots() + writer->GetReplacedSnapshots() == TICKS);
+		CHECK(writer->GetFailedWrites() == 0);
+		CHECK(LoadStates(save_path).states.front().player_state_.size() == dogs);
+	}
+}
@@ -0,0 +1,179 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <chrono>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/json_serializer.h"
+#include "../src/binary_serializer.h"
+#include "../src/binary_writer.h"
+#include "test_fixtures.h"
+
+namespace {
+
+using binary_serializer::BinaryReader;
+using binary_serializer::BinaryWriter;
+
+constexpr fixtures::Grid GRID{20, 20};
+constexpr size_t DOGS = 1000;
+constexpr size_t LOOTS = 500;
+
+void CheckHeader(BinaryReader& reader, binary_serializer::MessageType type){
+	CHECK(reader.U8() == 'G');
+	CHECK(reader.U8() == 'S');
+	CHECK(reader.U8() == binary_serializer::FORMAT_VERSION);
+	CHECK(reader.U8() == static_cast<std::uint8_t>(type));
+}
+
+// Сверяет запись собаки с игроком: координаты передаются во float32
+void CheckDog(BinaryReader& reader, model::Player& player){
+	auto dog = player.GetDog();
+	CHECK(reader.Varint() == player.GetId());
+	CHECK(reader.F32() == static_cast<float>(dog->GetPosition().x));
+	CHECK(reader.F32() == static_cast<float>(dog->GetPosition().y));
+	CHECK(reader.F32() == static_cast<float>(dog->GetSpeed().vx));
+	CHECK(reader.F32() == static_cast<float>(dog->GetSpeed().vy));
+	CHECK(reader.U8() == static_cast<std::uint8_t>(dog->GetDirection()));
+	CHECK(reader.I32() == dog->GetScore());
+
+	const auto& bag = dog->GetGatheredLoot();
+	REQUIRE(reader.Varint() == bag.size());
+	for(const auto& item : bag){
+		CHECK(reader.Varint() == item.id);
+		CHECK(reader.Varint() == item.type);
+	}
+}
+
+}
+
+TEST_CASE("Binary writer round-trips fixed-width values and varints", "[benchmark]") {
+	std::string out;
+	BinaryWriter writer(out);
+	writer.U8(0xAB).U32(0x01020304).U64(0x0102030405060708ull).I32(-5)
+		  .F32(1.5f).F64(-0.25).Varint(0).Varint(127).Varint(128).Varint(UINT64_MAX).Bytes("dog");
+
+	// порядок байтов не зависит от платформы
+	CHECK(out.substr(1, 4) == "\x04\x03\x02\x01");
+
+	BinaryReader reader(out);
+	CHECK(reader.U8() == 0xAB);
+	CHECK(reader.U32() == 0x01020304);
+	CHECK(reader.U64() == 0x0102030405060708ull);
+	CHECK(reader.I32() == -5);
+	CHECK(reader.F32() == 1.5f);
+	CHECK(reader.F64() == -0.25);
+	CHECK(reader.Varint() == 0);
+	CHECK(reader.Varint() == 127);
+	const size_t before = reader.GetPosition();
+	CHECK(reader.Varint() == 128);
+	CHECK(reader.GetPosition() - before == 2);
+	CHECK(reader.Varint() == UINT64_MAX);
+	CHECK(reader.Bytes() == "dog");
+	CHECK(reader.GetRemaining() == 0);
+
+	// обрезанные данные не читаются за границей буфера
+	CHECK_THROWS_AS(reader.U8(), std::out_of_range);
+	BinaryReader truncated(std::string_view(out).substr(0, 3));
+	CHECK_THROWS_AS(truncated.U32(), std::out_of_range);
+}
+
+TEST_CASE("Binary game state: size and encode time vs JSON", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID);
+	model::GameSession session("grid", 5.0, 0.5);
+	for(size_t i = 0; i < DOGS; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+	session.SetLootsInfo(fixtures::MakeLoots(GRID, LOOTS));
+
+	const auto& players = session.GetPlayers();
+	const auto& loots = session.GetLootsInfo();
+
+	const std::string binary = binary_serializer::GetPlayersDogInfoResponce(players, loots);
+	const std::string json = json_serializer::GetPlayersDogInfoResponce(players, loots);
+
+	BinaryReader reader(binary);
+	CheckHeader(reader, binary_serializer::MessageType::STATE);
+	REQUIRE(reader.Varint() == players.size());
+	for(const auto& player : players){
+		CheckDog(reader, *player);
+	}
+	REQUIRE(reader.Varint() == loots.size());
+	for(const auto& loot : loots){
+		CHECK(reader.Varint() == loot.id);
+		CHECK(reader.Varint() == loot.type);
+		CHECK(reader.F32() == static_cast<float>(loot.x));
+		CHECK(reader.F32() == static_cast<float>(loot.y));
+	}
+	CHECK(reader.GetRemaining() == 0);
+
+	// Список игроков
+	const std::string names = binary_serializer::GetPlayerInfoResponce(players);
+	BinaryReader names_reader(names);
+	CheckHeader(names_reader, binary_serializer::MessageType::PLAYERS);
+	REQUIRE(names_reader.Varint() == players.size());
+	for(const auto& player : players){
+		CHECK(names_reader.Varint() == player->GetId());
+		CHECK(names_reader.Bytes() == player->GetName());
+	}
+
+	auto encode_ns_per_player = [&](auto&& encode){
+		constexpr int ROUNDS = 50;
+		const auto start = std::chrono::steady_clock::now();
+		size_t bytes = 0;
+		for(int i = 0; i < ROUNDS; ++i){
+			bytes += encode().size();
+		}
+		const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		CHECK(bytes > 0);
+		return static_cast<double>(elapsed.count()) / ROUNDS / players.size();
+	};
+	const double binary_ns = encode_ns_per_player([&]{ return binary_serializer::GetPlayersDogInfoResponce(players, loots); });
+	const double json_ns = encode_ns_per_player([&]{ return json_serializer::GetPlayersDogInfoResponce(players, loots); });
+
+	WARN("bytes per player: json " << json.size() / DOGS << ", binary " << binary.size() / DOGS
+		 << "; encode ns per player: json " << json_ns << ", binary " << binary_ns);
+	CHECK(binary.size() * 3 < json.size());
+
+	BENCHMARK("JSON state, bytes: " + std::to_string(json.size())) {
+		return json_serializer::GetPlayersDogInfoResponce(players, loots);
+	};
+
+	BENCHMARK("Binary state, bytes: " + std::to_string(binary.size())) {
+		return binary_serializer::GetPlayersDogInfoResponce(players, loots);
+	};
+
+	// Буфер переиспользуется между тиками
+	std::string buffer;
+	BENCHMARK("Binary state into reused buffer") {
+		buffer.clear();
+		binary_serializer::WritePlayersDogInfo(buffer, players, loots);
+		return buffer.size();
+	};
+}
+
+TEST_CASE("Binary state delta carries changes and removals", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID);
+	model::GameSession session("grid", 5.0, 0.5);
+	for(size_t i = 0; i < 10; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+	session.SetLootsInfo(fixtures::MakeLoots(GRID, 10));
+	session.FinishTick();
+	const std::uint64_t base = session.GetTick();
+
+	auto retired = session.GetPlayers().back();
+	session.DeleteRetiredPlayers({retired});
+	session.FinishTick();
+
+	const std::string delta = binary_serializer::GetStateDeltaResponce(session.GetChangesSince(base));
+	BinaryReader reader(delta);
+	CheckHeader(reader, binary_serializer::MessageType::STATE_DELTA);
+	CHECK(reader.Varint() == session.GetTick());
+	CHECK(reader.U8() == 0);
+	CHECK(reader.Varint() == 0);
+	CHECK(reader.Varint() == 0);
+	REQUIRE(reader.Varint() == 1);
+	CHECK(reader.Varint() == retired->GetId());
+	CHECK(reader.Varint() == 0);
+	CHECK(reader.GetRemaining() == 0);
+}
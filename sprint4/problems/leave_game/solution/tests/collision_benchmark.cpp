@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "../src/collision_detector.h"
+
+namespace {
+
+constexpr size_t GATHERERS_COUNT = 1000;
+constexpr size_t ITEMS_PER_GATHERER = 64;
+
+std::vector<collision_detector::Gatherer> MakeGatherers(){
+	std::vector<collision_detector::Gatherer> gatherers;
+	for(size_t i = 0; i < GATHERERS_COUNT; ++i){
+		const double y = static_cast<double>(i);
+		gatherers.push_back({{0.0, y}, {0.3, y}, 0.6});
+	}
+	return gatherers;
+}
+
+std::vector<collision_detector::Item> MakeItemsNear(const collision_detector::Gatherer& gatherer){
+	std::vector<collision_detector::Item> items;
+	for(size_t i = 0; i < ITEMS_PER_GATHERER; ++i){
+		const double dx = static_cast<double>(i % 8) * 0.1 - 0.2;
+		const double dy = static_cast<double>(i / 8) * 0.2 - 0.8;
+		items.emplace_back(i, geom::Point2D{gatherer.start_pos.x + dx, gatherer.start_pos.y + dy}, 0.0);
+	}
+	return items;
+}
+
+}
+
+TEST_CASE("Per-dog and batched gather events search", "[benchmark]") {
+	const auto gatherers = MakeGatherers();
+
+	std::vector<std::vector<collision_detector::Item>> near_items;
+	collision_detector::ItemsBatch items_batch;
+	collision_detector::GatherersBatch gatherers_batch;
+
+	for(const auto& gatherer : gatherers){
+		const auto& items = near_items.emplace_back(MakeItemsNear(gatherer));
+		const size_t first_item = items_batch.Size();
+		for(const auto& item : items){
+			items_batch.Add(item);
+		}
+		gatherers_batch.Add(gatherer, {first_item, items_batch.Size()});
+	}
+
+	size_t per_dog_events = 0;
+	for(size_t i = 0; i < gatherers.size(); ++i){
+		collision_detector::ItemGatherer item_gath(near_items[i], {gatherers[i]});
+		per_dog_events += collision_detector::FindGatherEvents(item_gath).size();
+	}
+	REQUIRE(per_dog_events == collision_detector::FindGatherEvents(gatherers_batch, items_batch).size());
+
+	BENCHMARK("Per-dog ItemGatherer calls") {
+		size_t events = 0;
+		for(size_t i = 0; i < gatherers.size(); ++i){
+			collision_detector::ItemGatherer item_gath(near_items[i], {gatherers[i]});
+			events += collision_detector::FindGatherEvents(item_gath).size();
+		}
+		return events;
+	};
+
+	BENCHMARK("Batched FindGatherEvents") {
+		return collision_detector::FindGatherEvents(gatherers_batch, items_batch).size();
+	};
+}
@@ -63,3 +63,85 @@ SCENARIO("No collision detected") {
         }
     }
 }
+
+namespace {
+
+std::vector<collision_detector::GatheringEvent> FindGatherEventsBatched(const collision_detector::ItemGatherer& gath) {
+    collision_detector::ItemsBatch items;
+    for (size_t i = 0; i < gath.ItemsCount(); ++i) {
+        items.Add(gath.GetItem(i));
+    }
+
+    collision_detector::GatherersBatch gatherers;
+    for (size_t i = 0; i < gath.GatherersCount(); ++i) {
+        gatherers.Add(gath.GetGatherer(i), {0, items.Size()});
+    }
+
+    return collision_detector::FindGatherEvents(gatherers, items);
+}
+
+}
+
+SCENARIO("Batched search gives the same events") {
+    WHEN("multiple items on a way of gatherer") {
+    	collision_detector::ItemGatherer gath{{
+            {0, {9, 0.27}, .1}, {1, {8, 0.24}, .1}, {2, {7, 0.21}, .1}, {3, {6, 0.18}, .1},
+            {4, {5, 0.15}, .1}, {5, {4, 0.12}, .1}, {6, {3, 0.09}, .1}, {7, {2, 0.06}, .1}, {8, {1, 0.03}, .1}, {9, {0, 0.0}, .1},
+            {10, {-1, 0}, .1}, },
+            { {{0, 0}, {10, 0}, 0.1},
+        }};
+        THEN("Gathered items in right order") {
+            CHECK_THAT(
+                FindGatherEventsBatched(gath),
+                EqualsRange(std::vector{
+                    collision_detector::GatheringEvent{9, 0,0.0, 0.0},
+                    collision_detector::GatheringEvent{8, 0,0.0009, 0.1},
+                    collision_detector::GatheringEvent{7, 0,0.0036, 0.2},
+                    collision_detector::GatheringEvent{6, 0,0.0081, 0.3},
+                    collision_detector::GatheringEvent{5, 0,0.0144, 0.4},
+                    collision_detector::GatheringEvent{4, 0,0.0225, 0.5},
+                    collision_detector::GatheringEvent{3, 0,0.0324, 0.6},
+                }, EventsComparator()));
+        }
+    }
+    WHEN("there are several gatherers on the way to one item") {
+    	collision_detector::ItemGatherer gath{{ {0, {0, 0}, 0.0}, },
+                                            { {{-5, 0}, {5, 0}, 1.}, {{0, 1}, {0, -1}, 1.},
+                                                {{-11, 11}, {101, -101}, 0.5},
+                                                {{-101, 100}, {11, -11}, 0.5},
+					     }
+        };
+        THEN("And faster gatherer get an item") {
+            auto events = FindGatherEventsBatched(gath);
+            REQUIRE(!events.empty());
+            CHECK(events.front().gatherer_id == 2);
+        }
+    }
+    WHEN("Gatherers were static") {
+    	collision_detector::ItemGatherer gath{{ {0, {0, 0}, 10.5},},
+                                            { {{-3.1, 0}, {-3.1, 0}, 1.5}, {{0.0, 0}, {0.0, 0}, 1.5},
+                                                {{-11.5, 10}, {-11.5, 10}, 120} }
+        };
+        THEN("No events detected") {
+            CHECK(FindGatherEventsBatched(gath).empty());
+        }
+    }
+    WHEN("many gatherers cross a field of items") {
+        std::vector<collision_detector::Item> items;
+        for (unsigned i = 0; i < 103; ++i) {
+            items.emplace_back(i, geom::Point2D{(i % 11) * 1.3, (i / 11) * 0.7}, (i % 3) * 0.1);
+        }
+
+        std::vector<collision_detector::Gatherer> gatherers;
+        for (int i = 0; i < 17; ++i) {
+            gatherers.push_back({{-1.0, i * 0.4}, {15.0, 7.0 - i * 0.3}, 0.6});
+        }
+
+        collision_detector::ItemGatherer gath{items, gatherers};
+        THEN("Events match the per-item search") {
+            auto expected = collision_detector::FindGatherEvents(gath);
+            REQUIRE(!expected.empty());
+            CHECK_THAT(FindGatherEventsBatched(gath), EqualsRange(expected, EventsComparator()));
+        }
+    }
+}
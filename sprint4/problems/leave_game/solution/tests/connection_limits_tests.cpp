@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../src/http_server.h"
+
+namespace {
+
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+using tcp = net::ip::tcp;
+using namespace std::chrono_literals;
+using http_server::CloseReason;
+
+// Сервер в отдельном потоке с заданными лимитами
+class TestServer {
+public:
+	explicit TestServer(http_server::ServerLimits limits)
+		: tracker_(std::make_shared<http_server::ConnectionTracker>(limits)) {
+		tcp::acceptor probe(ioc_, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+		endpoint_ = probe.local_endpoint();
+		probe.close();
+
+		http_server::ServeHttp(ioc_, endpoint_, [](auto&& req, auto&& send){
+			http::response<http::string_body> resp(http::status::ok, req.version());
+			resp.body() = "ok";
+			resp.content_length(resp.body().size());
+			resp.keep_alive(req.keep_alive());
+			send(std::move(resp));
+		}, tracker_);
+		thread_ = std::thread([this]{ ioc_.run(); });
+	}
+
+	~TestServer(){
+		ioc_.stop();
+		thread_.join();
+	}
+
+	const tcp::endpoint& GetEndpoint() const { return endpoint_; }
+	const http_server::ConnectionTracker& GetTracker() const { return *tracker_; }
+
+	// Ждёт, пока счётчик причины не достигнет ожидаемого значения
+	bool WaitForClosed(CloseReason reason, std::uint64_t count) const {
+		for(int i = 0; i < 200; ++i){
+			if(tracker_->GetClosedConnections(reason) >= count){
+				return true;
+			}
+			std::this_thread::sleep_for(5ms);
+		}
+		return false;
+	}
+
+private:
+	net::io_context ioc_;
+	std::shared_ptr<http_server::ConnectionTracker> tracker_;
+	tcp::endpoint endpoint_;
+	std::thread thread_;
+};
+
+http::response<http::string_body> Get(boost::beast::tcp_stream& stream, boost::beast::flat_buffer& buffer, bool keep_alive = true){
+	http::request<http::string_body> req(http::verb::get, "/", 11);
+	req.set(http::field::host, "127.0.0.1");
+	req.keep_alive(keep_alive);
+	http::write(stream, req);
+
+	http::response<http::string_body> resp;
+	http::read(stream, buffer, resp);
+	return resp;
+}
+
+// Признак закрытия соединения сервером: чтение завершается без данных
+bool IsClosedByServer(boost::beast::tcp_stream& stream){
+	stream.expires_after(2s);
+	char byte;
+	boost::beast::error_code ec;
+	stream.socket().read_some(net::buffer(&byte, 1), ec);
+	return ec == net::error::eof || ec == net::error::connection_reset;
+}
+
+}
+
+TEST_CASE("Idle keep-alive connection is closed after timeout", "[http]") {
+	http_server::ServerLimits limits;
+	limits.keep_alive_timeout = 50ms;
+	TestServer server(limits);
+
+	net::io_context client_ioc;
+	boost::beast::tcp_stream stream(client_ioc);
+	stream.connect(server.GetEndpoint());
+	boost::beast::flat_buffer buffer;
+
+	CHECK(Get(stream, buffer).body() == "ok");
+	CHECK(IsClosedByServer(stream));
+	CHECK(server.WaitForClosed(CloseReason::KEEP_ALIVE_TIMEOUT, 1));
+}
+
+TEST_CASE("Incomplete request headers hit the header timeout", "[http]") {
+	http_server::ServerLimits limits;
+	limits.header_timeout = 50ms;
+	TestServer server(limits);
+
+	net::io_context client_ioc;
+	boost::beast::tcp_stream stream(client_ioc);
+	stream.connect(server.GetEndpoint());
+	net::write(stream.socket(), net::buffer(std::string("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n")));
+
+	CHECK(IsClosedByServer(stream));
+	CHECK(server.WaitForClosed(CloseReason::HEADER_TIMEOUT, 1));
+}
+
+TEST_CASE("Incomplete request body hits the body timeout", "[http]") {
+	http_server::ServerLimits limits;
+	limits.body_timeout = 50ms;
+	TestServer server(limits);
+
+	net::io_context client_ioc;
+	boost::beast::tcp_stream stream(client_ioc);
+	stream.connect(server.GetEndpoint());
+	net::write(stream.socket(), net::buffer(std::string("POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 10\r\n\r\n12345")));
+
+	CHECK(IsClosedByServer(stream));
+	CHECK(server.WaitForClosed(CloseReason::BODY_TIMEOUT, 1));
+}
+
+TEST_CASE("Connections above the limit wait for a free slot", "[http]") {
+	http_server::ServerLimits limits;
+	limits.max_connections = 1;
+	TestServer server(limits);
+
+	net::io_context client_ioc;
+	boost::beast::flat_buffer first_buffer;
+	boost::beast::tcp_stream first(client_ioc);
+	first.connect(server.GetEndpoint());
+	CHECK(Get(first, first_buffer).body() == "ok");
+
+	// Второе соединение ждёт в очереди ядра и не обслуживается, пока открыто первое
+	boost::beast::tcp_stream second(client_ioc);
+	second.connect(server.GetEndpoint());
+	http::request<http::string_body> req(http::verb::get, "/", 11);
+	req.set(http::field::host, "127.0.0.1");
+	http::write(second, req);
+
+	second.socket().non_blocking(true);
+	std::this_thread::sleep_for(50ms);
+	CHECK(second.socket().available() == 0);
+	second.socket().non_blocking(false);
+
+	CHECK(Get(first, first_buffer, false).body() == "ok");
+	CHECK(server.WaitForClosed(CloseReason::NOT_KEEP_ALIVE, 1));
+
+	boost::beast::flat_buffer second_buffer;
+	http::response<http::string_body> resp;
+	http::read(second, second_buffer, resp);
+	CHECK(resp.body() == "ok");
+}
+
+TEST_CASE("Client disconnect is counted once", "[http]") {
+	TestServer server(http_server::ServerLimits{});
+
+	{
+		net::io_context client_ioc;
+		boost::beast::tcp_stream stream(client_ioc);
+		stream.connect(server.GetEndpoint());
+		boost::beast::flat_buffer buffer;
+		CHECK(Get(stream, buffer).body() == "ok");
+		stream.socket().shutdown(tcp::socket::shutdown_send);
+		CHECK(IsClosedByServer(stream));
+	}
+
+	CHECK(server.WaitForClosed(CloseReason::CLIENT_CLOSED, 1));
+	CHECK(server.GetTracker().GetClosedConnections(CloseReason::READ_ERROR) == 0);
+}
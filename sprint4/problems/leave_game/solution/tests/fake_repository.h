@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/retired_writer.h"
+
+// Хранилище ушедших на пенсию игроков без базы данных
+namespace fixtures {
+
+using Records = postgres::RetiredWriter::Records;
+
+// Замена таблицы retired_players: каждая транзакция стоит round_trip, первые fail_first падают
+class FakeRepository {
+public:
+	explicit FakeRepository(std::chrono::microseconds round_trip = std::chrono::microseconds::zero(), size_t fail_first = 0)
+		: round_trip_(round_trip), fail_first_(fail_first) {}
+
+	void SaveRetired(const Records& records){
+		std::this_thread::sleep_for(round_trip_);
+		{
+			std::unique_lock lock(mutex_);
+			gate_.wait(lock, [this]{ return open_; });
+			if(calls_++ < fail_first_){
+				throw std::runtime_error("connection lost");
+			}
+			batches_.push_back(records.size());
+			for(const auto& record : records){
+				saved_.push_back(record.id);
+			}
+		}
+	}
+
+	postgres::RetiredWriter::BatchSaver GetSaver(){
+		return [this](const Records& records){ SaveRetired(records); };
+	}
+
+	// Пока закрыто, транзакции ждут, как при зависшей базе
+	void SetOpen(bool open){
+		{
+			std::lock_guard lock(mutex_);
+			open_ = open;
+		}
+		gate_.notify_all();
+	}
+
+	std::vector<std::string> GetSaved() const {
+		std::lock_guard lock(mutex_);
+		return saved_;
+	}
+	std::vector<size_t> GetBatches() const {
+		std::lock_guard lock(mutex_);
+		return batches_;
+	}
+
+private:
+	std::chrono::microseconds round_trip_;
+	size_t fail_first_;
+	mutable std::mutex mutex_;
+	std::condition_variable gate_;
+	bool open_{true};
+	size_t calls_{0};
+	std::vector<std::string> saved_;
+	std::vector<size_t> batches_;
+};
+
+inline Records MakeRecords(size_t first, size_t count){
+	Records records;
+	for(size_t i = first; i < first + count; ++i){
+		records.push_back({"id" + std::to_string(i), "dog" + std::to_string(i), static_cast<int>(i), static_cast<int>(i * 10)});
+	}
+	return records;
+}
+
+inline std::vector<std::string> MakeIds(size_t count){
+	std::vector<std::string> ids;
+	for(size_t i = 0; i < count; ++i){
+		ids.push_back("id" + std::to_string(i));
+	}
+	return ids;
+}
+
+}  // namespace fixtures
@@ -0,0 +1,228 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/http_server.h"
+#include "../src/game_stream.h"
+#include "../src/game_session.h"
+#include "../src/model.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+using tcp = net::ip::tcp;
+using namespace std::chrono_literals;
+
+using Client = websocket::stream<beast::tcp_stream>;
+
+// Сервер, подписывающий каждое WebSocket-соединение на одну игровую сессию от имени одного игрока
+class StreamServer {
+public:
+	StreamServer(model::Game& game, model::PlayerHandle handle)
+		: hub_(game), handle_(std::move(handle)) {
+		tcp::acceptor probe(ioc_, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+		endpoint_ = probe.local_endpoint();
+		probe.close();
+
+		http_server::ServeHttp(ioc_, endpoint_, Handler{this});
+		thread_ = std::thread([this]{ ioc_.run(); });
+	}
+
+	~StreamServer(){
+		ioc_.stop();
+		thread_.join();
+	}
+
+	const tcp::endpoint& GetEndpoint() const { return endpoint_; }
+	http_handler::GameStreamHub& GetHub() { return hub_; }
+
+	std::shared_ptr<http_handler::GameStreamSession> GetSubscriber(size_t index){
+		std::lock_guard lock(mutex_);
+		return subscribers_.at(index);
+	}
+
+	bool WaitForSubscribers(size_t count){
+		for(int i = 0; i < 400; ++i){
+			if(hub_.GetSubscribersCount(*handle_.session) >= count){
+				return true;
+			}
+			std::this_thread::sleep_for(5ms);
+		}
+		return false;
+	}
+
+private:
+	struct Handler {
+		StreamServer* server;
+
+		void operator()(auto&& req, auto&& send) const {
+			http::response<http::string_body> resp(http::status::not_found, req.version());
+			resp.content_length(0);
+			resp.keep_alive(req.keep_alive());
+			send(std::move(resp));
+		}
+
+		bool Upgrade(const auto& req, http_server::SessionStream& stream) const {
+			auto subscriber = std::make_shared<http_handler::GameStreamSession>(std::move(stream), server->handle_);
+			subscriber->Run(req);
+			{
+				std::lock_guard lock(server->mutex_);
+				server->subscribers_.push_back(subscriber);
+			}
+			server->hub_.Subscribe(std::move(subscriber));
+			return true;
+		}
+	};
+
+	net::io_context ioc_;
+	http_handler::GameStreamHub hub_;
+	model::PlayerHandle handle_;
+	std::mutex mutex_;
+	std::vector<std::shared_ptr<http_handler::GameStreamSession>> subscribers_;
+	tcp::endpoint endpoint_;
+	std::thread thread_;
+};
+
+std::unique_ptr<Client> Connect(net::io_context& ioc, const tcp::endpoint& endpoint){
+	auto client = std::make_unique<Client>(ioc);
+	client->next_layer().connect(endpoint);
+	client->read_message_max(64 * 1024 * 1024);
+	client->handshake("127.0.0.1", "/api/v1/game/stream");
+	return client;
+}
+
+std::string ReadFrame(Client& client){
+	beast::flat_buffer buffer;
+	client.read(buffer);
+	return beast::buffers_to_string(buffer.data());
+}
+
+template <typename Predicate>
+bool WaitFor(Predicate&& predicate){
+	for(int i = 0; i < 400; ++i){
+		if(predicate()){
+			return true;
+		}
+		std::this_thread::sleep_for(5ms);
+	}
+	return false;
+}
+
+}
+
+TEST_CASE("Session tick is serialized once and pushed to every subscriber", "[http]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::Game game;
+	auto session = std::make_shared<model::GameSession>("map", 5.0, 0.5);
+	for(size_t i = 0; i < 10; ++i){
+		session->AddPlayer("dog" + std::to_string(i), &map, false, 3);
+	}
+
+	StreamServer server(game, {session, session->GetPlayers().front()});
+
+	constexpr size_t SUBSCRIBERS = 8;
+	net::io_context client_ioc;
+	std::vector<std::unique_ptr<Client>> clients;
+	for(size_t i = 0; i < SUBSCRIBERS; ++i){
+		clients.push_back(Connect(client_ioc, server.GetEndpoint()));
+	}
+	REQUIRE(server.WaitForSubscribers(SUBSCRIBERS));
+
+	// Снимок после тика становится и ответом на опрос состояния
+	session->MoveDogs(100);
+	server.GetHub().OnSessionTick(session);
+	const auto state = session->GetCachedState();
+	REQUIRE(state);
+
+	for(auto& client : clients){
+		CHECK(ReadFrame(*client) == *state);
+	}
+
+	// Все подписчики получают один и тот же кадр
+	const std::string frame = R"({"players":{},"lostObjects":{}})";
+	server.GetHub().Publish(*session, std::make_shared<const std::string>(frame));
+	for(auto& client : clients){
+		CHECK(ReadFrame(*client) == frame);
+	}
+
+	// Закрытый клиент забывается при следующей рассылке
+	clients.back()->close(websocket::close_code::normal);
+	clients.pop_back();
+	CHECK(WaitFor([&]{ return server.GetSubscriber(SUBSCRIBERS - 1)->IsClosed(); }));
+	server.GetHub().Publish(*session, state);
+	CHECK(server.GetHub().GetSubscribersCount(*session) == SUBSCRIBERS - 1);
+}
+
+TEST_CASE("Slow subscriber skips frames instead of buffering them", "[http]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::Game game;
+	auto session = std::make_shared<model::GameSession>("map", 5.0, 0.5);
+	StreamServer server(game, {session, session->AddPlayer("dog", &map, false, 3)});
+
+	net::io_context client_ioc;
+	auto client = Connect(client_ioc, server.GetEndpoint());
+	REQUIRE(server.WaitForSubscribers(1));
+	auto subscriber = server.GetSubscriber(0);
+
+	// Большой кадр не помещается в буферы сокетов, пока клиент не читает, и запись не завершается
+	const auto big_frame = std::make_shared<const std::string>(32 * 1024 * 1024, 'x');
+	server.GetHub().Publish(*session, big_frame);
+
+	constexpr size_t SMALL_FRAMES = 50;
+	for(size_t i = 1; i <= SMALL_FRAMES; ++i){
+		server.GetHub().Publish(*session, std::make_shared<const std::string>("frame-" + std::to_string(i)));
+	}
+	// ждёт только последний кадр, остальные заменены им
+	CHECK(WaitFor([&]{ return subscriber->GetDroppedFrames() == SMALL_FRAMES - 1; }));
+
+	CHECK(ReadFrame(*client).size() == big_frame->size());
+	CHECK(ReadFrame(*client) == "frame-" + std::to_string(SMALL_FRAMES));
+	CHECK(WaitFor([&]{ return subscriber->GetSentFrames() == 2; }));
+	CHECK(!subscriber->IsClosed());
+
+	// Клиент, пропускающий слишком много кадров подряд, отключается
+	server.GetHub().Publish(*session, big_frame);
+	for(size_t i = 0; i <= http_handler::GameStreamSession::MAX_SKIPPED_FRAMES + 1; ++i){
+		server.GetHub().Publish(*session, std::make_shared<const std::string>("late"));
+	}
+	CHECK(WaitFor([&]{ return subscriber->IsClosed(); }));
+	server.GetHub().Publish(*session, big_frame);
+	CHECK(server.GetHub().GetSubscribersCount(*session) == 0);
+}
+
+TEST_CASE("Stream of a retired player is closed after the tick", "[http]") {
+	model::Map map = fixtures::MakeSmallMap();
+	model::Game game;
+	auto session = std::make_shared<model::GameSession>("map", 5.0, 0.5);
+	auto player = session->AddPlayer("dog", &map, false, 3);
+	session->AddPlayer("other", &map, false, 3);
+	StreamServer server(game, {session, player});
+
+	net::io_context client_ioc;
+	auto client = Connect(client_ioc, server.GetEndpoint());
+	REQUIRE(server.WaitForSubscribers(1));
+
+	// длинное сообщение клиента читается и отбрасывается, не закрывая поток
+	client->write(net::buffer(std::string(64 * 1024, 'x')));
+	server.GetHub().OnSessionTick(session);
+	CHECK(!ReadFrame(*client).empty());
+
+	session->DeleteRetiredPlayers({player});
+	server.GetHub().OnSessionTick(session);
+	CHECK(server.GetHub().GetSubscribersCount(*session) == 0);
+
+	// клиент получает закрывающий кадр вместо состояния
+	beast::flat_buffer buffer;
+	beast::error_code ec;
+	client->read(buffer, ec);
+	CHECK(ec == websocket::error::closed);
+	CHECK(server.GetSubscriber(0)->IsClosed());
+}
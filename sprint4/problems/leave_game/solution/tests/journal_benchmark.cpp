@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/journal.h"
+#include "../src/state_archive.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr int TICK_MS = 1000;
+
+}
+
+TEST_CASE("Bytes written per tick: journal vs full save of 10k dogs", "[benchmark]") {
+	fixtures::TempDir dir("journal_size_test");
+	const fs::path save_path = dir.GetPath() / "state.bin";
+
+	constexpr size_t DOGS = 10000;
+	constexpr size_t MOVING = DOGS / 10;
+	constexpr size_t TICKS = 10;
+
+	model::Game game;
+	fixtures::SetupSmallGame(game, save_path);
+	std::vector<std::string> tokens;
+	for(size_t i = 0; i < DOGS; ++i){
+		tokens.push_back(game.AddPlayer("map", "dog" + std::to_string(i)).first);
+	}
+	auto session = game.GetSessionWithAuthInfo(tokens.front());
+	// записи о входе всех игроков - до замера
+	auto journal = std::make_shared<serialization::Journal>(save_path);
+	game.SetJournal(journal);
+	fixtures::Tick(game, TICK_MS);
+	journal->Flush();
+	const auto written_before = journal->GetWrittenBytes();
+
+	for(size_t tick = 0; tick < TICKS; ++tick){
+		// каждый тик ходит каждая десятая собака, ходившие в прошлом тике останавливаются
+		for(size_t i = 0; i < MOVING; ++i){
+			session->EnqueueAction(*game.GetPlayerWithAuthToken(tokens[i * 10 + tick]), model::DogDirection::EAST);
+			if(tick > 0){
+				session->EnqueueAction(*game.GetPlayerWithAuthToken(tokens[i * 10 + tick - 1]), model::DogDirection::STOP);
+			}
+		}
+		fixtures::Tick(game, TICK_MS);
+	}
+	journal->Flush();
+	const auto journal_bytes = (journal->GetWrittenBytes() - written_before) / TICKS;
+
+	// последний тик кодируется ещё раз, чтобы измерить работу журнала без самого тика
+	std::string records, snapshot;
+	const auto journal_time = fixtures::Measure<std::chrono::microseconds>([&]{
+		records = serialization::EncodeJournalRecords(*session, session->GetChangesSince(session->GetTick() - 1));
+	});
+	const auto save_time = fixtures::Measure<std::chrono::microseconds>([&]{
+		snapshot = serialization::EncodeBinaryArchive(*game.GetGameSessionsStates());
+	});
+
+	WARN(DOGS << " dogs, " << MOVING << " moving per tick: journal " << journal_bytes << " B and "
+		 << journal_time.count() << " us to encode a tick, full binary save "
+		 << snapshot.size() << " B and " << save_time.count() << " us to encode");
+	CHECK(journal->GetFailedWrites() == 0);
+	CHECK(journal_bytes * 5 < snapshot.size());
+	CHECK(!records.empty());
+	CHECK(records.size() * 5 < snapshot.size());
+}
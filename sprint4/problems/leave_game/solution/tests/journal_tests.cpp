@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/journal.h"
+#include "../src/snapshot_writer.h"
+#include "state_comparison.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+// Время в игре стоящей собаки попадает в журнал только вместе с её изменением, поэтому не сравнивается
+constexpr state_comparison::PlayerFields JOURNAL_FIELDS{.play_time = false};
+
+// Тик в секунду: собака с места проходит за тик одну единицу
+constexpr int TICK_MS = 1000;
+
+void AppendToFile(const fs::path& path, const std::string& data){
+	std::ofstream out(path, std::ios::binary | std::ios::app);
+	out << data;
+}
+
+}
+
+TEST_CASE("Journal restores joins, moves, departures and loot without a full save", "[persistence]") {
+	fixtures::TempDir dir("journal_replay_test");
+	const fs::path save_path = dir.GetPath() / "state.bin";
+
+	model::GameSessionsStates expected;
+	{
+		model::Game game;
+		fixtures::SetupSmallGame(game, save_path);
+		auto journal = std::make_shared<serialization::Journal>(save_path);
+		game.SetJournal(journal);
+
+		std::vector<std::string> tokens;
+		for(int i = 0; i < 5; ++i){
+			tokens.push_back(game.AddPlayer("map", "dog" + std::to_string(i)).first);
+		}
+		fixtures::Tick(game, TICK_MS);
+
+		auto session = game.GetSessionWithAuthInfo(tokens.front());
+		session->EnqueueAction(*game.GetPlayerWithAuthToken(tokens[0]), model::DogDirection::EAST);
+		session->EnqueueAction(*game.GetPlayerWithAuthToken(tokens[1]), model::DogDirection::SOUTH);
+		for(int i = 0; i < 3; ++i){
+			fixtures::Tick(game, TICK_MS);
+		}
+		session->EnqueueAction(*game.GetPlayerWithAuthToken(tokens[1]), model::DogDirection::STOP);
+
+		// уход игрока - как после ухода на пенсию
+		session->DeleteRetiredPlayers({game.GetPlayerWithAuthToken(tokens[2])});
+		fixtures::Tick(game, TICK_MS);
+		game.AddPlayer("map", "late");
+		fixtures::Tick(game, TICK_MS);
+
+		journal->Flush();
+		CHECK(journal->GetFailedWrites() == 0);
+		expected = *game.GetGameSessionsStates();
+	}
+	REQUIRE(expected.states.size() == 1);
+	REQUIRE(expected.states.front().player_state_.size() == 5);
+	REQUIRE(!expected.states.front().loots_info_state.empty());
+
+	// файла сохранения нет, всё состояние - в журнале
+	model::GameSessionsStates replayed;
+	const auto replay = serialization::ReplayJournal(save_path, replayed);
+	CHECK(replay.segments == 1);
+	CHECK(replay.batches == 6);
+	CHECK(replay.torn_segments == 0);
+	CHECK(state_comparison::SameStates(replayed, expected, JOURNAL_FIELDS));
+
+	// записи повторяют сущности целиком: журнал поверх уже применённого ничего не меняет
+	serialization::ReplayJournal(save_path, replayed);
+	CHECK(state_comparison::SameStates(replayed, expected, JOURNAL_FIELDS));
+
+	// обрезанный при сбое пакет в конце сегмента отбрасывается
+	const auto segments = serialization::Journal::FindSegments(save_path);
+	REQUIRE(segments.size() == 1);
+	AppendToFile(segments.front().second, std::string("\x40\x00\x00\x00\x12\x34", 6));
+	model::GameSessionsStates torn;
+	CHECK(serialization::ReplayJournal(save_path, torn).torn_segments == 1);
+	CHECK(state_comparison::SameStates(torn, expected, JOURNAL_FIELDS));
+
+	// сервер после перезапуска получает тех же игроков и продолжает журнал в новом сегменте
+	model::Game restarted;
+	fixtures::SetupSmallGame(restarted, save_path);
+	DeserializeSessions(restarted);
+	CHECK(restarted.GetNumPlayersInAllSessions() == 5);
+	CHECK(restarted.FindPlayerByToken(expected.states.front().player_state_.back().token_));
+	CHECK(serialization::Journal(save_path).GetSegment() == segments.front().first + 1);
+}
+
+TEST_CASE("Journal commits ticks in groups and drops segments covered by a save", "[persistence]") {
+	fixtures::TempDir dir("journal_segments_test");
+	const fs::path save_path = dir.GetPath() / "state.bin";
+
+	model::Game game;
+	fixtures::SetupSmallGame(game, save_path);
+	for(int i = 0; i < 10; ++i){
+		game.AddPlayer("map", "dog" + std::to_string(i));
+	}
+	auto journal = std::make_shared<serialization::Journal>(save_path);
+	game.SetJournal(journal);
+	auto writer = std::make_shared<serialization::SnapshotWriter>(save_path, GetSessionsEncoder(save_path));
+	game.SetSnapshotWriter(writer);
+
+	// Пакеты, переданные, пока поток пишет предыдущие, уходят одним fdatasync
+	constexpr size_t BATCHES = 2000;
+	const std::string record(64, 'x');
+	for(size_t i = 0; i < BATCHES; ++i){
+		journal->Append(record);
+		journal->Commit();
+	}
+	journal->Flush();
+	WARN(BATCHES << " batches written with " << journal->GetSyncs() << " fdatasync calls");
+	CHECK(journal->GetCommittedBatches() == BATCHES);
+	CHECK(journal->GetSyncs() < BATCHES);
+	CHECK(journal->GetWrittenBytes() == BATCHES * (record.size() + 8));
+
+	// Сохранение начинает новый сегмент, а старый удаляется, когда файл сохранения на диске
+	const auto first_segment = journal->GetSegment();
+	game.SetSavePeriod(TICK_MS);
+	fixtures::Tick(game, TICK_MS);
+	writer->Flush();
+	journal->Flush();
+	CHECK(fs::exists(save_path));
+	const auto segments = serialization::Journal::FindSegments(save_path);
+	REQUIRE(segments.size() == 1);
+	CHECK(segments.front().first == first_segment + 1);
+
+	// Сохранение при остановке сервера оставляет только пустой журнал
+	game.SetSavePeriod(0);
+	fixtures::Tick(game, TICK_MS);
+	SerializeSessions(game);
+	CHECK(serialization::Journal::FindSegments(save_path).empty());
+
+	model::Game restarted;
+	fixtures::SetupSmallGame(restarted, save_path);
+	DeserializeSessions(restarted);
+	CHECK(restarted.GetNumPlayersInAllSessions() == 10);
+}
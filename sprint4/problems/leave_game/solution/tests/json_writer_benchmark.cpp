@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <boost/json.hpp>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/json_serializer.h"
+#include "../src/json_writer.h"
+#include "allocation_counter.h"
+#include "test_fixtures.h"
+
+namespace json = boost::json;
+
+namespace {
+
+// дробные скорость и координаты трофеев проверяют запись чисел
+constexpr fixtures::Grid GRID{10, 20};
+
+// Прежняя сериализация состояния через дерево boost::json
+std::string GetPlayersDogInfoDom(const std::vector<std::shared_ptr<model::Player>>& players, const std::vector<model::LootInfo>& loots){
+	json::object players_object;
+	for(auto& player : players){
+		auto dog = player->GetDog();
+		auto pos = dog->GetPosition();
+		auto speed = dog->GetSpeed();
+
+		json::array bag_ar;
+		for(const auto& cur_loot: dog->GetGatheredLoot()){
+			bag_ar.emplace_back(json::object{{"id", cur_loot.id}, {"type", cur_loot.type}});
+		}
+
+		json::object dog_object;
+		dog_object["pos"] = json::array{pos.x, pos.y};
+		dog_object["speed"] = json::array{speed.vx, speed.vy};
+		dog_object["dir"] = model::ConvertDogDirectionToString(dog->GetDirection());
+		dog_object["bag"] = std::move(bag_ar);
+		dog_object["score"] = dog->GetScore();
+		players_object[std::to_string(player->GetId())] = std::move(dog_object);
+	}
+
+	json::object loots_object;
+	for(size_t i = 0; i < loots.size(); ++i){
+		json::object loot_object;
+		loot_object["pos"] = json::array{loots[i].x, loots[i].y};
+		loot_object["type"] = loots[i].type;
+		loots_object[std::to_string(i)] = std::move(loot_object);
+	}
+
+	json::object resp_object;
+	resp_object["players"] = std::move(players_object);
+	resp_object["lostObjects"] = std::move(loots_object);
+	return json::serialize(resp_object);
+}
+
+}
+
+TEST_CASE("Game state serialization: streaming writer vs DOM", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID, 3.3);
+	model::GameSession session("grid", 5.0, 0.5);
+
+	for(size_t i = 0; i < 100; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+
+	// Координаты собак становятся дробными, как во время игры
+	for(const auto& player : session.GetPlayers()){
+		auto dog = player->GetDog();
+		const auto& road = map.GetRoads()[dog->GetPositionOnMap().current_road_index];
+		dog->SetSpeed(road.IsHorizontal() ? model::DogDirection::EAST : model::DogDirection::SOUTH, map.GetDogSpeed());
+	}
+	session.MoveDogs(137);
+
+	const auto loots = fixtures::MakeLoots(GRID, 200, 0.25);
+	const auto& players = session.GetPlayers();
+
+	const std::string dom = GetPlayersDogInfoDom(players, loots);
+	const std::string streamed = json_serializer::GetPlayersDogInfoResponce(players, loots);
+	CHECK(json::parse(streamed) == json::parse(dom));
+
+	std::string buffer;
+	buffer.reserve(streamed.size());
+	const size_t dom_allocations = allocation_counter::CountAllocations([&]{ GetPlayersDogInfoDom(players, loots); });
+	const size_t writer_allocations = allocation_counter::CountAllocations([&]{ json_serializer::GetPlayersDogInfoResponce(players, loots); });
+	const size_t reused_allocations = allocation_counter::CountAllocations([&]{
+		buffer.clear();
+		json_serializer::WritePlayersDogInfo(buffer, players, loots);
+	});
+	WARN("allocations per response: DOM " << dom_allocations << ", writer " << writer_allocations
+		 << ", writer with reused buffer " << reused_allocations);
+	CHECK(writer_allocations < dom_allocations);
+	CHECK(reused_allocations == 0);
+
+	BENCHMARK("DOM, bytes: " + std::to_string(dom.size())) {
+		return GetPlayersDogInfoDom(players, loots);
+	};
+
+	BENCHMARK("JsonWriter, bytes: " + std::to_string(streamed.size())) {
+		return json_serializer::GetPlayersDogInfoResponce(players, loots);
+	};
+
+	BENCHMARK("JsonWriter with reused buffer, bytes: " + std::to_string(streamed.size())) {
+		buffer.clear();
+		json_serializer::WritePlayersDogInfo(buffer, players, loots);
+		return buffer.size();
+	};
+}
+
+TEST_CASE("JsonWriter escapes strings and formats numbers", "[benchmark]") {
+	std::string out;
+	json_serializer::JsonWriter writer(out);
+
+	writer.StartObject()
+		  .Member("name", "a\"b\\c\n\x01")
+		  .Member("int", -5)
+		  .Member("real", 10.0)
+		  .Member("frac", 0.1)
+		  .Key("list").StartArray().Value(true).Value(2u).StartObject().EndObject().EndArray()
+		  .EndObject();
+
+	CHECK(out == R"({"name":"a\"b\\c\n\u0001","int":-5,"real":10.0,"frac":0.1,"list":[true,2,{}]})");
+}
@@ -0,0 +1,47 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "test_fixtures.h"
+
+namespace {
+
+constexpr fixtures::Grid GRID{50, 20};
+
+}
+
+TEST_CASE("MoveDogs tick with 10k loot items and 1k dogs", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID, 3.0, 5);
+	model::GameSession session("grid", 5.0, 0.5);
+	session.SetLootsInfo(fixtures::MakeCrossingLoots(GRID, 10000));
+
+	for(size_t i = 0; i < 1000; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+
+	// Собаки бегут вдоль своих дорог, чтобы не останавливаться на краях
+	auto run_dogs = [&map, &session](bool forward){
+		for(const auto& player : session.GetPlayers()){
+			auto dog = player->GetDog();
+			const auto& road = map.GetRoads()[dog->GetPositionOnMap().current_road_index];
+			if(road.IsHorizontal()){
+				dog->SetSpeed(forward ? model::DogDirection::EAST : model::DogDirection::WEST, map.GetDogSpeed());
+			}else{
+				dog->SetSpeed(forward ? model::DogDirection::SOUTH : model::DogDirection::NORTH, map.GetDogSpeed());
+			}
+		}
+	};
+
+	bool forward = true;
+	BENCHMARK_ADVANCED("MoveDogs, 100 ms")(Catch::Benchmark::Chronometer meter) {
+		run_dogs(forward);
+		forward = !forward;
+		meter.measure([&session] {
+			session.MoveDogs(100);
+			return session.GetLootsInfo().size();
+		});
+	};
+
+	CHECK(session.GetLootsInfo().size() < 10000);
+}
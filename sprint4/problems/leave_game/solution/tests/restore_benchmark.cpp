@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/state_archive.h"
+#include "state_comparison.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using state_comparison::SameStates;
+
+constexpr size_t SESSIONS = 10;
+constexpr size_t DOGS_PER_SESSION = 5000;
+constexpr size_t ROADS = 40;
+
+model::Map MakeMap(const std::string& id){
+	model::Map map(model::Map::Id(id), "Map");
+	for(int i = 0; i < static_cast<int>(ROADS / 2); ++i){
+		map.AddRoad(model::Road(model::Road::HORIZONTAL, model::Point(0, i * 10), 200));
+		map.AddRoad(model::Road(model::Road::VERTICAL, model::Point(i * 10, 0), 200));
+	}
+	map.AddLoot(model::Loot("key", "key.obj", "obj", 0, "", 1.0, 10));
+	map.SetBagCapacity(3);
+	return map;
+}
+
+void SetupGame(model::Game& game, const fs::path& save_path){
+	std::vector<model::Map> maps;
+	for(size_t s = 0; s < SESSIONS; ++s){
+		maps.push_back(MakeMap(fixtures::GetMapId(s)));
+	}
+	fixtures::SetupSavedGame(game, std::move(maps), save_path);
+	game.SetSpawnInRandomPoint(true);
+}
+
+// Прежний путь восстановления: вход каждого игрока через AddPlayer с поиском по имени,
+// новым токеном и точкой появления, затем перезапись сохранённым состоянием.
+// Токены не индексируются, так что он здесь даже быстрее, чем был
+void RestoreByJoining(model::Game& game, const model::GameSessionsStates& states){
+	for(const auto& state : states.states){
+		auto session = game.AcquireSession(state.map_id_, "restore");
+		session->SetPlayerId(state.player_id_);
+		session->SetLootsInfo(state.loots_info_state);
+		auto* map = const_cast<model::Map*>(game.FindMap(model::Map::Id(state.map_id_)));
+		for(const auto& pl_state : state.player_state_){
+			auto player = session->AddPlayer(pl_state.name_, map, true, 3);
+			player->SetToken(pl_state.token_);
+			player->SetId(pl_state.id_);
+			auto dog = player->GetDog();
+			dog->SetDirection(pl_state.dog_direction_);
+			dog->SetPositionOnMap(pl_state.dog_position_);
+			dog->SetGatheredLoot(pl_state.gathered_loots_);
+			dog->SetBagCapacity(pl_state.bag_capacity_);
+			dog->SetScore(pl_state.score_);
+			dog->SetPlayTime(pl_state.play_time_);
+		}
+		session->EndJoin();
+	}
+}
+
+}
+
+TEST_CASE("Startup with 50k saved dogs: text archive and join path vs mapped binary file and direct restore", "[benchmark]") {
+	fixtures::TempDir dir("restore_benchmark");
+	const fs::path text_path = dir.GetPath() / "state.txt";
+	const fs::path binary_path = dir.GetPath() / "state.bin";
+
+	const auto states = fixtures::MakeSavedStates({.sessions = SESSIONS, .dogs_per_session = DOGS_PER_SESSION, .bag_size = 1});
+	SerializeSessions(states, text_path);
+	SerializeSessions(states, binary_path);
+
+	model::Game old_game;
+	SetupGame(old_game, text_path);
+	model::GameSessionsStates loaded;
+	const auto old_load = fixtures::Measure([&]{ loaded = LoadSessions(serialization::ReadFile(text_path)); });
+	const auto old_restore = fixtures::Measure([&]{ RestoreByJoining(old_game, loaded); });
+
+	model::Game game;
+	SetupGame(game, binary_path);
+	const auto new_startup = fixtures::Measure([&]{ DeserializeSessions(game); });
+	model::Game restored;
+	SetupGame(restored, binary_path);
+	const auto new_restore = fixtures::Measure([&]{ restored.RestoreSessions(states); });
+
+	WARN(SESSIONS * DOGS_PER_SESSION << " dogs in " << SESSIONS << " sessions: text load " << old_load.count()
+		 << " ms + join path " << old_restore.count() << " ms; mapped binary startup " << new_startup.count()
+		 << " ms, direct restore alone " << new_restore.count() << " ms");
+	CHECK(old_game.GetNumPlayersInAllSessions() == SESSIONS * DOGS_PER_SESSION);
+	CHECK(game.GetNumPlayersInAllSessions() == SESSIONS * DOGS_PER_SESSION);
+	CHECK(SameStates(*game.GetGameSessionsStates(), states));
+	CHECK(SameStates(*restored.GetGameSessionsStates(), states));
+	CHECK(fs::file_size(binary_path) < fs::file_size(text_path));
+
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/server_exceptions.h"
+#include "state_comparison.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using state_comparison::SameStates;
+
+// Игроков в первой сессии: новый игрок получает следующий id
+constexpr size_t DOGS_PER_SESSION = 100;
+
+}
+
+TEST_CASE("Restored players keep their tokens, ids and dogs", "[persistence]") {
+	fixtures::TempDir dir("restore_test");
+	const fs::path save_path = dir.GetPath() / "state.bin";
+
+	auto states = fixtures::MakeSavedStates({.sessions = 2, .dogs_per_session = DOGS_PER_SESSION, .bag_size = 1});
+	states.states.back().player_state_.resize(10);
+	SerializeSessions(states, save_path);
+
+	model::Game game;
+	fixtures::SetupSavedGame(game, {fixtures::MakeSmallMap(fixtures::GetMapId(0)), fixtures::MakeSmallMap(fixtures::GetMapId(1))},
+							 save_path);
+	DeserializeSessions(game);
+
+	CHECK(game.GetNumPlayersInAllSessions() == DOGS_PER_SESSION + 10);
+	CHECK(SameStates(*game.GetGameSessionsStates(), states));
+	const auto& saved = states.states.back().player_state_.back();
+	auto handle = game.FindPlayerByToken(saved.token_);
+	REQUIRE(handle);
+	CHECK(handle->player->GetId() == saved.id_);
+
+	// новый игрок получает следующий id сессии, а не id после пересоздания всех игроков
+	const auto [token, id] = game.AddPlayer(fixtures::GetMapId(1), "late");
+	CHECK(id == DOGS_PER_SESSION);
+	CHECK(game.FindPlayerByToken(token));
+
+	// сохранение для неизвестной карты не восстанавливается молча
+	model::Game other;
+	other.AddMap(fixtures::MakeSmallMap("other"));
+	CHECK_THROWS_AS(other.RestoreSessions(states), MapNotFoundException);
+}
@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/retired_writer.h"
+#include "fake_repository.h"
+#include "test_fixtures.h"
+
+namespace {
+
+using namespace std::literals;
+using fixtures::FakeRepository;
+using fixtures::MakeRecords;
+
+}
+
+TEST_CASE("Tick stall of retiring 1000 dogs: transaction per player vs background writer", "[benchmark]") {
+	constexpr size_t DOGS = 1000;
+	// задержка одной транзакции с локальной базой
+	constexpr auto ROUND_TRIP = 200us;
+
+	FakeRepository repository(ROUND_TRIP);
+	auto writer = std::make_shared<postgres::RetiredWriter>(repository.GetSaver());
+
+	model::Game game;
+	game.AddMap(fixtures::MakeSmallMap());
+	game.SetDefaultBagCapacity(3);
+	game.SetDogRetirementTime(0.5);
+	game.SetRetiredWriter(writer);
+	for(size_t i = 0; i < DOGS; ++i){
+		game.AddPlayer("map", "dog" + std::to_string(i));
+	}
+
+	// все собаки стоят и за тик уходят на пенсию
+	std::chrono::microseconds stall{};
+	size_t retired = 0;
+	game.TickSessions(1000, [&](std::shared_ptr<model::TickResult> result){
+		for(const auto& [session, players] : result->retired_players){
+			retired += players.size();
+		}
+		stall = fixtures::Measure<std::chrono::microseconds>([&]{ game.FinishTick(*result); });
+	});
+	REQUIRE(retired == DOGS);
+	CHECK(game.GetNumPlayersInAllSessions() == 0);
+
+	// прежний путь: отдельная транзакция на каждого игрока прямо в тике
+	FakeRepository sync_repository(ROUND_TRIP);
+	const auto records = MakeRecords(0, DOGS);
+	const auto sync_stall = fixtures::Measure<std::chrono::microseconds>([&]{
+		for(const auto& record : records){
+			sync_repository.SaveRetired({record});
+		}
+	});
+
+	writer->Flush();
+	const auto ids = repository.GetSaved();
+	WARN(DOGS << " retired dogs, " << ROUND_TRIP.count() << " us per transaction: tick stall "
+		 << sync_stall.count() << " us with a transaction per player, " << stall.count()
+		 << " us with the background writer (" << repository.GetBatches().size() << " transactions)");
+	CHECK(ids.size() == DOGS);
+	CHECK(std::set<std::string>(ids.begin(), ids.end()).size() == DOGS);
+	CHECK(sync_repository.GetBatches().size() == DOGS);
+	CHECK(repository.GetBatches().size() * 10 < DOGS);
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/retired_writer.h"
+#include "fake_repository.h"
+
+namespace {
+
+using namespace std::literals;
+using Clock = std::chrono::steady_clock;
+using fixtures::FakeRepository;
+using fixtures::MakeIds;
+using fixtures::MakeRecords;
+
+}
+
+TEST_CASE("Retired writer batches records of many ticks into few transactions", "[persistence]") {
+	FakeRepository repository(2ms);
+	postgres::RetiredWriter writer(repository.GetSaver(), {}, {.max_batch = 64});
+
+	// по пять игроков за тик, пока прошлая транзакция ещё идёт
+	constexpr size_t TICKS = 200;
+	for(size_t tick = 0; tick < TICKS; ++tick){
+		writer.Enqueue(MakeRecords(tick * 5, 5));
+	}
+	writer.Flush();
+
+	const auto batches = repository.GetBatches();
+	WARN(TICKS * 5 << " records from " << TICKS << " ticks saved in " << batches.size() << " transactions");
+	CHECK(repository.GetSaved() == MakeIds(TICKS * 5));
+	CHECK(writer.GetSavedRecords() == TICKS * 5);
+	CHECK(writer.GetSavedBatches() == batches.size());
+	CHECK(batches.size() < TICKS / 4);
+	CHECK(*std::max_element(batches.begin(), batches.end()) <= 64);
+	CHECK(writer.GetQueueSize() == 0);
+}
+
+TEST_CASE("Retired writer retries a failed transaction without losing or reordering records", "[persistence]") {
+	FakeRepository repository(0us, 3);
+	std::vector<std::string> errors;
+	postgres::RetiredWriter writer(repository.GetSaver(), [&errors](const std::exception& ex){ errors.push_back(ex.what()); },
+								   {.min_retry_delay = 1ms, .max_retry_delay = 4ms});
+
+	writer.Enqueue(MakeRecords(0, 10));
+	writer.Enqueue(MakeRecords(10, 10));
+	writer.Flush();
+
+	CHECK(writer.GetFailedBatches() == 3);
+	CHECK(errors.size() == 3);
+	CHECK(errors.front() == "connection lost");
+	CHECK(repository.GetSaved() == MakeIds(20));
+	CHECK(writer.GetDroppedRecords() == 0);
+}
+
+TEST_CASE("Retired writer applies backpressure when the database stalls", "[persistence]") {
+	FakeRepository repository;
+	repository.SetOpen(false);
+	constexpr size_t CAPACITY = 10;
+	postgres::RetiredWriter writer(repository.GetSaver(), {}, {.max_batch = 4, .capacity = CAPACITY});
+
+	constexpr size_t RECORDS = 40;
+	std::jthread producer([&writer]{
+		for(size_t i = 0; i < RECORDS; ++i){
+			writer.Enqueue(MakeRecords(i, 1));
+		}
+	});
+
+	// одна пачка висит в транзакции, остальное упирается в очередь
+	const auto deadline = Clock::now() + 5s;
+	while(writer.GetBlockedEnqueues() == 0 && Clock::now() < deadline){
+		std::this_thread::sleep_for(1ms);
+	}
+	CHECK(writer.GetBlockedEnqueues() > 0);
+	CHECK(writer.GetQueueSize() <= CAPACITY);
+
+	repository.SetOpen(true);
+	producer.join();
+	writer.Flush();
+	CHECK(repository.GetSaved() == MakeIds(RECORDS));
+}
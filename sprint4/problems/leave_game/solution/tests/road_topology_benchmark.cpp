@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <random>
+#include <string>
+#include "../src/model.h"
+#include "../src/road_topology.h"
+#include "../src/game_session.h"
+
+namespace {
+
+// Сетка из коротких отрезков: около 10 тысяч дорог, у каждой не больше шести соседей
+constexpr int GRID_CELLS = 70;
+constexpr int ROAD_STEP = 10;
+
+std::vector<model::Road> MakeGridRoads(){
+	std::vector<model::Road> roads;
+
+	for(int i = 0; i <= GRID_CELLS; ++i){
+		for(int j = 0; j < GRID_CELLS; ++j){
+			roads.emplace_back(model::Road::HORIZONTAL, model::Point(j * ROAD_STEP, i * ROAD_STEP), (j + 1) * ROAD_STEP);
+			roads.emplace_back(model::Road::VERTICAL, model::Point(i * ROAD_STEP, j * ROAD_STEP), (j + 1) * ROAD_STEP);
+		}
+	}
+
+	return roads;
+}
+
+model::Map MakeGridMap(){
+	model::Map map(model::Map::Id("grid"), "Grid");
+	for(const auto& road : MakeGridRoads()){
+		map.AddRoad(road);
+	}
+	map.SetDogSpeed(4.0);
+	map.BuildRoadTopology();
+	return map;
+}
+
+// Одна команда записанной траектории: собака dog меняет направление и движется delta мс
+struct TraceStep{
+	size_t dog{};
+	model::DogDirection direction{};
+	int delta{};
+};
+
+std::vector<TraceStep> RecordTrace(size_t dogs_count, size_t steps_count){
+	std::mt19937 rng(2024);
+	constexpr model::DogDirection directions[] = {model::DogDirection::NORTH, model::DogDirection::SOUTH,
+												  model::DogDirection::WEST, model::DogDirection::EAST};
+	std::vector<TraceStep> trace;
+	trace.reserve(steps_count);
+
+	for(size_t i = 0; i < steps_count; ++i){
+		trace.push_back({i % dogs_count, directions[rng() % 4], static_cast<int>(50 + rng() % 250)});
+	}
+
+	return trace;
+}
+
+}
+
+TEST_CASE("Road topology of a 10k-road grid map", "[benchmark]") {
+	const auto roads = MakeGridRoads();
+
+	BENCHMARK("Build topology, roads: " + std::to_string(roads.size())) {
+		return model::RoadTopology(roads).GetNumRoads();
+	};
+
+	model::Map map = MakeGridMap();
+	model::GameSession session("grid", 5.0, 0.5);
+	BENCHMARK("Join player, roads: " + std::to_string(roads.size())) {
+		return session.AddPlayer("dog", &map, true, 3);
+	};
+}
+
+TEST_CASE("Replay a movement trace on a 10k-road grid map", "[benchmark]") {
+	constexpr size_t DOGS_COUNT = 100;
+	constexpr size_t STEPS_COUNT = 100000;
+
+	model::Map map = MakeGridMap();
+	model::GameSession session("grid", 5.0, 0.5);
+	std::vector<std::shared_ptr<model::Dog>> dogs;
+	std::vector<model::DogPos> start_positions;
+
+	for(size_t i = 0; i < DOGS_COUNT; ++i){
+		auto dog = session.AddPlayer("dog" + std::to_string(i), &map, true, 3)->GetDog();
+		start_positions.push_back(dog->GetPositionOnMap());
+		dogs.push_back(dog);
+	}
+
+	const auto trace = RecordTrace(DOGS_COUNT, STEPS_COUNT);
+
+	auto replay = [&]{
+		size_t roads_changed = 0;
+		for(const auto& step : trace){
+			auto& dog = *dogs[step.dog];
+			const size_t road_index = dog.GetPositionOnMap().current_road_index;
+			dog.SetSpeed(step.direction, map.GetDogSpeed());
+			dog.Move(step.delta);
+			roads_changed += (dog.GetPositionOnMap().current_road_index != road_index);
+		}
+		return roads_changed;
+	};
+
+	auto reset = [&]{
+		for(size_t i = 0; i < DOGS_COUNT; ++i){
+			dogs[i]->SetPositionOnMap(start_positions[i]);
+		}
+	};
+
+	// Собаки должны действительно переходить с дороги на дорогу
+	CHECK(replay() > 0);
+
+	BENCHMARK_ADVANCED("Replay trace, steps: " + std::to_string(STEPS_COUNT))(Catch::Benchmark::Chronometer meter) {
+		reset();
+		meter.measure(replay);
+	};
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "../src/api_routes.h"
+#include "allocation_counter.h"
+
+using namespace std::literals;
+
+namespace {
+
+const std::vector<std::string_view> TARGETS{
+	"/api/v1/game/state"sv,
+	"/api/v1/game/player/action"sv,
+	"/api/v1/game/records?start=10&maxItems=50"sv,
+	"/api/v1/maps/map1"sv,
+	"/index.html"sv,
+};
+
+// Прежняя маршрутизация: копия цели запроса, множество маршрутов на каждый вызов и словарь параметров
+int RouteWithStrings(std::string_view target){
+	std::string request = {target.begin(), target.end()};
+	std::string path = request.substr(0, request.rfind('?'));
+
+	std::set<std::string> endpoints{"/api/v1/game/join", "/api/v1/game/players", "/api/v1/game/state",
+									"/api/v1/game/player/action", "/api/v1/game/tick", "/api/v1/game/records"};
+	if(endpoints.find(path) == endpoints.end()){
+		return -1;
+	}
+
+	std::map<std::string, std::string> params;
+	if(auto pos = request.find('?'); pos != std::string::npos){
+		std::string query = request.substr(pos + 1);
+		size_t start = 0;
+		while(start < query.size()){
+			auto end = query.find('&', start);
+			std::string param = query.substr(start, end - start);
+			auto eq = param.find('=');
+			params[param.substr(0, eq)] = (eq == std::string::npos) ? "" : param.substr(eq + 1);
+			start = (end == std::string::npos) ? query.size() : end + 1;
+		}
+	}
+	return static_cast<int>(params.size());
+}
+
+int RouteWithTable(std::string_view target){
+	if(!http_handler::FindApiRoute(target)){
+		return -1;
+	}
+	return static_cast<int>(http_handler::QueryParams(target).GetSize());
+}
+
+}
+
+TEST_CASE("Route table matches API targets", "[benchmark]") {
+	using http_handler::ApiRoute;
+	CHECK(http_handler::FindApiRoute("/api/v1/game/join"sv) == ApiRoute::JOIN);
+	CHECK(http_handler::FindApiRoute("/api/v1/game/state?x=1"sv) == ApiRoute::STATE);
+	CHECK(!http_handler::FindApiRoute("/api/v1/game/state/"sv));
+	CHECK(!http_handler::FindApiRoute("/api/v1/maps"sv));
+
+	const http_handler::QueryParams params("/api/v1/game/records?start=10&&maxItems=50&flag"sv);
+	CHECK(params.GetSize() == 3);
+	CHECK(params.Find("start"sv) == "10"sv);
+	CHECK(params.Find("maxItems"sv) == "50"sv);
+	CHECK(params.Find("flag"sv) == ""sv);
+	CHECK(!params.Find("missing"sv));
+
+	for(auto target : TARGETS){
+		CHECK(RouteWithTable(target) == RouteWithStrings(target));
+	}
+}
+
+TEST_CASE("Routing: string copies vs string_view table", "[benchmark]") {
+	const size_t string_allocations = allocation_counter::CountAllocations([]{
+		for(auto target : TARGETS){
+			RouteWithStrings(target);
+		}
+	});
+	const size_t table_allocations = allocation_counter::CountAllocations([]{
+		for(auto target : TARGETS){
+			RouteWithTable(target);
+		}
+	});
+	WARN("allocations for " << TARGETS.size() << " targets: strings " << string_allocations << ", table " << table_allocations);
+	CHECK(table_allocations == 0);
+
+	BENCHMARK("std::set and std::map per request") {
+		int sum = 0;
+		for(auto target : TARGETS){
+			sum += RouteWithStrings(target);
+		}
+		return sum;
+	};
+
+	BENCHMARK("constexpr route table") {
+		int sum = 0;
+		for(auto target : TARGETS){
+			sum += RouteWithTable(target);
+		}
+		return sum;
+	};
+}
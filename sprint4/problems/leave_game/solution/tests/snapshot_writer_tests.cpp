@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/snapshot_writer.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+}
+
+TEST_CASE("Snapshot writer replaces the save file in the background", "[persistence]") {
+	fixtures::TempDir dir("snapshot_writer_test");
+	const fs::path save_path = dir.GetPath() / "state.arch";
+	model::Game game;
+	fixtures::SetupSavedGame(game, {fixtures::MakeSmallMap()}, save_path);
+	for(int i = 0; i < 10; ++i){
+		game.AddPlayer("map", "dog" + std::to_string(i));
+	}
+
+	std::string last_error;
+	serialization::SnapshotWriter writer(save_path, GetSessionsEncoder(save_path),
+										 [&last_error](const std::exception& ex){ last_error = ex.what(); });
+
+	writer.Submit(game.GetGameSessionsStates());
+	writer.Flush();
+	CHECK(writer.GetWrittenSnapshots() == 1);
+	CHECK(fs::exists(save_path));
+	CHECK(!fs::exists(dir.GetPath() / "state.arch.tmp"));
+
+	auto states = LoadSessions(serialization::ReadFile(save_path));
+	REQUIRE(states.states.size() == 1);
+	CHECK(states.states.front().player_state_.size() == 10);
+
+	// Пока диск занят, новые снимки заменяют ожидающий, и записан будет последний
+	constexpr size_t SUBMITS = 20;
+	for(size_t i = 0; i < SUBMITS; ++i){
+		game.AddPlayer("map", "late" + std::to_string(i));
+		writer.Submit(game.GetGameSessionsStates());
+	}
+	writer.Flush();
+	CHECK(writer.GetWrittenSnapshots() + writer.GetReplacedSnapshots() == SUBMITS + 1);
+	CHECK(LoadSessions(serialization::ReadFile(save_path)).states.front().player_state_.size() == 10 + SUBMITS);
+
+	// Ошибка записи не трогает прошлое сохранение
+	serialization::SnapshotWriter broken(dir.GetPath() / "missing" / "state.arch", GetSessionsEncoder(save_path),
+										 [&last_error](const std::exception& ex){ last_error = ex.what(); });
+	broken.Submit(game.GetGameSessionsStates());
+	broken.Flush();
+	CHECK(broken.GetFailedWrites() == 1);
+	CHECK(!last_error.empty());
+	CHECK(writer.GetFailedWrites() == 0);
+}
@@ -0,0 +1,41 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/state_archive.h"
+#include "state_comparison.h"
+#include "test_fixtures.h"
+
+namespace {
+
+using state_comparison::SameStates;
+
+constexpr size_t SESSIONS = 10;
+constexpr size_t DOGS_PER_SESSION = 10000;
+constexpr size_t BAG_SIZE = 3;
+constexpr size_t LOOTS_PER_SESSION = 1000;
+
+}
+
+TEST_CASE("Save and restore 100k dogs: text archive vs binary state file", "[benchmark]") {
+	const auto states = fixtures::MakeSavedStates({.sessions = SESSIONS, .dogs_per_session = DOGS_PER_SESSION,
+													.bag_size = BAG_SIZE, .loots_per_session = LOOTS_PER_SESSION});
+
+	std::string text, binary;
+	const auto text_save = fixtures::Measure([&]{ text = EncodeSessions(states, serialization::SaveFormat::TEXT); });
+	const auto binary_save = fixtures::Measure([&]{ binary = serialization::EncodeBinaryArchive(states); });
+
+	model::GameSessionsStates from_text, from_binary;
+	const auto text_load = fixtures::Measure([&]{ from_text = LoadSessions(text); });
+	const auto binary_load = fixtures::Measure([&]{ from_binary = LoadSessions(binary); });
+
+	CHECK(SameStates(from_binary, states));
+	CHECK(from_text.states.size() == SESSIONS);
+
+	WARN(SESSIONS * DOGS_PER_SESSION << " dogs with " << BAG_SIZE << " items in bag: text archive "
+		 << text.size() / 1024 << " KiB, save " << text_save.count() << " ms, restore " << text_load.count() << " ms; "
+		 << "binary " << binary.size() / 1024 << " KiB, save " << binary_save.count() << " ms, restore " << binary_load.count() << " ms");
+	CHECK(binary.size() < text.size());
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/model_serialization.h"
+#include "../src/state_archive.h"
+#include "state_comparison.h"
+#include "test_fixtures.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+using state_comparison::SameStates;
+
+}
+
+TEST_CASE("Binary state file detects corruption and unknown versions", "[persistence]") {
+	const auto states = fixtures::MakeSavedStates({.sessions = 3});
+	const std::string data = serialization::EncodeBinaryArchive(states);
+	REQUIRE(serialization::IsBinaryArchive(data));
+	CHECK(SameStates(serialization::DecodeBinaryArchive(data), states));
+
+	// Испорченный байт в любой сессии ловится её контрольной суммой
+	std::string corrupted = data;
+	corrupted[data.size() - 20] ^= 0x01;
+	CHECK_THROWS_AS(serialization::DecodeBinaryArchive(corrupted), std::runtime_error);
+
+	CHECK_THROWS_AS(serialization::DecodeBinaryArchive(std::string_view(data).substr(0, data.size() - 1)), std::runtime_error);
+	CHECK_THROWS_AS(serialization::DecodeBinaryArchive(data + "x"), std::runtime_error);
+
+	std::string newer = data;
+	newer[serialization::BINARY_ARCHIVE_MAGIC.size()] = static_cast<char>(serialization::BINARY_ARCHIVE_VERSION + 1);
+	CHECK_THROWS_AS(serialization::DecodeBinaryArchive(newer), std::runtime_error);
+
+	// Формат сохранения выбирается именем файла
+	CHECK(serialization::GetSaveFormat("state.txt") == serialization::SaveFormat::TEXT);
+	CHECK(serialization::GetSaveFormat("state.bin") == serialization::SaveFormat::BINARY);
+	CHECK(serialization::GetSaveFormat("state") == serialization::SaveFormat::BINARY);
+}
+
+TEST_CASE("Text save is read and upgraded to the binary format at startup", "[persistence]") {
+	fixtures::TempDir dir("state_archive_upgrade_test");
+	const fs::path save_path = dir.GetPath() / "state.bin";
+
+	const auto old_states = fixtures::MakeSavedStates({});
+	// файл прежнего формата под новым именем
+	serialization::WriteFileAtomically(save_path, EncodeSessions(old_states, serialization::SaveFormat::TEXT));
+
+	model::Game game;
+	fixtures::SetupSavedGame(game, {fixtures::MakeSmallMap(fixtures::GetMapId(0))}, save_path);
+	DeserializeSessions(game);
+
+	CHECK(game.GetNumPlayersInAllSessions() == 10);
+	const std::string data = serialization::ReadFile(save_path);
+	REQUIRE(serialization::IsBinaryArchive(data));
+	CHECK(SameStates(serialization::DecodeBinaryArchive(data), old_states));
+	CHECK(game.FindPlayerByToken(old_states.states.front().player_state_.back().token_));
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+
+// Сравнение сохранённых состояний: координаты сравниваются точно, до бита
+namespace state_comparison {
+
+// Поля игрока, которые сохраняются не при любом способе записи
+struct PlayerFields {
+	bool play_time{true};
+};
+
+inline bool SameLoot(const model::LootInfo& lhs, const model::LootInfo& rhs){
+	return lhs.id == rhs.id && lhs.type == rhs.type && lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+inline bool SameLoots(const std::vector<model::LootInfo>& lhs, const std::vector<model::LootInfo>& rhs){
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), SameLoot);
+}
+
+inline bool SamePlayer(const model::PlayerState& lhs, const model::PlayerState& rhs, PlayerFields fields = {}){
+	const auto& lpos = lhs.dog_position_;
+	const auto& rpos = rhs.dog_position_;
+	return lhs.name_ == rhs.name_ && lhs.token_ == rhs.token_ && lhs.id_ == rhs.id_
+		&& lhs.dog_direction_ == rhs.dog_direction_
+		&& lpos.current_road_index == rpos.current_road_index
+		&& lpos.curr_position.x == rpos.curr_position.x && lpos.curr_position.y == rpos.curr_position.y
+		&& lpos.curr_speed.vx == rpos.curr_speed.vx && lpos.curr_speed.vy == rpos.curr_speed.vy
+		&& SameLoots(lhs.gathered_loots_, rhs.gathered_loots_)
+		&& lhs.bag_capacity_ == rhs.bag_capacity_ && lhs.score_ == rhs.score_
+		&& (!fields.play_time || lhs.play_time_ == rhs.play_time_);
+}
+
+inline bool SameStates(const model::GameSessionsStates& lhs, const model::GameSessionsStates& rhs, PlayerFields fields = {}){
+	return std::equal(lhs.states.begin(), lhs.states.end(), rhs.states.begin(), rhs.states.end(),
+					  [fields](const model::GameSessionState& l, const model::GameSessionState& r){
+		return l.map_id_ == r.map_id_ && l.player_id_ == r.player_id_
+			&& SameLoots(l.loots_info_state, r.loots_info_state)
+			&& std::equal(l.player_state_.begin(), l.player_state_.end(), r.player_state_.begin(), r.player_state_.end(),
+						  [fields](const model::PlayerState& lp, const model::PlayerState& rp){ return SamePlayer(lp, rp, fields); });
+	});
+}
+
+}  // namespace state_comparison
@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/json_serializer.h"
+#include "test_fixtures.h"
+
+namespace {
+
+constexpr fixtures::Grid GRID{20, 20};
+constexpr size_t DOGS = 1000;
+constexpr size_t LOOTS = 500;
+
+// Каждая moving_every-я собака идёт по своей дороге, остальные стоят
+size_t StartDogs(model::GameSession& session, const model::Map& map, size_t moving_every){
+	size_t moving = 0;
+	for(size_t i = 0; i < session.GetPlayers().size(); i += moving_every){
+		auto dog = session.GetPlayers()[i]->GetDog();
+		const auto& road = map.GetRoads()[dog->GetPositionOnMap().current_road_index];
+		dog->SetSpeed(road.IsHorizontal() ? model::DogDirection::EAST : model::DogDirection::SOUTH, map.GetDogSpeed());
+		++moving;
+	}
+	return moving;
+}
+
+}
+
+TEST_CASE("State delta contains only entities changed since the base tick", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID);
+	model::GameSession session("grid", 5.0, 0.5);
+	for(size_t i = 0; i < 10; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+	session.SetLootsInfo(fixtures::MakeLoots(GRID, LOOTS));
+	session.FinishTick();
+	const std::uint64_t base = session.GetTick();
+
+	// Новые игроки и трофеи ещё не видны клиенту с базой до их появления
+	CHECK(session.GetChangesSince(base - 1).players.size() == 10);
+	CHECK(session.GetChangesSince(base - 1).loots.size() == LOOTS);
+	CHECK(session.GetChangesSince(base).players.empty());
+
+	// Разница между тиками содержит только движущихся собак и собранные трофеи
+	const size_t moving = StartDogs(session, map, 5);
+	session.MoveDogs(1000);
+	session.FinishTick();
+
+	auto delta = session.GetChangesSince(base);
+	CHECK(!delta.full);
+	CHECK(delta.tick == base + 1);
+	CHECK(delta.players.size() == moving);
+	CHECK(delta.loots.empty());
+	CHECK(delta.removed_loots.size() == LOOTS - session.GetLootsInfo().size());
+
+	// Уход игрока попадает в разницу как удаление
+	auto retired = session.GetPlayers().back();
+	session.DeleteRetiredPlayers({retired});
+	delta = session.GetChangesSince(session.GetTick());
+	REQUIRE(delta.removed_players.size() == 1);
+	CHECK(delta.removed_players.front() == retired->GetId());
+
+	// Слишком старая или неизвестная база заменяется полным состоянием
+	for(std::uint64_t i = 0; i <= model::GameSession::MAX_DELTA_TICKS; ++i){
+		session.FinishTick();
+	}
+	delta = session.GetChangesSince(base);
+	CHECK(delta.full);
+	CHECK(delta.players.size() == session.GetPlayers().size());
+	CHECK(delta.loots.size() == session.GetLootsInfo().size());
+	CHECK(delta.removed_players.empty());
+	CHECK(session.GetChangesSince(session.GetTick() + 1).full);
+}
+
+TEST_CASE("Game state: full snapshot vs delta since the previous tick", "[benchmark]") {
+	model::Map map = fixtures::MakeGridMap(GRID);
+	model::GameSession session("grid", 5.0, 0.5);
+	for(size_t i = 0; i < DOGS; ++i){
+		session.AddPlayer("dog" + std::to_string(i), &map, true, 3);
+	}
+	session.SetLootsInfo(fixtures::MakeLoots(GRID, LOOTS));
+
+	// Двигается каждая двадцатая собака
+	StartDogs(session, map, 20);
+	session.FinishTick();
+	session.MoveDogs(100);
+	session.FinishTick();
+
+	const auto& players = session.GetPlayers();
+	const auto& loots = session.GetLootsInfo();
+	const std::uint64_t base = session.GetTick() - 1;
+
+	const std::string full = json_serializer::GetPlayersDogInfoResponce(players, loots);
+	const std::string delta = json_serializer::GetStateDeltaResponce(session.GetChangesSince(base));
+	WARN("bytes per response: full " << full.size() << ", delta " << delta.size());
+	CHECK(delta.size() * 10 < full.size());
+
+	BENCHMARK("Full state, bytes: " + std::to_string(full.size())) {
+		return json_serializer::GetPlayersDogInfoResponce(players, loots);
+	};
+
+	BENCHMARK("Delta since previous tick, bytes: " + std::to_string(delta.size())) {
+		return json_serializer::GetStateDeltaResponce(session.GetChangesSince(base));
+	};
+}
@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+#include "../src/json_serializer.h"
+#include "test_fixtures.h"
+
+namespace net = boost::asio;
+
+namespace {
+
+constexpr size_t READERS = 4;
+constexpr size_t READS_PER_READER = 2000;
+
+// Запускает читателей в отдельных потоках и возвращает число чтений в секунду
+template <typename Read>
+double MeasureReads(Read&& read){
+	std::vector<std::thread> readers;
+	const auto start = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < READERS; ++i){
+		readers.emplace_back([&read]{
+			for(size_t r = 0; r < READS_PER_READER; ++r){
+				read();
+			}
+		});
+	}
+	for(auto& reader : readers){
+		reader.join();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return READERS * READS_PER_READER / elapsed.count();
+}
+
+}
+
+TEST_CASE("Game state reads: session strand vs published snapshot", "[benchmark]") {
+	net::io_context ioc;
+	auto work = net::make_work_guard(ioc);
+	std::vector<std::thread> workers;
+	for(size_t i = 0; i < READERS; ++i){
+		workers.emplace_back([&ioc]{ ioc.run(); });
+	}
+
+	model::Map map = fixtures::MakeSmallMap();
+	auto session = std::make_shared<model::GameSession>("map", 5.0, 0.5, net::make_strand(ioc));
+	for(size_t i = 0; i < 50; ++i){
+		session->AddPlayer("dog" + std::to_string(i), &map, false, 3);
+	}
+
+	auto serialize = [&session]{
+		return std::make_shared<const std::string>(
+			json_serializer::GetPlayersDogInfoResponce(session->GetPlayers(), session->GetLootsInfo()));
+	};
+	session->SetCachedState(serialize());
+	const size_t expected_size = session->GetCachedState()->size();
+
+	// Прежний путь: каждый запрос состояния проходит через strand сессии
+	std::atomic<size_t> strand_bytes{0};
+	const double strand_rps = MeasureReads([&]{
+		std::promise<size_t> size;
+		net::post(session->GetStrand(), [&]{ size.set_value(session->GetCachedState()->size()); });
+		strand_bytes += size.get_future().get();
+	});
+
+	std::atomic<size_t> snapshot_bytes{0};
+	const double snapshot_rps = MeasureReads([&]{
+		snapshot_bytes += session->GetCachedState()->size();
+	});
+
+	CHECK(strand_bytes == READERS * READS_PER_READER * expected_size);
+	CHECK(snapshot_bytes == READERS * READS_PER_READER * expected_size);
+	WARN(READERS << " readers, state reads per second: through strand " << strand_rps
+		 << ", from snapshot " << snapshot_rps);
+
+	// Изменение сессии снимает снимок, читатели до публикации нового получают пустой указатель
+	session->MoveDogs(10);
+	CHECK(session->GetCachedState() == nullptr);
+	session->SetCachedState(serialize());
+	CHECK(session->GetCachedState() != nullptr);
+
+	work.reset();
+	for(auto& worker : workers){
+		worker.join();
+	}
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "../src/model.h"
+#include "../src/game_session.h"
+
+// Общие для тестов и бенчмарков карты, игры, трофеи, временные каталоги и замеры времени
+namespace fixtures {
+
+// Пустой временной каталог, удаляемый вместе с содержимым, даже если тест прерван REQUIRE
+class TempDir {
+public:
+	explicit TempDir(const std::string& name) : path_(std::filesystem::temp_directory_path() / name) {
+		std::filesystem::remove_all(path_);
+		std::filesystem::create_directories(path_);
+	}
+	~TempDir(){
+		std::error_code ec;
+		std::filesystem::remove_all(path_, ec);
+	}
+
+	TempDir(const TempDir&) = delete;
+	TempDir& operator=(const TempDir&) = delete;
+
+	const std::filesystem::path& GetPath() const { return path_; }
+
+private:
+	std::filesystem::path path_;
+};
+
+// Время выполнения fn
+template <typename Duration = std::chrono::milliseconds, typename Fn>
+Duration Measure(Fn&& fn){
+	const auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration_cast<Duration>(std::chrono::steady_clock::now() - start);
+}
+
+// Горизонтальная и вертикальная дороги длиной 100 из начала координат
+inline model::Map MakeSmallMap(const std::string& id = "map"){
+	model::Map map(model::Map::Id(id), "Map");
+	map.AddRoad(model::Road(model::Road::HORIZONTAL, model::Point(0, 0), 100));
+	map.AddRoad(model::Road(model::Road::VERTICAL, model::Point(0, 0), 100));
+	map.AddLoot(model::Loot("key", "key.obj", "obj", 0, "", 1.0, 10));
+	map.SetBagCapacity(3);
+	map.BuildRoadTopology();
+	return map;
+}
+
+// Игра на картах maps с рюкзаками на 3 предмета, сохраняемая в save_path
+inline void SetupSavedGame(model::Game& game, std::vector<model::Map> maps, const std::filesystem::path& save_path){
+	for(auto& map : maps){
+		game.AddMap(std::move(map));
+	}
+	game.SetDefaultBagCapacity(3);
+	game.AddSavePath(save_path);
+}
+
+// Игра на MakeSmallMap, где собака проходит единицу в секунду, а трофей появляется каждую секунду
+inline void SetupSmallGame(model::Game& game, const std::filesystem::path& save_path){
+	SetupSavedGame(game, {MakeSmallMap()}, save_path);
+	game.SetDefaultDogSpeed(1.0);
+	game.SetLootParameters(1.0, 1.0);
+}
+
+// Тик игры с завершением: сохранением, журналом и уходом на пенсию
+inline void Tick(model::Game& game, int delta_ms){
+	game.TickSessions(delta_ms, [&game](std::shared_ptr<model::TickResult> result){
+		game.FinishTick(*result);
+	});
+}
+
+inline std::string GetMapId(size_t session){
+	return "map" + std::to_string(session);
+}
+
+// Сохранённые сессии: сессия s идёт на карте GetMapId(s)
+struct SavedStates {
+	size_t sessions{1};
+	size_t dogs_per_session{10};
+	// предметов в рюкзаке вместимостью 3
+	size_t bag_size{3};
+	size_t loots_per_session{1};
+};
+
+// У игроков разные токены, дробные координаты и скорости, собаки стоят на дорогах 0 и 1
+inline model::GameSessionsStates MakeSavedStates(const SavedStates& saved){
+	model::GameSessionsStates states;
+	unsigned id = 0;
+	for(size_t s = 0; s < saved.sessions; ++s){
+		model::GameSessionState session;
+		session.map_id_ = GetMapId(s);
+		for(size_t i = 0; i < saved.dogs_per_session; ++i, ++id){
+			model::PlayerState player;
+			player.name_ = "dog" + std::to_string(id);
+			player.token_ = std::string(model::TOKEN_SIZE, "0123456789abcdef"[id % 16]);
+			const std::string suffix = std::to_string(id);
+			player.token_.replace(player.token_.size() - suffix.size(), suffix.size(), suffix);
+			player.id_ = static_cast<unsigned>(i);
+			player.dog_direction_ = static_cast<model::DogDirection>(id % 5);
+			player.dog_position_.current_road_index = id % 2;
+			player.dog_position_.curr_position = {id * 0.37, id * 0.11 + 0.3};
+			player.dog_position_.curr_speed = {(id % 3) * 1.5, 0.0};
+			for(unsigned b = 0; b < saved.bag_size; ++b){
+				player.gathered_loots_.emplace_back(id * saved.bag_size + b, b, id * 0.5, b * 0.25);
+			}
+			player.bag_capacity_ = 3;
+			player.score_ = static_cast<int>(id % 1000);
+			player.play_time_ = static_cast<int>(id * 7);
+			session.player_state_.push_back(std::move(player));
+		}
+		session.player_id_ = static_cast<unsigned>(saved.dogs_per_session);
+		for(unsigned i = 0; i < saved.loots_per_session; ++i){
+			session.loots_info_state.emplace_back(i, i % 4, i * 1.25, 0.5);
+		}
+		states.states.push_back(std::move(session));
+	}
+	return states;
+}
+
+// Сетка из roads горизонтальных и roads вертикальных дорог через step единиц
+struct Grid {
+	int roads{20};
+	int step{20};
+
+	constexpr int Size() const { return roads * step; }
+};
+
+// office_every > 0 - на каждом office_every-м перекрёстке диагонали стоит офис
+inline model::Map MakeGridMap(const Grid& grid, double dog_speed = 3.0, int office_every = 0){
+	model::Map map(model::Map::Id("grid"), "Grid");
+
+	for(int i = 0; i < grid.roads; ++i){
+		map.AddRoad(model::Road(model::Road::HORIZONTAL, model::Point(0, i * grid.step), grid.Size()));
+		map.AddRoad(model::Road(model::Road::VERTICAL, model::Point(i * grid.step, 0), grid.Size()));
+	}
+
+	for(int i = 0; (office_every > 0) && (i < grid.roads); i += office_every){
+		map.AddOffice(model::Office(model::Office::Id("o" + std::to_string(i)), model::Point(i * grid.step, i * grid.step),
+									model::Offset(0, 0)));
+	}
+
+	map.AddLoot(model::Loot("key", "key.obj", "obj", 0, "", 1.0, 10));
+	map.SetBagCapacity(3);
+	map.SetDogSpeed(dog_speed);
+	map.BuildRoadTopology();
+	return map;
+}
+
+// Трофеи лежат на горизонтальных дорогах между перекрёстками, shift - сдвиг от целой координаты
+inline std::vector<model::LootInfo> MakeLoots(const Grid& grid, size_t count, double shift = 0.5){
+	std::vector<model::LootInfo> loots;
+	loots.reserve(count);
+
+	for(size_t i = 0; i < count; ++i){
+		loots.emplace_back(i, 0, (i * 7919) % grid.Size() + shift, (i % grid.roads) * grid.step);
+	}
+
+	return loots;
+}
+
+// Трофеи поочерёдно на горизонтальных и вертикальных дорогах
+inline std::vector<model::LootInfo> MakeCrossingLoots(const Grid& grid, size_t count){
+	std::vector<model::LootInfo> loots;
+	loots.reserve(count);
+
+	for(size_t i = 0; i < count; ++i){
+		const int road = static_cast<int>(i % grid.roads) * grid.step;
+		const int offset = static_cast<int>((i * 7919) % grid.Size());
+		if(i % 2){
+			loots.emplace_back(i, 0, offset, road);
+		}else{
+			loots.emplace_back(i, 0, road, offset);
+		}
+	}
+
+	return loots;
+}
+
+}  // namespace fixtures
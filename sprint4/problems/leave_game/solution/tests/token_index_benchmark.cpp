@@ -0,0 +1,37 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include "../src/model.h"
+#include "../src/game_session.h"
+
+namespace {
+
+model::Game MakeGame(){
+	model::Game game;
+	model::Map map(model::Map::Id("map1"), "Map 1");
+	map.AddRoad(model::Road(model::Road::HORIZONTAL, model::Point(0, 0), 40));
+	game.AddMap(map);
+	return game;
+}
+
+}
+
+TEST_CASE("Token lookup cost stays flat as players count grows", "[benchmark]") {
+	for(size_t players_count : {100u, 1000u, 10000u}){
+		model::Game game = MakeGame();
+		std::string last_token;
+
+		for(size_t i = 0; i < players_count; ++i){
+			last_token = game.AddPlayer("map1", "dog" + std::to_string(i)).first;
+		}
+
+		auto handle = game.FindPlayerByToken(last_token);
+		REQUIRE(handle.has_value());
+		CHECK(handle->player->GetName() == "dog" + std::to_string(players_count - 1));
+		CHECK(!game.FindPlayerByToken("0123456789abcdef0123456789abcdef"));
+
+		BENCHMARK("FindPlayerByToken, players: " + std::to_string(players_count)) {
+			return game.FindPlayerByToken(last_token);
+		};
+	}
+}